@@ -2,8 +2,13 @@
 #include "board.h"
 #include "display.h"
 #include "system_info.h"
+#include "latency_tracker.h"
+#include "profiler.h"
+#include "sound_cache.h"
+#include "kernel_benchmark.h"
 #include "ml307_ssl_transport.h"
 #include "audio_codec.h"
+#include "pcm_kernels.h"
 #include "mqtt_protocol.h"
 #include "idiom_protocol.h"
 #include "websocket_protocol.h"
@@ -71,6 +76,19 @@ void Application::CheckNewVersion() {
 
     const int MAX_RETRY = 10;
     int retry_count = 0;
+    bool stage_upgrade = false;
+
+    // 上次的配置仍然有效时立即进入待机，版本检查在后台继续，服务器暂时不可用也不影响使用
+    bool ready = false;
+#if CONFIG_OTA_CONFIG_CACHE_TTL_HOURS > 0
+    if (ota_.LoadCachedConfig()) {
+        ESP_LOGI(TAG, "Using cached config, checking version in background");
+        SetDeviceState(kDeviceStateIdle);
+        display->SetChatMessage("system", "");
+        PlaySound(Lang::Sounds::P3_SUCCESS);
+        ready = true;
+    }
+#endif
 
     while (true) {
         if (!ota_.CheckVersion()) {
@@ -86,6 +104,10 @@ void Application::CheckNewVersion() {
         retry_count = 0;
 
         if (ota_.HasNewVersion()) {
+#if CONFIG_OTA_STAGED_UPGRADE
+            // 后台下载新固件，先让设备正常进入待机
+            stage_upgrade = true;
+#else
             Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE);
             // Wait for the chat state to be idle
             do {
@@ -109,10 +131,7 @@ void Application::CheckNewVersion() {
                 auto codec = board.GetAudioCodec();
                 codec->EnableInput(false);
                 codec->EnableOutput(false);
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_decode_queue_.clear();
-                }
+                audio_mixer_.ClearAll();
                 background_task_->WaitForCompletion();
                 delete background_task_;
                 background_task_ = nullptr;
@@ -132,14 +151,22 @@ void Application::CheckNewVersion() {
             });
 
             return;
+#endif
         }
 
-        // No new version, mark the current version as valid
+        // No new version (or it is staged in the background), mark the current version as valid
         ota_.MarkCurrentVersionValid();
         std::string message = std::string(Lang::Strings::VERSION) + ota_.GetCurrentVersion();
         display->ShowNotification(message.c_str());
     
         if (ota_.HasActivationCode()) {
+            // 缓存的配置已经失效，等当前的对话结束再显示激活码
+            if (ready) {
+                while (GetDeviceState() != kDeviceStateIdle) {
+                    vTaskDelay(pdMS_TO_TICKS(3000));
+                }
+                ready = false;
+            }
             // Activation code is valid
             SetDeviceState(kDeviceStateActivating);
             ShowActivationCode();
@@ -154,12 +181,89 @@ void Application::CheckNewVersion() {
             continue;
         }
 
-        SetDeviceState(kDeviceStateIdle);
-        display->SetChatMessage("system", "");
-        PlaySound(Lang::Sounds::P3_SUCCESS);
+        if (!ready) {
+            SetDeviceState(kDeviceStateIdle);
+            display->SetChatMessage("system", "");
+            PlaySound(Lang::Sounds::P3_SUCCESS);
+        }
         // Exit the loop if upgrade or idle
         break;
     }
+
+#if CONFIG_OTA_STAGED_UPGRADE
+    if (stage_upgrade) {
+        StageUpgrade();
+    }
+#endif
+}
+
+#if CONFIG_OTA_STAGED_UPGRADE
+// 在低优先级任务中限速下载新固件，音频通道打开时暂停，只有最后的校验和重启需要等待空闲
+void Application::StageUpgrade() {
+    vTaskPrioritySet(NULL, 1);
+    ota_.SetBandwidthLimit(CONFIG_OTA_STAGED_BANDWIDTH_KB * 1024);
+    ota_.SetPauseCallback([this]() {
+        return protocol_->IsAudioChannelOpened();
+    });
+    if (!ota_.StageUpgrade(nullptr)) {
+        ESP_LOGE(TAG, "Failed to stage the new firmware, will retry after reboot");
+        return;
+    }
+    ESP_LOGI(TAG, "New firmware %s is staged, waiting for idle", ota_.GetFirmwareVersion().c_str());
+
+    // 在主任务中确认仍然空闲再切换状态，避免和唤醒词同时改变状态
+    bool claimed = false;
+    auto done = xSemaphoreCreateBinary();
+    while (!claimed) {
+        vTaskDelay(pdMS_TO_TICKS(3000));
+        if (GetDeviceState() != kDeviceStateIdle) {
+            continue;
+        }
+        Schedule([this, &claimed, done]() {
+            if (device_state_ == kDeviceStateIdle && !protocol_->IsAudioChannelOpened()) {
+                SetDeviceState(kDeviceStateUpgrading);
+                claimed = true;
+            }
+            xSemaphoreGive(done);
+        });
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(done);
+
+    auto display = Board::GetInstance().GetDisplay();
+    display->SetIcon(FONT_AWESOME_DOWNLOAD);
+    std::string message = std::string(Lang::Strings::NEW_VERSION) + ota_.GetFirmwareVersion();
+    display->SetChatMessage("system", message.c_str());
+
+    // If upgrade success, the device will reboot and never return
+    ota_.ApplyUpgrade();
+    display->SetStatus(Lang::Strings::UPGRADE_FAILED);
+    ESP_LOGI(TAG, "Firmware upgrade failed...");
+    vTaskDelay(pdMS_TO_TICKS(3000));
+    SetDeviceState(kDeviceStateIdle);
+}
+#endif
+
+void Application::InitializeSoundCache(int output_sample_rate) {
+    auto& sound_cache = SoundCache::GetInstance();
+    sound_cache.Initialize(output_sample_rate, CONFIG_SOUND_CACHE_SIZE_KB * 1024);
+
+    // 只缓存经常播放的短音频，激活码播报会连续播放多个数字
+    const std::string_view sounds[] = {
+        Lang::Sounds::P3_0, Lang::Sounds::P3_1, Lang::Sounds::P3_2, Lang::Sounds::P3_3, Lang::Sounds::P3_4,
+        Lang::Sounds::P3_5, Lang::Sounds::P3_6, Lang::Sounds::P3_7, Lang::Sounds::P3_8, Lang::Sounds::P3_9,
+        Lang::Sounds::P3_SUCCESS, Lang::Sounds::P3_EXCLAMATION, Lang::Sounds::P3_VIBRATION,
+        Lang::Sounds::P3_LOW_BATTERY,
+    };
+    for (auto& sound : sounds) {
+        sound_cache.Allow(sound);
+    }
+
+    // 解码比播放慢不了多少，放在最低优先级的任务中，不影响启动和播放
+    xTaskCreate([](void* arg) {
+        SoundCache::GetInstance().Preload();
+        vTaskDelete(NULL);
+    }, "sound_preload", 4096 * 2, nullptr, 1, nullptr);
 }
 
 void Application::ShowActivationCode() {
@@ -168,7 +272,7 @@ void Application::ShowActivationCode() {
 
     struct digit_sound {
         char digit;
-        const std::string_view& sound;
+        Lang::Sound sound;
     };
     static const std::array<digit_sound, 10> digit_sounds{{
         digit_sound{'0', Lang::Sounds::P3_0},
@@ -183,16 +287,14 @@ void Application::ShowActivationCode() {
         digit_sound{'9', Lang::Sounds::P3_9}
     }};
 
-    // This sentence uses 9KB of SRAM, so we need to wait for it to finish
+    // 激活码的数字与提示语放在同一路，按顺序播放
     Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    background_task_->WaitForCompletion();
 
     for (const auto& digit : code) {
         auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
             [digit](const digit_sound& ds) { return ds.digit == digit; });
         if (it != digit_sounds.end()) {
-            PlaySound(it->sound);
+            PlaySound(it->sound, kAudioStreamAlert);
         }
     }
 }
@@ -204,7 +306,7 @@ void Application::Alert(const char* status, const char* message, const char* emo
     display->SetEmotion(emotion);
     display->SetChatMessage("system", message);
     if (!sound.empty()) {
-        PlaySound(sound);
+        PlaySound(sound, kAudioStreamAlert);
     }
 }
 
@@ -217,24 +319,13 @@ void Application::DismissAlert() {
     }
 }
 
-void Application::PlaySound(const std::string_view& sound) {
+void Application::PlaySound(const std::string_view& sound, AudioStreamType stream) {
     auto codec = Board::GetInstance().GetAudioCodec();
     codec->EnableOutput(true);
-    SetDecodeSampleRate(16000);
-    const char* data = sound.data();
-    size_t size = sound.size();
-    for (const char* p = data; p < data + size; ) {
-        auto p3 = (BinaryProtocol3*)p;
-        p += sizeof(BinaryProtocol3);
-
-        auto payload_size = ntohs(p3->payload_size);
-        std::vector<uint8_t> opus;
-        opus.resize(payload_size);
-        memcpy(opus.data(), p3->payload, payload_size);
-        p += payload_size;
-
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(opus));
+    // 提示音在独立的流中解码，不影响正在播放的 TTS
+    // 音频留在 flash 中，播放时逐包解码，占用的内存与音频长度无关
+    if (!audio_mixer_.PlaySound(stream, sound)) {
+        ESP_LOGE(TAG, "Failed to play sound");
     }
 }
 
@@ -252,7 +343,7 @@ void Application::ToggleChatState() {
     if (device_state_ == kDeviceStateIdle) {
         Schedule([this]() {
             SetDeviceState(kDeviceStateConnecting);
-            if (!protocol_->OpenAudioChannel()) {
+            if (!OpenAudioChannel()) {
                 return;
             }
 
@@ -287,7 +378,7 @@ void Application::StartListening() {
         Schedule([this]() {
             if (!protocol_->IsAudioChannelOpened()) {
                 SetDeviceState(kDeviceStateConnecting);
-                if (!protocol_->OpenAudioChannel()) {
+                if (!OpenAudioChannel()) {
                     return;
                 }
             }
@@ -307,22 +398,18 @@ void Application::StopListening() {
     Schedule([this]() {
         if (device_state_ == kDeviceStateListening) {
             protocol_->SendStopListening();
+            LatencyTracker::GetInstance().Mark(kLatencyMarkerListenStop);
             SetDeviceState(kDeviceStateIdle);
         }
     });
 }
 
-void Application::Start() {
+void Application::InitializeAudio() {
     auto& board = Board::GetInstance();
-    SetDeviceState(kDeviceStateStarting);
-
-    /* Setup the display */
-    auto display = board.GetDisplay();
-
-    /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
-    opus_decode_sample_rate_ = codec->output_sample_rate();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
+    audio_mixer_.Initialize(codec->output_sample_rate(), OPUS_FRAME_DURATION_MS);
+    InitializeSoundCache(codec->output_sample_rate());
+    SetDecodeSampleRate(codec->output_sample_rate());
     opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
     // For ML307 boards, we use complexity 5 to save bandwidth
     // For other boards, we use complexity 3 to save CPU
@@ -339,6 +426,9 @@ void Application::Start() {
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
     codec->OnInputReady([this, codec]() {
+        if (!input_started_) {
+            return false;
+        }
         BaseType_t higher_priority_task_woken = pdFALSE;
         xEventGroupSetBitsFromISR(event_group_, AUDIO_INPUT_READY_EVENT, &higher_priority_task_woken);
         return higher_priority_task_woken == pdTRUE;
@@ -356,27 +446,27 @@ void Application::Start() {
         app->MainLoop();
         vTaskDelete(NULL);
     }, "main_loop", 4096 * 2, this, 3, nullptr);
+}
 
-    /* Wait for the network to be ready */
-    board.StartNetwork();
-
-    // Initialize the protocol
+void Application::InitializeProtocol() {
+    auto& board = Board::GetInstance();
+    auto codec = board.GetAudioCodec();
+    auto display = board.GetDisplay();
     display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
 #ifdef CONFIG_CONNECTION_TYPE_WEBSOCKET
     protocol_ = std::make_unique<WebsocketProtocol>();
 #else
     protocol_ = std::make_unique<MqttProtocol>();
     idiom_protocol_ = std::make_unique<IdiomProtocol>();
-    camera_ = std::make_unique<Camera>();
 #endif
     protocol_->OnNetworkError([this](const std::string& message) {
         SetDeviceState(kDeviceStateIdle);
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
     });
-    protocol_->OnIncomingAudio([this](std::vector<uint8_t>&& data) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    protocol_->OnIncomingAudio([this](OpusPacket&& data) {
         if (device_state_ == kDeviceStateSpeaking) {
-            audio_decode_queue_.emplace_back(std::move(data));
+            LatencyTracker::GetInstance().MarkOnce(kLatencyMarkerFirstDownlink);
+            audio_mixer_.Push(kAudioStreamTts, std::move(data));
         }
     });
     protocol_->OnAudioChannelOpened([this, codec, &board]() {
@@ -392,6 +482,8 @@ void Application::Start() {
         if (thing_manager.GetStatesJson(states, false)) {
             protocol_->SendIotStates(states);
         }
+        // 上报之前会话累计的延迟统计
+        protocol_->SendLatency("histograms", LatencyTracker::GetInstance().GetHistogramsJson());
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveMode(true);
@@ -399,6 +491,11 @@ void Application::Start() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
+
+            auto& latency_tracker = LatencyTracker::GetInstance();
+            latency_tracker.Reset();
+            latency_tracker.PrintHistograms();
+            latency_tracker.Save();
         });
     });
     protocol_->OnIncomingJson([this, display](const cJSON* root) {
@@ -407,6 +504,7 @@ void Application::Start() {
         if (strcmp(type->valuestring, "tts") == 0) {
             auto state = cJSON_GetObjectItem(root, "state");
             if (strcmp(state->valuestring, "start") == 0) {
+                LatencyTracker::GetInstance().Mark(kLatencyMarkerTtsStart);
                 Schedule([this]() {
                     aborted_ = false;
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
@@ -414,9 +512,14 @@ void Application::Start() {
                     }
                 });
             } else if (strcmp(state->valuestring, "stop") == 0) {
+                LatencyTracker::GetInstance().Mark(kLatencyMarkerTtsStop);
                 Schedule([this]() {
                     if (device_state_ == kDeviceStateSpeaking) {
                         background_task_->WaitForCompletion();
+                        auto turn = LatencyTracker::GetInstance().FinishTurn();
+                        if (!turn.empty()) {
+                            protocol_->SendLatency("turn", turn);
+                        }
                         if (keep_listening_) {
                             protocol_->SendStartListening(kListeningModeAutoStop);
                             SetDeviceState(kDeviceStateListening);
@@ -437,6 +540,8 @@ void Application::Start() {
         } else if (strcmp(type->valuestring, "stt") == 0) {
             auto text = cJSON_GetObjectItem(root, "text");
             if (text != NULL) {
+                // 自动模式下由服务端判断说话结束，以识别结果到达的时间作为 listen stop
+                LatencyTracker::GetInstance().MarkOnce(kLatencyMarkerListenStop);
                 ESP_LOGI(TAG, ">> %s", text->valuestring);
                 Schedule([this, display, message = std::string(text->valuestring)]() {
                     display->SetChatMessage("user", message.c_str());
@@ -461,24 +566,13 @@ void Application::Start() {
         }
     });
     protocol_->Start();
+#ifndef CONFIG_CONNECTION_TYPE_WEBSOCKET
     idiom_protocol_->Start();
-    esp_err_t ret = camera_->init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Camera init failed");
-        return;
-    }
-    ESP_LOGI(TAG, "Camera and Webserver initialized successfully");
-
-    // Start webserver
-    ret = StartCameraWebServer();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Webserver start failed");
-        return;
-    }
-
-    
+#endif
+}
 
-    // Check for new firmware version or get the MQTT broker address
+void Application::StartVersionCheck() {
+    auto& board = Board::GetInstance();
     ota_.SetCheckVersionUrl(CONFIG_OTA_VERSION_URL);
     ota_.SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
     ota_.SetHeader("Client-Id", board.GetUuid());
@@ -491,13 +585,18 @@ void Application::Start() {
         app->CheckNewVersion();
         vTaskDelete(NULL);
     }, "check_new_version", 4096 * 2, this, 2, nullptr);
+}
 
+void Application::InitializeAudioProcessing() {
+    auto codec = Board::GetInstance().GetAudioCodec();
 #if CONFIG_USE_AUDIO_PROCESSOR
     audio_processor_.Initialize(codec->input_channels(), codec->input_reference());
     audio_processor_.OnOutput([this](std::vector<int16_t>&& data) {
         background_task_->Schedule([this, data = std::move(data)]() mutable {
+            // 编码器输出 std::vector，拷贝到 Opus 包池中再排队等待发送，编码器的缓冲区立即释放
             opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
+                Schedule([this, opus = OpusPacket(opus.begin(), opus.end())]() {
+                    LatencyTracker::GetInstance().MarkOnce(kLatencyMarkerFirstUplink);
                     protocol_->SendAudio(opus);
                 });
             });
@@ -522,19 +621,21 @@ void Application::Start() {
     });
 
     wake_word_detect_.OnWakeWordDetected([this](const std::string& wake_word) {
+        LatencyTracker::GetInstance().Mark(kLatencyMarkerWakeWord);
         Schedule([this, &wake_word]() {
             if (device_state_ == kDeviceStateIdle) {
                 SetDeviceState(kDeviceStateConnecting);
                 wake_word_detect_.EncodeWakeWordData();
 
-                if (!protocol_->OpenAudioChannel()) {
+                if (!OpenAudioChannel()) {
                     wake_word_detect_.StartDetection();
                     return;
                 }
                 
-                std::vector<uint8_t> opus;
+                OpusPacket opus;
                 // Encode and send the wake word data to the server
                 while (wake_word_detect_.GetWakeWordOpus(opus)) {
+                    LatencyTracker::GetInstance().MarkOnce(kLatencyMarkerFirstUplink);
                     protocol_->SendAudio(opus);
                 }
                 // Set the chat state to wake word detected
@@ -555,8 +656,71 @@ void Application::Start() {
     wake_word_detect_.StartDetection();
 #endif
 
+    // 采集周期与 AFE 的 feed chunk 对齐，没有 AFE 时与 Opus 帧长对齐，避免各级重新分块带来的延迟
+#if CONFIG_USE_WAKE_WORD_DETECT
+    codec->SetInputFrameDuration(wake_word_detect_.GetFeedSize() * 1000 / 16000);
+#elif CONFIG_USE_AUDIO_PROCESSOR
+    codec->SetInputFrameDuration(audio_processor_.GetFeedSize() * 1000 / 16000);
+#else
+    codec->SetInputFrameDuration(OPUS_FRAME_DURATION_MS);
+#endif
+    // 主循环在 audio 步骤中已经启动，AFE 就绪之后才开始送入麦克风数据
+    input_started_ = true;
+}
+
+void Application::Start() {
+    auto& board = Board::GetInstance();
+    SetDeviceState(kDeviceStateStarting);
+
+    // 启动步骤按依赖关系执行，音频初始化之后连接网络、加载 AFE 模型和初始化摄像头在各自的任务中并行执行
+    // 音频初始化之后主循环就开始播放，AFE 初始化完成之前不读取麦克风
+    // 网络启动失败时会播放提示音，所以等音频初始化完成后再开始
+    boot_sequence_.AddStep("audio", {}, [this]() {
+        InitializeAudio();
+    });
+    boot_sequence_.AddStep("network", {"audio"}, [&board]() {
+        board.StartNetwork();
+    }, 4096 * 2);
+    boot_sequence_.AddStep("afe", {"audio"}, [this]() {
+        InitializeAudioProcessing();
+    }, 4096 * 2);
+#ifndef CONFIG_CONNECTION_TYPE_WEBSOCKET
+    // 摄像头和 codec 共用 I2C 总线，等 codec 初始化完成后再初始化摄像头
+    boot_sequence_.AddStep("camera", {"audio"}, [this]() {
+        camera_ = std::make_unique<Camera>();
+        if (camera_->init() != ESP_OK) {
+            ESP_LOGE(TAG, "Camera init failed");
+        }
+    }, 4096 * 2);
+#endif
+    boot_sequence_.AddStep("protocol", {"network"}, [this]() {
+        InitializeProtocol();
+    });
+    // 没有摄像头时也启动 web 服务器，提供 /stats
+#ifndef CONFIG_CONNECTION_TYPE_WEBSOCKET
+    boot_sequence_.AddStep("webserver", {"camera", "network"}, [this]() {
+#else
+    boot_sequence_.AddStep("webserver", {"network"}, [this]() {
+#endif
+        if (StartWebServer() != ESP_OK) {
+            ESP_LOGE(TAG, "Webserver start failed");
+        }
+    });
+    // Check for new firmware version or get the MQTT broker address
+    boot_sequence_.AddStep("ota", {"protocol"}, [this]() {
+        StartVersionCheck();
+    });
+    boot_sequence_.Run();
+
     SetDeviceState(kDeviceStateIdle);
     esp_timer_start_periodic(clock_timer_handle_, 1000000);
+#if CONFIG_PROFILER_INTERVAL_SECONDS > 0
+    Profiler::GetInstance().StartPeriodic(CONFIG_PROFILER_INTERVAL_SECONDS);
+#endif
+    boot_sequence_.PrintTimeline();
+#if CONFIG_AUDIO_KERNEL_BENCHMARK
+    PrintKernelBenchmarks(RunKernelBenchmarks());
+#endif
 }
 
 void Application::OnClockTimer() {
@@ -564,7 +728,6 @@ void Application::OnClockTimer() {
 
     // Print the debug info every 10 seconds
     if (clock_ticks_ % 10 == 0) {
-        // SystemInfo::PrintRealTimeStats(pdMS_TO_TICKS(1000));
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
         ESP_LOGI(TAG, "Free internal: %u minimal internal: %u", free_sram, min_free_sram);
@@ -619,9 +782,8 @@ void Application::MainLoop() {
 }
 
 void Application::ResetDecoder() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
+    // 只清空 TTS，正在播放的提示音不受影响
+    audio_mixer_.Clear(kAudioStreamTts);
     last_output_time_ = std::chrono::steady_clock::now();
 }
 
@@ -630,8 +792,7 @@ void Application::OutputAudio() {
     auto codec = Board::GetInstance().GetAudioCodec();
     const int max_silence_seconds = 10;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty()) {
+    if (audio_mixer_.IsEmpty()) {
         // Disable the output if there is no audio data for a long time
         if (device_state_ == kDeviceStateIdle) {
             auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_output_time_).count();
@@ -643,63 +804,56 @@ void Application::OutputAudio() {
     }
 
     if (device_state_ == kDeviceStateListening) {
-        audio_decode_queue_.clear();
+        audio_mixer_.ClearAll();
         return;
     }
 
-    last_output_time_ = now;
-    auto opus = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    lock.unlock();
+    if (aborted_) {
+        audio_mixer_.Clear(kAudioStreamTts);
+    }
 
-    background_task_->Schedule([this, codec, opus = std::move(opus)]() mutable {
-        if (aborted_) {
-            return;
-        }
+    last_output_time_ = now;
+    // 同一时间只有一个混音任务，写入 codec 时阻塞，由播放速度控制解码节奏
+    if (mixing_.exchange(true)) {
+        return;
+    }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(opus), pcm)) {
-            return;
-        }
+    background_task_->Schedule([this, codec]() {
+        if (audio_mixer_.Mix(output_buffer_) > 0) {
+            codec->OutputData(output_buffer_);
 
-        // Resample if the sample rate is different
-        if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+            auto& latency_tracker = LatencyTracker::GetInstance();
+            if (latency_tracker.IsMarked(kLatencyMarkerFirstDownlink)) {
+                latency_tracker.MarkOnce(kLatencyMarkerFirstPlayback);
+            }
         }
-        
-        codec->OutputData(pcm);
+        mixing_ = false;
     });
 }
 
 void Application::InputAudio() {
     auto codec = Board::GetInstance().GetAudioCodec();
-    std::vector<int16_t> data;
+    // 每帧的数据从 PcmFramePool 分配，不在主循环中反复申请释放系统堆
+    PcmFrame data;
     if (!codec->InputData(data)) {
         return;
     }
 
     if (codec->input_sample_rate() != 16000) {
         if (codec->input_channels() == 2) {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2) {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2) {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
+            // 拆分和重采样的中间缓冲区常驻，避免每帧分配
+            size_t frames = data.size() / 2;
+            mic_channel_.resize(frames);
+            reference_channel_.resize(frames);
+            pcm::Deinterleave(data.data(), mic_channel_.data(), reference_channel_.data(), frames);
+            resampled_mic_.resize(input_resampler_.GetOutputSamples(frames));
+            resampled_reference_.resize(reference_resampler_.GetOutputSamples(frames));
+            input_resampler_.Process(mic_channel_.data(), frames, resampled_mic_.data());
+            reference_resampler_.Process(reference_channel_.data(), frames, resampled_reference_.data());
+            data.resize(resampled_mic_.size() * 2);
+            pcm::Interleave(resampled_mic_.data(), resampled_reference_.data(), data.data(), resampled_mic_.size());
         } else {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
+            PcmFrame resampled(input_resampler_.GetOutputSamples(data.size()));
             input_resampler_.Process(data.data(), data.size(), resampled.data());
             data = std::move(resampled);
         }
@@ -717,8 +871,10 @@ void Application::InputAudio() {
 #else
     if (device_state_ == kDeviceStateListening) {
         background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                Schedule([this, opus = std::move(opus)]() {
+            // 编码器的接口只接受 std::vector，在后台任务中拷贝一次
+            opus_encoder_->Encode(std::vector<int16_t>(data.begin(), data.end()), [this](std::vector<uint8_t>&& opus) {
+                Schedule([this, opus = OpusPacket(opus.begin(), opus.end())]() {
+                    LatencyTracker::GetInstance().MarkOnce(kLatencyMarkerFirstUplink);
                     protocol_->SendAudio(opus);
                 });
             });
@@ -727,6 +883,17 @@ void Application::InputAudio() {
 #endif
 }
 
+bool Application::OpenAudioChannel() {
+    auto& latency_tracker = LatencyTracker::GetInstance();
+    latency_tracker.Mark(kLatencyMarkerChannelOpenStart);
+    if (!protocol_->OpenAudioChannel()) {
+        latency_tracker.Reset();
+        return false;
+    }
+    latency_tracker.Mark(kLatencyMarkerChannelOpenEnd);
+    return true;
+}
+
 void Application::AbortSpeaking(AbortReason reason) {
     ESP_LOGI(TAG, "Abort speaking");
     aborted_ = true;
@@ -793,19 +960,8 @@ void Application::SetDeviceState(DeviceState state) {
 }
 
 void Application::SetDecodeSampleRate(int sample_rate) {
-    if (opus_decode_sample_rate_ == sample_rate) {
-        return;
-    }
-
-    opus_decode_sample_rate_ = sample_rate;
-    opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
-
-    auto codec = Board::GetInstance().GetAudioCodec();
-    if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-        ESP_LOGI(TAG, "Resampling audio from %d to %d", opus_decode_sample_rate_, codec->output_sample_rate());
-        output_resampler_.Configure(opus_decode_sample_rate_, codec->output_sample_rate());
-    }
+    // 只重建 TTS 流的解码器，提示音流固定为 16kHz
+    audio_mixer_.SetSampleRate(kAudioStreamTts, sample_rate);
 }
 
 void Application::UpdateIotStates() {
@@ -855,6 +1011,7 @@ bool Application::CanEnterSleepMode() {
     return true;
 }
 
+#ifndef CONFIG_CONNECTION_TYPE_WEBSOCKET
 // 定义一个静态成员函数作为回调函数
 static esp_err_t CaptureHandler(httpd_req_t *req) {
     Application *app = static_cast<Application *>(req->user_ctx);
@@ -868,8 +1025,15 @@ static esp_err_t CaptureHandler(httpd_req_t *req) {
 
     return ESP_FAIL;
 }
+#endif
+
+static esp_err_t StatsHandler(httpd_req_t *req) {
+    auto json = Profiler::GetInstance().GetJson();
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json.c_str(), json.size());
+}
 
-esp_err_t Application::StartCameraWebServer() {
+esp_err_t Application::StartWebServer() {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 
@@ -881,6 +1045,7 @@ esp_err_t Application::StartCameraWebServer() {
     }
 
     // Register URI handlers
+#ifndef CONFIG_CONNECTION_TYPE_WEBSOCKET
     httpd_uri_t capture_uri = {
         .uri       = "/capture",
         .method    = HTTP_GET,
@@ -889,6 +1054,15 @@ esp_err_t Application::StartCameraWebServer() {
     };
 
     httpd_register_uri_handler(server, &capture_uri);
+#endif
+
+    httpd_uri_t stats_uri = {
+        .uri       = "/stats",
+        .method    = HTTP_GET,
+        .handler   = StatsHandler,
+        .user_ctx  = nullptr
+    };
+    httpd_register_uri_handler(server, &stats_uri);
 
     return ESP_OK;
 }
\ No newline at end of file
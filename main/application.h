@@ -9,14 +9,17 @@
 #include <string>
 #include <mutex>
 #include <list>
+#include <atomic>
 
 #include <opus_encoder.h>
 #include <opus_decoder.h>
-#include <opus_resampler.h>
 
 #include "protocol.h"
 #include "ota.h"
 #include "background_task.h"
+#include "boot_sequence.h"
+#include "audio_resampler.h"
+#include "audio_mixer.h"
 
 #include "camera.h"
 
@@ -70,7 +73,7 @@ public:
     void UpdateIotStates();
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
-    void PlaySound(const std::string_view& sound);
+    void PlaySound(const std::string_view& sound, AudioStreamType stream = kAudioStreamUi);
     bool CanEnterSleepMode();
 
      Protocol* GetIdiomMqttProtocol() {
@@ -104,31 +107,48 @@ private:
     bool aborted_ = false;
     bool voice_detected_ = false;
     int clock_ticks_ = 0;
+    BootSequence boot_sequence_;
 
     // Audio encode / decode
     BackgroundTask* background_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
+    // 服务端 TTS、界面提示音和告警音各占一路，混音后输出
+    AudioMixer audio_mixer_;
+    pcm::AlignedVector<int16_t> output_buffer_;
+    std::atomic<bool> mixing_ = false;
+    // AFE 初始化完成、采集周期协商好之后才开始读取麦克风，在此之前只播放
+    std::atomic<bool> input_started_ = false;
 
     std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
 
     std::unique_ptr<Camera> camera_;
 
-    int opus_decode_sample_rate_ = -1;
-    OpusResampler input_resampler_;
-    OpusResampler reference_resampler_;
-    OpusResampler output_resampler_;
-
+    AudioResampler input_resampler_;
+    AudioResampler reference_resampler_;
+    // 16 字节对齐，拆分和交织可以使用 SIMD
+    pcm::AlignedVector<int16_t> mic_channel_;
+    pcm::AlignedVector<int16_t> reference_channel_;
+    pcm::AlignedVector<int16_t> resampled_mic_;
+    pcm::AlignedVector<int16_t> resampled_reference_;
+
+    void InitializeAudio();
+    void InitializeAudioProcessing();
+    void InitializeProtocol();
+    void StartVersionCheck();
     void MainLoop();
     void InputAudio();
     void OutputAudio();
+    bool OpenAudioChannel();
     void ResetDecoder();
     void SetDecodeSampleRate(int sample_rate);
     void CheckNewVersion();
+#if CONFIG_OTA_STAGED_UPGRADE
+    void StageUpgrade();
+#endif
     void ShowActivationCode();
+    void InitializeSoundCache(int output_sample_rate);
     void OnClockTimer();
-    esp_err_t StartCameraWebServer();
+    esp_err_t StartWebServer();
     //static esp_err_t CaptureHandler(httpd_req_t *req, void *context);
 };
 
@@ -0,0 +1,114 @@
+#include "assets_partition.h"
+#include "assets/lang_config.h"
+
+#include <esp_log.h>
+#include <cstring>
+
+#define TAG "AssetsPartition"
+
+// 编译进应用程序的提示音，与 main/CMakeLists.txt 中的 FALLBACK_SOUNDS 一致
+// 使用弱符号，当前语言没有的文件链接为空
+#define FALLBACK_SOUNDS(X) \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) \
+    X(activation) X(err_pin) X(err_reg) X(wificonfig) X(exclamation) X(low_battery)
+
+#define DECLARE_FALLBACK_SOUND(name) \
+    extern const char fallback_##name##_start[] asm("_binary_" #name "_p3_start") __attribute__((weak)); \
+    extern const char fallback_##name##_end[] asm("_binary_" #name "_p3_end") __attribute__((weak));
+FALLBACK_SOUNDS(DECLARE_FALLBACK_SOUND)
+
+struct FallbackSound {
+    const char* name;
+    const char* start;
+    const char* end;
+};
+
+#define FALLBACK_SOUND_ENTRY(name) {#name, fallback_##name##_start, fallback_##name##_end},
+static const FallbackSound kFallbackSounds[] = {
+    FALLBACK_SOUNDS(FALLBACK_SOUND_ENTRY)
+};
+
+AssetsPartition::AssetsPartition() {
+    if (!Load()) {
+        // 通过 OTA 从旧版本升级时分区表不会改变，需要用 USB 重新烧录一次，见 docs/assets.md
+        ESP_LOGE(TAG, "Sound assets are not available, please flash the partition table and assets partition");
+        LoadFallback();
+    }
+}
+
+AssetsPartition::~AssetsPartition() {
+    if (data_ != nullptr) {
+        esp_partition_munmap(mmap_handle_);
+    }
+}
+
+bool AssetsPartition::Load() {
+    auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "assets");
+    if (partition == nullptr) {
+        ESP_LOGE(TAG, "Assets partition not found");
+        return false;
+    }
+
+    AssetsHeader header;
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read header: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (memcmp(header.magic, ASSETS_MAGIC, 4) != 0 || header.version != ASSETS_VERSION) {
+        ESP_LOGE(TAG, "Invalid assets header");
+        return false;
+    }
+    if (header.total_size > partition->size ||
+        sizeof(header) + (uint64_t)header.count * sizeof(AssetsEntry) > header.total_size) {
+        ESP_LOGE(TAG, "Assets size %lu exceeds partition size %lu", header.total_size, (uint32_t)partition->size);
+        return false;
+    }
+
+    // 只映射实际使用的部分，节省 MMU 页
+    const void* mapped;
+    err = esp_partition_mmap(partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &mapped, &mmap_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mmap assets: %s", esp_err_to_name(err));
+        return false;
+    }
+    data_ = (const uint8_t*)mapped;
+
+    auto entries = (const AssetsEntry*)(data_ + sizeof(AssetsHeader));
+    for (uint32_t i = 0; i < header.count; i++) {
+        auto& entry = entries[i];
+        // 在 64 位上计算，offset + size 不会溢出绕回
+        if ((uint64_t)entry.offset + entry.size > header.total_size) {
+            ESP_LOGE(TAG, "Asset %.*s is out of range", ASSETS_NAME_LENGTH, entry.name);
+            continue;
+        }
+        std::string name(entry.name, strnlen(entry.name, ASSETS_NAME_LENGTH));
+        assets_[name] = std::string_view((const char*)data_ + entry.offset, entry.size);
+    }
+    ESP_LOGI(TAG, "Loaded %u assets, %lu bytes", assets_.size(), header.total_size);
+    return true;
+}
+
+// 只保留激活码、配网、错误和低电量等必要的提示音，其它音效为空
+void AssetsPartition::LoadFallback() {
+    assets_.clear();
+    for (auto& sound : kFallbackSounds) {
+        if (sound.start != nullptr && sound.end > sound.start) {
+            assets_[sound.name] = std::string_view(sound.start, sound.end - sound.start);
+        }
+    }
+    ESP_LOGW(TAG, "Using %u built-in fallback sounds", assets_.size());
+}
+
+std::string_view AssetsPartition::Get(std::string_view name) const {
+    auto it = assets_.find(name);
+    if (it == assets_.end()) {
+        ESP_LOGW(TAG, "Asset %.*s not found", (int)name.size(), name.data());
+        return std::string_view();
+    }
+    return it->second;
+}
+
+Lang::Sound::operator std::string_view() const {
+    return AssetsPartition::GetInstance().Get(name);
+}
@@ -0,0 +1,59 @@
+#ifndef _ASSETS_PARTITION_H_
+#define _ASSETS_PARTITION_H_
+
+#include <esp_partition.h>
+
+#include <map>
+#include <string>
+#include <string_view>
+
+// assets 分区格式，多字节字段均为小端，由 scripts/build_assets.py 生成
+//     AssetsHeader
+//     AssetsEntry entries[count]
+//     资源数据，每项按 4 字节对齐
+#define ASSETS_MAGIC "XZAS"
+#define ASSETS_VERSION 1
+#define ASSETS_NAME_LENGTH 32
+
+struct AssetsHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t total_size;    // 包括头部和目录的总大小
+} __attribute__((packed));
+
+struct AssetsEntry {
+    char name[ASSETS_NAME_LENGTH];
+    uint32_t offset;        // 相对分区起点的偏移
+    uint32_t size;
+} __attribute__((packed));
+
+// 音效等资源放在独立的 assets 分区，通过 mmap 直接访问，不占用应用程序镜像
+class AssetsPartition {
+public:
+    static AssetsPartition& GetInstance() {
+        static AssetsPartition instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    AssetsPartition(const AssetsPartition&) = delete;
+    AssetsPartition& operator=(const AssetsPartition&) = delete;
+
+    // assets 分区可用时返回 true，否则只有内置的少量提示音
+    bool IsValid() const { return data_ != nullptr; }
+    // 按名称查找资源，返回的数据一直有效，找不到时返回空
+    std::string_view Get(std::string_view name) const;
+
+private:
+    AssetsPartition();
+    ~AssetsPartition();
+
+    const uint8_t* data_ = nullptr;
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+    std::map<std::string, std::string_view, std::less<>> assets_;
+
+    bool Load();
+    void LoadFallback();
+};
+
+#endif // _ASSETS_PARTITION_H_
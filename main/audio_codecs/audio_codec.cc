@@ -22,17 +22,39 @@ void AudioCodec::OnOutputReady(std::function<bool()> callback) {
     on_output_ready_ = callback;
 }
 
-void AudioCodec::OutputData(std::vector<int16_t>& data) {
+void AudioCodec::OutputData(pcm::AlignedVector<int16_t>& data) {
+    output_level_.Update(data.data(), data.size(), 1);
     Write(data.data(), data.size());
 }
 
-bool AudioCodec::InputData(std::vector<int16_t>& data) {
-    int duration = 30;
-    int input_frame_size = input_sample_rate_ / 1000 * duration * input_channels_;
+void AudioCodec::SetInputFrameDuration(int duration_ms) {
+    if (duration_ms <= 0 || input_frame_duration_.exchange(duration_ms) == duration_ms) {
+        return;
+    }
+    ESP_LOGI(TAG, "Set input frame duration to %d ms", duration_ms);
+
+    // DMA 在创建通道时已经按默认周期划分，协商结果不是整数个 DMA 缓冲区时每次读取都要多等一部分
+    uint32_t dma_frames = GetDmaFrameNum(input_sample_rate_, AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS);
+    uint32_t frames = input_sample_rate_ * duration_ms / 1000;
+    if (frames % dma_frames != 0) {
+        ESP_LOGW(TAG, "Input frame duration %d ms is not a multiple of the DMA buffer (%lu frames), "
+            "update AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS", duration_ms, dma_frames);
+    }
+}
+
+uint32_t AudioCodec::GetDmaFrameNum(int sample_rate, int duration_ms) {
+    uint32_t frames = sample_rate * duration_ms / 1000;
+    uint32_t buffers = (frames + AUDIO_CODEC_DMA_MAX_FRAME_NUM - 1) / AUDIO_CODEC_DMA_MAX_FRAME_NUM;
+    return frames / buffers;
+}
+
+bool AudioCodec::InputData(PcmFrame& data) {
+    int input_frame_size = input_sample_rate_ * input_frame_duration_.load() / 1000 * input_channels_;
 
     data.resize(input_frame_size);
     int samples = Read(data.data(), data.size());
     if (samples > 0) {
+        input_level_.Update(data.data(), samples, input_channels_);
         return true;
     }
     return false;
@@ -77,7 +99,8 @@ void AudioCodec::Start() {
 void AudioCodec::SetOutputVolume(int volume) {
     output_volume_ = volume;
     ESP_LOGI(TAG, "Set output volume to %d", output_volume_);
-    
+    Board::GetInstance().GetDisplay()->SetMuted(output_volume_ == 0);
+
     Settings settings("audio", true);
     settings.SetInt("output_volume", output_volume_);
 }
@@ -8,8 +8,27 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <atomic>
 
 #include "board.h"
+#include "audio_level.h"
+#include "memory_pool.h"
+#include "pcm_kernels.h"
+
+// 默认采集周期：启用 AFE 时与其 feed chunk 对齐 (512 个采样 @ 16kHz = 32ms)，否则与 Opus 帧长对齐
+// I2S 通道创建以后不能再修改 DMA 缓冲区的大小，所以 DMA 按这个值划分，管线协商的结果应与它一致
+#if CONFIG_USE_WAKE_WORD_DETECT || CONFIG_USE_AUDIO_PROCESSOR
+#define AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS 32
+#else
+#define AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS 60
+#endif
+
+// 单个 DMA 缓冲区不能超过 4092 字节，按最坏情况 (32 位立体声) 计算最多 511 帧
+#define AUDIO_CODEC_DMA_MAX_FRAME_NUM 511
+// 把一个采集周期平均分成若干个 DMA 缓冲区，每次读取正好对应整数个缓冲区
+// 只用于播放的通道按输出采样率计算，双工通道的输入输出采样率相同
+#define AUDIO_CODEC_DMA_FRAME_NUM(sample_rate) \
+    AudioCodec::GetDmaFrameNum(sample_rate, AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS)
 
 class AudioCodec {
 public:
@@ -21,10 +40,15 @@ public:
     virtual void EnableOutput(bool enable);
 
     void Start();
-    void OutputData(std::vector<int16_t>& data);
-    bool InputData(std::vector<int16_t>& data);
+    void OutputData(pcm::AlignedVector<int16_t>& data);
+    bool InputData(PcmFrame& data);
     void OnOutputReady(std::function<bool()> callback);
     void OnInputReady(std::function<bool()> callback);
+    // 由音频管线协商采集周期，每次 InputData 读取一个周期的数据
+    // 可以在采集过程中从其他任务调用，下一次 InputData 开始生效
+    void SetInputFrameDuration(int duration_ms);
+
+    static uint32_t GetDmaFrameNum(int sample_rate, int duration_ms);
 
     inline bool duplex() const { return duplex_; }
     inline bool input_reference() const { return input_reference_; }
@@ -33,10 +57,16 @@ public:
     inline int input_channels() const { return input_channels_; }
     inline int output_channels() const { return output_channels_; }
     inline int output_volume() const { return output_volume_; }
+    inline int input_frame_duration() const { return input_frame_duration_; }
+    // 最近一帧播放（音量调节之前）和采集数据的电平
+    inline const AudioLevelMeter& output_level() const { return output_level_; }
+    inline const AudioLevelMeter& input_level() const { return input_level_; }
 
 private:
     std::function<bool()> on_input_ready_;
     std::function<bool()> on_output_ready_;
+    AudioLevelMeter input_level_;
+    AudioLevelMeter output_level_;
     
     IRAM_ATTR static bool on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
     IRAM_ATTR static bool on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx);
@@ -54,6 +84,7 @@ protected:
     int input_channels_ = 1;
     int output_channels_ = 1;
     int output_volume_ = 70;
+    std::atomic<int> input_frame_duration_ = AUDIO_CODEC_DEFAULT_INPUT_FRAME_DURATION_MS;
 
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
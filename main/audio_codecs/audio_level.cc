@@ -0,0 +1,37 @@
+#include "audio_level.h"
+#include "pcm_kernels.h"
+
+#include <esp_timer.h>
+#include <cmath>
+
+static inline uint32_t NowMs() {
+    return static_cast<uint32_t>(esp_timer_get_time() / 1000);
+}
+
+void AudioLevelMeter::Update(const int16_t* data, size_t samples, int channels) {
+    uint64_t sum_squares;
+    int32_t peak;
+    size_t count = pcm::SumSquaresAndPeak(data, samples, channels, &sum_squares, &peak);
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t rms = static_cast<uint32_t>(std::sqrt(static_cast<float>(sum_squares) / count));
+    if (rms > 32767) {
+        rms = 32767;
+    }
+    level_.store(rms | (static_cast<uint32_t>(peak) << 16), std::memory_order_relaxed);
+    updated_ms_.store(NowMs(), std::memory_order_release);
+}
+
+AudioLevel AudioLevelMeter::Get(int max_age_ms) const {
+    AudioLevel level;
+    uint32_t updated_ms = updated_ms_.load(std::memory_order_acquire);
+    if (updated_ms == 0 || NowMs() - updated_ms > static_cast<uint32_t>(max_age_ms)) {
+        return level;
+    }
+    uint32_t value = level_.load(std::memory_order_relaxed);
+    level.rms = value & 0xFFFF;
+    level.peak = value >> 16;
+    return level;
+}
@@ -0,0 +1,29 @@
+#ifndef _AUDIO_LEVEL_H_
+#define _AUDIO_LEVEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 超过这个时间没有新的数据时认为已经静音
+#define AUDIO_LEVEL_MAX_AGE_MS 200
+
+struct AudioLevel {
+    uint16_t rms = 0;       // 0-32767
+    uint16_t peak = 0;      // 0-32768
+};
+
+// 音频电平快照，音频线程每帧计算并发布一次，LED、屏幕等任意线程无锁读取
+class AudioLevelMeter {
+public:
+    // channels 为交织的声道数，只统计第一个声道
+    void Update(const int16_t* data, size_t samples, int channels);
+    AudioLevel Get(int max_age_ms = AUDIO_LEVEL_MAX_AGE_MS) const;
+
+private:
+    // 低 16 位为 rms，高 16 位为 peak，一次读写保证两者来自同一帧
+    std::atomic<uint32_t> level_ = 0;
+    std::atomic<uint32_t> updated_ms_ = 0;
+};
+
+#endif // _AUDIO_LEVEL_H_
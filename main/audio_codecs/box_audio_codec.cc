@@ -97,7 +97,7 @@ void BoxAudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = 6,
-        .dma_frame_num = 240,
+        .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM(input_sample_rate_),
         .auto_clear_after_cb = true,
         .auto_clear_before_cb = false,
         .intr_priority = 0,
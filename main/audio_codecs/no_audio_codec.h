@@ -6,8 +6,14 @@
 #include <driver/gpio.h>
 #include <driver/i2s_pdm.h>
 
+#include <vector>
+
 class NoAudioCodec : public AudioCodec {
 private:
+    // 读写分别在不同的任务中调用，各自使用一块常驻的 32 位缓冲区
+    pcm::AlignedVector<int32_t> write_buffer_;
+    pcm::AlignedVector<int32_t> read_buffer_;
+
     virtual int Write(const int16_t* data, int samples) override;
     virtual int Read(int16_t* dest, int samples) override;
 
@@ -0,0 +1,421 @@
+#include "pcm_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define PCM_KERNELS_USE_PIE 1
+#else
+#define PCM_KERNELS_USE_PIE 0
+#endif
+
+namespace pcm {
+
+static inline int16_t Saturate16(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    } else if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+#if PCM_KERNELS_USE_PIE
+static inline bool IsAligned16(const void* ptr) {
+    return (reinterpret_cast<uintptr_t>(ptr) & 15) == 0;
+}
+
+// 以下 PIE 函数都用 loopnez 实现循环，会改写 LBEG/LEND/LCOUNT 和 SAR，而 GCC 不知道内联汇编用到了这些寄存器。
+// 保持为独立的函数调用：按调用约定这几个寄存器不跨调用保存，GCC 也不会把包含函数调用的循环变成零开销循环
+// blocks 为 8 个采样一组的组数，所有指针都必须 16 字节对齐
+
+// (x * gain) >> 15，gain 不超过 32767 时不会溢出
+static __attribute__((noinline)) void ApplyGainQ15Pie(int16_t* data, size_t blocks, int16_t gain_q15) {
+    int32_t shift = 15;
+    asm volatile (
+        "wsr.sar %[shift]\n"
+        "ee.vldbc.16 q1, %[gain]\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[data], 0\n"
+        "ee.vmul.s16 q2, q0, q1\n"
+        "ee.vst.128.ip q2, %[data], 16\n"
+        "1:\n"
+        : [data] "+r"(data)
+        : [gain] "r"(&gain_q15), [blocks] "r"(blocks), [shift] "r"(shift)
+        : "memory");
+}
+
+// 16 位的 Q16 增益无法表示 1.0，增益为 65536 时乘以 1 且不移位，否则乘以 gain / 2 再右移 15 位
+static inline void GainQ16ToPie(int32_t gain_q16, int16_t* gain, int32_t* shift) {
+    if (gain_q16 >= 65536) {
+        *gain = 1;
+        *shift = 0;
+    } else {
+        *gain = (int16_t)(gain_q16 >> 1);
+        *shift = 15;
+    }
+}
+
+// y = (x * gain) >> shift，再与 0 交织得到 y << 16 的 32 位数据
+static __attribute__((noinline)) void Int16ToInt32Pie(const int16_t* src, int32_t* dst, size_t blocks, int16_t gain,
+    int32_t shift) {
+    asm volatile (
+        "wsr.sar %[shift]\n"
+        "ee.vldbc.16 q1, %[gain]\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vmul.s16 q0, q0, q1\n"
+        "ee.zero.q q2\n"
+        "ee.vzip.16 q2, q0\n"
+        "ee.vst.128.ip q2, %[dst], 16\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(dst)
+        : [gain] "r"(&gain), [blocks] "r"(blocks), [shift] "r"(shift)
+        : "memory");
+}
+
+// 同上，先把 y 与自身交织复制到左右声道
+static __attribute__((noinline)) void Int16ToInt32StereoPie(const int16_t* src, int32_t* dst, size_t blocks,
+    int16_t gain, int32_t shift) {
+    asm volatile (
+        "wsr.sar %[shift]\n"
+        "ee.vldbc.16 q1, %[gain]\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vmul.s16 q0, q0, q1\n"
+        "ee.orq q3, q0, q0\n"
+        "ee.vzip.16 q0, q3\n"
+        "ee.zero.q q2\n"
+        "ee.vzip.16 q2, q0\n"
+        "ee.vst.128.ip q2, %[dst], 16\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "ee.zero.q q2\n"
+        "ee.vzip.16 q2, q3\n"
+        "ee.vst.128.ip q2, %[dst], 16\n"
+        "ee.vst.128.ip q3, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(dst)
+        : [gain] "r"(&gain), [blocks] "r"(blocks), [shift] "r"(shift)
+        : "memory");
+}
+
+// 32 位算术右移、饱和到 16 位范围，再取每个 32 位数的低 16 位
+static __attribute__((noinline)) void Int32ToInt16Pie(const int32_t* src, int16_t* dst, size_t blocks, int32_t shift) {
+    static const int32_t min_value = INT16_MIN;
+    static const int32_t max_value = INT16_MAX;
+    asm volatile (
+        "wsr.sar %[shift]\n"
+        "ee.vldbc.32 q6, %[min]\n"
+        "ee.vldbc.32 q7, %[max]\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vld.128.ip q1, %[src], 16\n"
+        "ee.vsr.32 q0, q0\n"
+        "ee.vsr.32 q1, q1\n"
+        "ee.vmax.s32 q0, q0, q6\n"
+        "ee.vmin.s32 q0, q0, q7\n"
+        "ee.vmax.s32 q1, q1, q6\n"
+        "ee.vmin.s32 q1, q1, q7\n"
+        "ee.vunzip.16 q0, q1\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(dst)
+        : [min] "r"(&min_value), [max] "r"(&max_value), [blocks] "r"(blocks), [shift] "r"(shift)
+        : "memory");
+}
+
+static __attribute__((noinline)) void DeinterleavePie(const int16_t* src, int16_t* left, int16_t* right, size_t blocks) {
+    asm volatile (
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.vld.128.ip q1, %[src], 16\n"
+        "ee.vunzip.16 q0, q1\n"
+        "ee.vst.128.ip q0, %[left], 16\n"
+        "ee.vst.128.ip q1, %[right], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [left] "+r"(left), [right] "+r"(right)
+        : [blocks] "r"(blocks)
+        : "memory");
+}
+
+static __attribute__((noinline)) void InterleavePie(const int16_t* left, const int16_t* right, int16_t* dst, size_t blocks) {
+    asm volatile (
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[left], 16\n"
+        "ee.vld.128.ip q1, %[right], 16\n"
+        "ee.vzip.16 q0, q1\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "ee.vst.128.ip q1, %[dst], 16\n"
+        "1:\n"
+        : [left] "+r"(left), [right] "+r"(right), [dst] "+r"(dst)
+        : [blocks] "r"(blocks)
+        : "memory");
+}
+
+static __attribute__((noinline)) void MonoToStereoPie(const int16_t* src, int16_t* dst, size_t blocks) {
+    asm volatile (
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[src], 16\n"
+        "ee.orq q1, q0, q0\n"
+        "ee.vzip.16 q0, q1\n"
+        "ee.vst.128.ip q0, %[dst], 16\n"
+        "ee.vst.128.ip q1, %[dst], 16\n"
+        "1:\n"
+        : [src] "+r"(src), [dst] "+r"(dst)
+        : [blocks] "r"(blocks)
+        : "memory");
+}
+
+// 每次处理 8 个采样，平方和累加到 40 位的 ACCX，同时逐通道更新最大值和最小值
+// 满幅信号每块的平方和接近 2^33，blocks 不超过 LEVEL_PIE_MAX_BLOCKS 时 ACCX 不会溢出
+#define LEVEL_PIE_MAX_BLOCKS 32
+static __attribute__((noinline)) uint64_t SumSquaresPie(const int16_t* data, size_t blocks, int16_t* max8, int16_t* min8) {
+    uint32_t low, high;
+    asm volatile (
+        "ee.zero.accx\n"
+        "ee.vld.128.ip q1, %[max], 0\n"
+        "ee.vld.128.ip q2, %[min], 0\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[data], 16\n"
+        "ee.vmulas.s16.accx q0, q0\n"
+        "ee.vmax.s16 q1, q1, q0\n"
+        "ee.vmin.s16 q2, q2, q0\n"
+        "1:\n"
+        "ee.vst.128.ip q1, %[max], 0\n"
+        "ee.vst.128.ip q2, %[min], 0\n"
+        "rur.accx_0 %[low]\n"
+        "rur.accx_1 %[high]\n"
+        : [data] "+r"(data), [low] "=&r"(low), [high] "=&r"(high)
+        : [blocks] "r"(blocks), [max] "r"(max8), [min] "r"(min8)
+        : "memory");
+    return ((uint64_t)(high & 0xFF) << 32) | low;
+}
+#endif
+
+int32_t VolumeToGainQ16(int volume) {
+    if (volume <= 0) {
+        return 0;
+    } else if (volume >= 100) {
+        return 65536;
+    }
+    return volume * volume * 65536 / 10000;
+}
+
+namespace scalar {
+
+void ApplyGainQ15(int16_t* data, size_t samples, int32_t gain_q15) {
+    for (size_t i = 0; i < samples; i++) {
+        data[i] = Saturate16((data[i] * gain_q15) >> 15);
+    }
+}
+
+void Int16ToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16) {
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = src[i] * gain_q16;
+    }
+}
+
+void Int16ToInt32Stereo(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16) {
+    for (size_t i = 0; i < samples; i++) {
+        int32_t value = src[i] * gain_q16;
+        dst[i * 2] = value;
+        dst[i * 2 + 1] = value;
+    }
+}
+
+void Int32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift) {
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = Saturate16(src[i] >> shift);
+    }
+}
+
+// 以下函数一次读写一个 32 位字（左右两个 16 位采样），减少内存访问次数
+void Deinterleave(const int16_t* src, int16_t* left, int16_t* right, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        uint32_t word;
+        memcpy(&word, src + i * 2, sizeof(word));
+        left[i] = (int16_t)(word & 0xFFFF);
+        right[i] = (int16_t)(word >> 16);
+    }
+}
+
+void Interleave(const int16_t* left, const int16_t* right, int16_t* dst, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        uint32_t word = (uint16_t)left[i] | ((uint32_t)(uint16_t)right[i] << 16);
+        memcpy(dst + i * 2, &word, sizeof(word));
+    }
+}
+
+void MonoToStereo(const int16_t* src, int16_t* dst, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        uint32_t word = (uint16_t)src[i] * 0x00010001u;
+        memcpy(dst + i * 2, &word, sizeof(word));
+    }
+}
+
+size_t SumSquaresAndPeak(const int16_t* data, size_t samples, int channels, uint64_t* sum_squares, int32_t* peak) {
+    if (channels <= 0) {
+        channels = 1;
+    }
+    size_t count = samples / channels;
+    uint64_t sum = 0;
+    int32_t max_value = 0;
+    int32_t min_value = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = data[i * channels];
+        sum += value * value;
+        max_value = value > max_value ? value : max_value;
+        min_value = value < min_value ? value : min_value;
+    }
+    *sum_squares = sum;
+    *peak = max_value > -min_value ? max_value : -min_value;
+    return count;
+}
+
+} // namespace scalar
+
+void ApplyGainQ15(int16_t* data, size_t samples, int32_t gain_q15) {
+    if (gain_q15 == 32768) {
+        return;
+    }
+#if PCM_KERNELS_USE_PIE
+    if (gain_q15 >= 0 && gain_q15 < 32768 && IsAligned16(data) && samples >= 8) {
+        size_t blocks = samples / 8;
+        ApplyGainQ15Pie(data, blocks, (int16_t)gain_q15);
+        data += blocks * 8;
+        samples -= blocks * 8;
+    }
+#endif
+    scalar::ApplyGainQ15(data, samples, gain_q15);
+}
+
+void Int16ToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16) {
+#if PCM_KERNELS_USE_PIE
+    if (gain_q16 >= 0 && gain_q16 <= 65536 && IsAligned16(src) && IsAligned16(dst) && samples >= 8) {
+        int16_t gain;
+        int32_t shift;
+        GainQ16ToPie(gain_q16, &gain, &shift);
+        size_t blocks = samples / 8;
+        Int16ToInt32Pie(src, dst, blocks, gain, shift);
+        src += blocks * 8;
+        dst += blocks * 8;
+        samples -= blocks * 8;
+    }
+#endif
+    scalar::Int16ToInt32(src, dst, samples, gain_q16);
+}
+
+void Int16ToInt32Stereo(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16) {
+#if PCM_KERNELS_USE_PIE
+    if (gain_q16 >= 0 && gain_q16 <= 65536 && IsAligned16(src) && IsAligned16(dst) && samples >= 8) {
+        int16_t gain;
+        int32_t shift;
+        GainQ16ToPie(gain_q16, &gain, &shift);
+        size_t blocks = samples / 8;
+        Int16ToInt32StereoPie(src, dst, blocks, gain, shift);
+        src += blocks * 8;
+        dst += blocks * 16;
+        samples -= blocks * 8;
+    }
+#endif
+    scalar::Int16ToInt32Stereo(src, dst, samples, gain_q16);
+}
+
+void Int32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift) {
+#if PCM_KERNELS_USE_PIE
+    if (shift >= 0 && shift < 32 && IsAligned16(src) && IsAligned16(dst) && samples >= 8) {
+        size_t blocks = samples / 8;
+        Int32ToInt16Pie(src, dst, blocks, shift);
+        src += blocks * 8;
+        dst += blocks * 8;
+        samples -= blocks * 8;
+    }
+#endif
+    scalar::Int32ToInt16(src, dst, samples, shift);
+}
+
+void Deinterleave(const int16_t* src, int16_t* left, int16_t* right, size_t frames) {
+#if PCM_KERNELS_USE_PIE
+    if (IsAligned16(src) && IsAligned16(left) && IsAligned16(right) && frames >= 8) {
+        size_t blocks = frames / 8;
+        DeinterleavePie(src, left, right, blocks);
+        src += blocks * 16;
+        left += blocks * 8;
+        right += blocks * 8;
+        frames -= blocks * 8;
+    }
+#endif
+    scalar::Deinterleave(src, left, right, frames);
+}
+
+void Interleave(const int16_t* left, const int16_t* right, int16_t* dst, size_t frames) {
+#if PCM_KERNELS_USE_PIE
+    if (IsAligned16(left) && IsAligned16(right) && IsAligned16(dst) && frames >= 8) {
+        size_t blocks = frames / 8;
+        InterleavePie(left, right, dst, blocks);
+        left += blocks * 8;
+        right += blocks * 8;
+        dst += blocks * 16;
+        frames -= blocks * 8;
+    }
+#endif
+    scalar::Interleave(left, right, dst, frames);
+}
+
+void MonoToStereo(const int16_t* src, int16_t* dst, size_t samples) {
+#if PCM_KERNELS_USE_PIE
+    if (IsAligned16(src) && IsAligned16(dst) && samples >= 8) {
+        size_t blocks = samples / 8;
+        MonoToStereoPie(src, dst, blocks);
+        src += blocks * 8;
+        dst += blocks * 16;
+        samples -= blocks * 8;
+    }
+#endif
+    scalar::MonoToStereo(src, dst, samples);
+}
+
+size_t SumSquaresAndPeak(const int16_t* data, size_t samples, int channels, uint64_t* sum_squares, int32_t* peak) {
+#if PCM_KERNELS_USE_PIE
+    if (channels == 1 && samples >= 16) {
+        // 先用标量处理到 16 字节对齐，剩下不足一块的尾部最后再用标量处理
+        size_t head = 0;
+        while (!IsAligned16(data + head) && head < samples) {
+            head++;
+        }
+        uint64_t sum;
+        int32_t max_peak;
+        scalar::SumSquaresAndPeak(data, head, 1, &sum, &max_peak);
+
+        alignas(16) int16_t max8[8] = {};
+        alignas(16) int16_t min8[8] = {};
+        const int16_t* aligned = data + head;
+        size_t blocks = (samples - head) / 8;
+        size_t done = head + blocks * 8;
+        while (blocks > 0) {
+            size_t n = blocks < LEVEL_PIE_MAX_BLOCKS ? blocks : LEVEL_PIE_MAX_BLOCKS;
+            sum += SumSquaresPie(aligned, n, max8, min8);
+            aligned += n * 8;
+            blocks -= n;
+        }
+        for (int i = 0; i < 8; i++) {
+            max_peak = std::max<int32_t>(max_peak, std::max<int32_t>(max8[i], -min8[i]));
+        }
+
+        uint64_t tail_sum;
+        int32_t tail_peak;
+        scalar::SumSquaresAndPeak(data + done, samples - done, 1, &tail_sum, &tail_peak);
+        *sum_squares = sum + tail_sum;
+        *peak = std::max(max_peak, tail_peak);
+        return samples;
+    }
+#endif
+    return scalar::SumSquaresAndPeak(data, samples, channels, sum_squares, peak);
+}
+
+} // namespace pcm
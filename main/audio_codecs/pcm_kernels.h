@@ -0,0 +1,83 @@
+#ifndef _PCM_KERNELS_H_
+#define _PCM_KERNELS_H_
+
+#include <esp_heap_caps.h>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+// 编解码器驱动和音频管线共用的 PCM 处理函数
+// ESP32-S3 上所有指针都 16 字节对齐时使用 PIE SIMD 指令处理 8 个采样的整数倍，剩余部分和其它情况使用标量实现
+namespace pcm {
+
+// 音量 0-100 转换为 Q16 增益（按平方曲线，100 对应 65536）
+int32_t VolumeToGainQ16(int volume);
+
+// 原地乘以 Q15 增益并饱和，gain_q15 可以大于 32768 用于放大，但必须小于 65536，乘积才不会超出 32 位
+void ApplyGainQ15(int16_t* data, size_t samples, int32_t gain_q15);
+
+// 16 位转 32 位并乘以 Q16 增益，增益不超过 65536 时不会溢出
+// PIE 实现先在 16 位上乘以增益再扩展，增益小于 65536 时结果的低 16 位为 0，与标量实现相差不到 2 个 16 位 LSB
+void Int16ToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16);
+// 同上，并把单声道复制到左右两个声道，dst 需要 samples * 2 个元素
+void Int16ToInt32Stereo(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16);
+// 32 位算术右移 shift 位后饱和到 16 位
+void Int32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift);
+
+// 立体声交织数据拆分为左右声道，frames 为每个声道的采样数
+void Deinterleave(const int16_t* src, int16_t* left, int16_t* right, size_t frames);
+void Interleave(const int16_t* left, const int16_t* right, int16_t* dst, size_t frames);
+// 单声道复制为立体声，dst 需要 samples * 2 个元素
+void MonoToStereo(const int16_t* src, int16_t* dst, size_t samples);
+
+// 统计交织数据中第一个声道的平方和与峰值（绝对值），samples 为所有声道的采样总数
+// 返回统计的采样数，平方和用 64 位保存，不会溢出
+size_t SumSquaresAndPeak(const int16_t* data, size_t samples, int channels, uint64_t* sum_squares, int32_t* peak);
+
+// 标量实现，在所有芯片上可用，用于测试和性能对比
+namespace scalar {
+void ApplyGainQ15(int16_t* data, size_t samples, int32_t gain_q15);
+void Int16ToInt32(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16);
+void Int16ToInt32Stereo(const int16_t* src, int32_t* dst, size_t samples, int32_t gain_q16);
+void Int32ToInt16(const int32_t* src, int16_t* dst, size_t samples, int shift);
+void Deinterleave(const int16_t* src, int16_t* left, int16_t* right, size_t frames);
+void Interleave(const int16_t* left, const int16_t* right, int16_t* dst, size_t frames);
+void MonoToStereo(const int16_t* src, int16_t* dst, size_t samples);
+size_t SumSquaresAndPeak(const int16_t* data, size_t samples, int channels, uint64_t* sum_squares, int32_t* peak);
+} // namespace scalar
+
+// 16 字节对齐的分配器，常驻的中间缓冲区用它分配才能走 SIMD 路径
+template <typename T>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        void* ptr = heap_caps_aligned_alloc(16, n * sizeof(T), MALLOC_CAP_DEFAULT);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        heap_caps_free(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const noexcept { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace pcm
+
+#endif // _PCM_KERNELS_H_
@@ -0,0 +1,268 @@
+#include "audio_mixer.h"
+#include "pcm_kernels.h"
+#include "sound_cache.h"
+
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "AudioMixer"
+
+// 被压低的流保留的音量 (Q15)，约 -12dB
+#define DUCK_GAIN_Q15 8192
+// Opus 单包最长 120ms
+#define MAX_OPUS_PACKET_DURATION_MS 120
+
+AudioMixer::~AudioMixer() {
+    for (auto& stream : streams_) {
+        if (stream.decoder != nullptr) {
+            opus_decoder_destroy(stream.decoder);
+        }
+    }
+}
+
+void AudioMixer::Initialize(int output_sample_rate, int frame_duration_ms) {
+    std::lock_guard<std::mutex> decode_lock(decode_mutex_);
+    output_sample_rate_ = output_sample_rate;
+    frame_samples_ = output_sample_rate_ * frame_duration_ms / 1000;
+    mix_buffer_.reserve(frame_samples_);
+    for (auto& stream : streams_) {
+        if (stream.sample_rate != output_sample_rate_) {
+            stream.resampler.Configure(stream.sample_rate, output_sample_rate_);
+        }
+    }
+}
+
+void AudioMixer::SetSampleRate(AudioStreamType type, int sample_rate) {
+    std::lock_guard<std::mutex> decode_lock(decode_mutex_);
+    auto& stream = streams_[type];
+    if (stream.sample_rate == sample_rate) {
+        return;
+    }
+
+    // 解码器在下一次解码时按新的采样率创建
+    stream.sample_rate = sample_rate;
+    if (stream.decoder != nullptr) {
+        opus_decoder_destroy(stream.decoder);
+        stream.decoder = nullptr;
+    }
+    if (stream.sample_rate != output_sample_rate_) {
+        ESP_LOGI(TAG, "Stream %d resampling from %d to %d", type, stream.sample_rate, output_sample_rate_);
+        stream.resampler.Configure(stream.sample_rate, output_sample_rate_);
+    }
+}
+
+void AudioMixer::Push(AudioStreamType type, OpusPacket&& packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[type].packets.emplace_back(std::move(packet));
+}
+
+bool AudioMixer::PlaySound(AudioStreamType type, const std::string_view& sound) {
+    SoundSource source;
+    source.sound = sound;
+    source.reader = P3Reader(sound);
+    if (!source.reader.IsValid()) {
+        ESP_LOGE(TAG, "Invalid sound data, size %u", (unsigned)sound.size());
+        return false;
+    }
+    // Opus 可以按任意支持的采样率解码，v2 音频的采样率与流不同时由解码器转换
+    // 缓存还没有预加载完成时逐包解码，不在输出路径上解码整段音频
+    SoundCache::GetInstance().Lookup(sound, source.pcm, source.samples);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[type].sounds.emplace_back(std::move(source));
+    return true;
+}
+
+void AudioMixer::ResetStream(Stream& stream) {
+    stream.packets.clear();
+    stream.sounds.clear();
+    stream.pcm.clear();
+    stream.pcm_offset = 0;
+    if (stream.decoder != nullptr) {
+        opus_decoder_ctl(stream.decoder, OPUS_RESET_STATE);
+    }
+}
+
+void AudioMixer::Clear(AudioStreamType type) {
+    std::lock_guard<std::mutex> decode_lock(decode_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResetStream(streams_[type]);
+}
+
+void AudioMixer::ClearAll() {
+    std::lock_guard<std::mutex> decode_lock(decode_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stream : streams_) {
+        ResetStream(stream);
+    }
+}
+
+bool AudioMixer::IsEmpty(AudioStreamType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stream = streams_[type];
+    return stream.packets.empty() && stream.sounds.empty() && stream.pcm.size() == stream.pcm_offset;
+}
+
+bool AudioMixer::IsEmpty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stream : streams_) {
+        if (!stream.packets.empty() || !stream.sounds.empty() || stream.pcm.size() != stream.pcm_offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 丢掉已经混音的部分，调用时必须持有 mutex_，IsEmpty 会读取 pcm 的大小
+void AudioMixer::CompactPcm(Stream& stream) {
+    if (stream.pcm_offset > 0) {
+        stream.pcm.erase(stream.pcm.begin(), stream.pcm.begin() + stream.pcm_offset);
+        stream.pcm_offset = 0;
+    }
+}
+
+// 取下一个需要解码的包，遇到缓存中的音频时返回 false，由 FillFromCache 处理
+bool AudioMixer::NextPacket(Stream& stream, OpusPacket& holder, const uint8_t*& data, size_t& size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CompactPcm(stream);
+
+    if (!stream.packets.empty()) {
+        holder = std::move(stream.packets.front());
+        stream.packets.pop_front();
+        data = holder.data();
+        size = holder.size();
+        return true;
+    }
+
+    while (!stream.sounds.empty()) {
+        auto& source = stream.sounds.front();
+        if (source.pcm != nullptr) {
+            return false;
+        }
+        bool ok = source.reader.Next(data, size);
+        // data 指向原始音频，读完之后立即移除 source 也不影响本次解码
+        if (source.reader.IsEnd()) {
+            stream.sounds.pop_front();
+        }
+        if (ok) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 缓存命中的音频跳过解码和重采样，直接拷贝 PCM
+bool AudioMixer::FillFromCache(Stream& stream, size_t samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stream.packets.empty() || stream.sounds.empty()) {
+        return false;
+    }
+    auto source = &stream.sounds.front();
+    if (source->pcm == nullptr) {
+        return false;
+    }
+
+    CompactPcm(stream);
+    size_t count = std::min(samples - stream.pcm.size(), source->samples - source->offset);
+    stream.pcm.insert(stream.pcm.end(), source->pcm + source->offset, source->pcm + source->offset + count);
+    source->offset += count;
+    if (source->offset >= source->samples) {
+        stream.sounds.pop_front();
+    }
+    return true;
+}
+
+size_t AudioMixer::FillStream(Stream& stream, size_t samples) {
+    while (stream.pcm.size() - stream.pcm_offset < samples) {
+        if (FillFromCache(stream, samples)) {
+            continue;
+        }
+
+        OpusPacket holder;
+        const uint8_t* data;
+        size_t size;
+        if (!NextPacket(stream, holder, data, size)) {
+            // 队首是缓存中的音频时回到循环开头处理
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stream.sounds.empty()) {
+                break;
+            }
+            continue;
+        }
+
+        if (stream.decoder == nullptr) {
+            int error;
+            stream.decoder = opus_decoder_create(stream.sample_rate, 1, &error);
+            if (stream.decoder == nullptr) {
+                ESP_LOGE(TAG, "Failed to create decoder: %d", error);
+                break;
+            }
+        }
+        decode_buffer_.resize(stream.sample_rate * MAX_OPUS_PACKET_DURATION_MS / 1000);
+        int decoded = opus_decode(stream.decoder, data, size, decode_buffer_.data(), decode_buffer_.size(), 0);
+        if (decoded <= 0) {
+            ESP_LOGW(TAG, "Failed to decode audio: %d", decoded);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t old_size = stream.pcm.size();
+        if (stream.sample_rate != output_sample_rate_) {
+            stream.pcm.resize(old_size + stream.resampler.GetOutputSamples(decoded));
+            stream.resampler.Process(decode_buffer_.data(), decoded, stream.pcm.data() + old_size);
+        } else {
+            stream.pcm.insert(stream.pcm.end(), decode_buffer_.begin(), decode_buffer_.begin() + decoded);
+        }
+    }
+    return std::min(stream.pcm.size() - stream.pcm_offset, samples);
+}
+
+int AudioMixer::Mix(pcm::AlignedVector<int16_t>& output) {
+    std::lock_guard<std::mutex> decode_lock(decode_mutex_);
+
+    size_t available[kAudioStreamCount];
+    size_t samples = 0;
+    for (int i = 0; i < kAudioStreamCount; i++) {
+        available[i] = FillStream(streams_[i], frame_samples_);
+        samples = std::max(samples, available[i]);
+    }
+    if (samples == 0) {
+        return 0;
+    }
+
+    // 数据不足一帧的流后面补静音，从高优先级往低优先级混音
+    mix_buffer_.assign(samples, 0);
+    bool higher_priority_active = false;
+    for (int i = kAudioStreamCount - 1; i >= 0; i--) {
+        auto& stream = streams_[i];
+        int32_t target_gain = higher_priority_active ? DUCK_GAIN_Q15 : 32768;
+        size_t count = available[i];
+        if (count > 0) {
+            int16_t* src = stream.pcm.data() + stream.pcm_offset;
+            if (stream.gain_q15 == target_gain) {
+                // 这部分数据混音后就被丢弃，可以原地乘以增益
+                pcm::ApplyGainQ15(src, count, target_gain);
+                for (size_t j = 0; j < count; j++) {
+                    mix_buffer_[j] += src[j];
+                }
+            } else {
+                // 增益在一帧内线性过渡，避免突变产生咔哒声
+                int32_t gain_q23 = stream.gain_q15 << 8;
+                int32_t step_q23 = ((target_gain - stream.gain_q15) << 8) / (int32_t)count;
+                for (size_t j = 0; j < count; j++) {
+                    mix_buffer_[j] += (src[j] * (gain_q23 >> 8)) >> 15;
+                    gain_q23 += step_q23;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            stream.pcm_offset += count;
+            higher_priority_active = true;
+        }
+        stream.gain_q15 = target_gain;
+    }
+
+    output.resize(samples);
+    pcm::Int32ToInt16(mix_buffer_.data(), output.data(), samples, 0);
+    return samples;
+}
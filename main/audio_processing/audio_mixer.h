@@ -0,0 +1,89 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <opus.h>
+
+#include <list>
+#include <mutex>
+#include <vector>
+#include <string_view>
+
+#include "audio_resampler.h"
+#include "memory_pool.h"
+#include "pcm_kernels.h"
+#include "p3_reader.h"
+
+// 输出流按优先级从低到高排列，高优先级的流有数据时压低所有低优先级的流
+enum AudioStreamType {
+    kAudioStreamTts,
+    kAudioStreamUi,
+    kAudioStreamAlert,
+    kAudioStreamCount
+};
+
+// 多路输出混音器
+// 每一路有独立的 Opus 解码器、采样率和重采样器，定点混音后输出到同一个 codec
+class AudioMixer {
+public:
+    AudioMixer() = default;
+    ~AudioMixer();
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+
+    void Initialize(int output_sample_rate, int frame_duration_ms);
+    // 只重建该路的解码器，其它路的播放不受影响
+    void SetSampleRate(AudioStreamType type, int sample_rate);
+    void Push(AudioStreamType type, OpusPacket&& packet);
+    // 播放 P3 音频 (v1 或 v2)，sound 必须一直有效（例如 flash 中的资源）
+    // 混音时才逐包读取，直接从原始数据解码，不拷贝整段音频
+    // 已经在 SoundCache 中的音频直接使用缓存的 PCM
+    bool PlaySound(AudioStreamType type, const std::string_view& sound);
+    void Clear(AudioStreamType type);
+    void ClearAll();
+    bool IsEmpty();
+    bool IsEmpty(AudioStreamType type);
+
+    // 解码并混合最多一帧数据，返回输出的采样数，0 表示所有流都没有数据
+    int Mix(pcm::AlignedVector<int16_t>& output);
+
+private:
+    struct SoundSource {
+        std::string_view sound;
+        P3Reader reader;
+        // 缓存中输出采样率的 PCM，为空时从 reader 逐包解码
+        const int16_t* pcm = nullptr;
+        size_t samples = 0;
+        size_t offset = 0;
+    };
+
+    struct Stream {
+        int sample_rate = 16000;
+        OpusDecoder* decoder = nullptr;
+        AudioResampler resampler;
+        // 先播放网络数据包，再播放 P3 音频
+        std::list<OpusPacket> packets;
+        std::list<SoundSource> sounds;
+        // 已经解码并转换到输出采样率、尚未混音的数据
+        pcm::AlignedVector<int16_t> pcm;
+        size_t pcm_offset = 0;
+        int32_t gain_q15 = 32768;
+    };
+
+    // mutex_ 保护数据包队列，decode_mutex_ 保护解码器和 PCM 缓冲区
+    // 需要同时持有时先锁 decode_mutex_
+    std::mutex mutex_;
+    std::mutex decode_mutex_;
+    Stream streams_[kAudioStreamCount];
+    int output_sample_rate_ = 16000;
+    size_t frame_samples_ = 960;
+    pcm::AlignedVector<int32_t> mix_buffer_;
+    std::vector<int16_t> decode_buffer_;
+
+    void CompactPcm(Stream& stream);
+    bool NextPacket(Stream& stream, OpusPacket& holder, const uint8_t*& data, size_t& size);
+    bool FillFromCache(Stream& stream, size_t samples);
+    size_t FillStream(Stream& stream, size_t samples);
+    void ResetStream(Stream& stream);
+};
+
+#endif
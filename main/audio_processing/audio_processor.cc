@@ -63,10 +63,22 @@ AudioProcessor::~AudioProcessor() {
     vEventGroupDelete(event_group_);
 }
 
-void AudioProcessor::Input(const std::vector<int16_t>& data) {
-    input_buffer_.insert(input_buffer_.end(), data.begin(), data.end());
+int AudioProcessor::GetFeedSize() {
+    return esp_afe_vc_v1.get_feed_chunksize(afe_communication_data_);
+}
 
+void AudioProcessor::Input(const PcmFrame& data) {
     auto feed_size = esp_afe_vc_v1.get_feed_chunksize(afe_communication_data_) * channels_;
+    // 采集周期与 feed chunk 对齐时直接送入 AFE，不经过缓冲区
+    size_t offset = 0;
+    if (input_buffer_.empty()) {
+        while (data.size() - offset >= feed_size) {
+            esp_afe_vc_v1.feed(afe_communication_data_, data.data() + offset);
+            offset += feed_size;
+        }
+    }
+    input_buffer_.insert(input_buffer_.end(), data.begin() + offset, data.end());
+
     while (input_buffer_.size() >= feed_size) {
         auto chunk = input_buffer_.data();
         esp_afe_vc_v1.feed(afe_communication_data_, chunk);
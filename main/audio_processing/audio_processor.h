@@ -10,13 +10,17 @@
 #include <vector>
 #include <functional>
 
+#include "memory_pool.h"
+
 class AudioProcessor {
 public:
     AudioProcessor();
     ~AudioProcessor();
 
     void Initialize(int channels, bool reference);
-    void Input(const std::vector<int16_t>& data);
+    void Input(const PcmFrame& data);
+    // 每个声道每次 feed 的采样数 (16kHz)
+    int GetFeedSize();
     void Start();
     void Stop();
     bool IsRunning();
@@ -0,0 +1,29 @@
+#include "audio_resampler.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioResampler"
+
+void AudioResampler::Configure(int input_sample_rate, int output_sample_rate) {
+    use_polyphase_ = polyphase_resampler_.Configure(input_sample_rate, output_sample_rate);
+    if (!use_polyphase_) {
+        opus_resampler_.Configure(input_sample_rate, output_sample_rate);
+    }
+    ESP_LOGI(TAG, "Resampler %d -> %d using %s", input_sample_rate, output_sample_rate,
+        use_polyphase_ ? "polyphase FIR" : "opus");
+}
+
+void AudioResampler::Process(const int16_t* input, int input_samples, int16_t* output) {
+    if (use_polyphase_) {
+        polyphase_resampler_.Process(input, input_samples, output);
+    } else {
+        opus_resampler_.Process(input, input_samples, output);
+    }
+}
+
+int AudioResampler::GetOutputSamples(int input_samples) {
+    if (use_polyphase_) {
+        return polyphase_resampler_.GetOutputSamples(input_samples);
+    }
+    return opus_resampler_.GetOutputSamples(input_samples);
+}
@@ -0,0 +1,21 @@
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <opus_resampler.h>
+
+#include "polyphase_resampler.h"
+
+// 常用的采样率转换使用多相 FIR 重采样器，其它情况退回 Opus SILK 重采样器
+class AudioResampler {
+public:
+    void Configure(int input_sample_rate, int output_sample_rate);
+    void Process(const int16_t* input, int input_samples, int16_t* output);
+    int GetOutputSamples(int input_samples);
+
+private:
+    bool use_polyphase_ = false;
+    PolyphaseResampler polyphase_resampler_;
+    OpusResampler opus_resampler_;
+};
+
+#endif
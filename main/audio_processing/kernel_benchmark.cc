@@ -0,0 +1,171 @@
+#include "kernel_benchmark.h"
+#include "polyphase_resampler.h"
+#include "pcm_kernels.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+#define TAG "KernelBenchmark"
+
+// 每个内核重复运行的次数，取平均值
+#define BENCHMARK_ITERATIONS 50
+// 每次处理 60ms 的数据，与采集和播放的帧长一致
+#define BENCHMARK_FRAME_MS 60
+
+static float MeasureUs(const std::function<void()>& run) {
+    // 先运行一次，让数据和代码进入缓存
+    run();
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        run();
+    }
+    return (float)(esp_timer_get_time() - start) / BENCHMARK_ITERATIONS;
+}
+
+static pcm::AlignedVector<int16_t> MakeTone(int sample_rate, int samples) {
+    pcm::AlignedVector<int16_t> tone(samples);
+    for (int i = 0; i < samples; i++) {
+        tone[i] = (int16_t)(16000 * std::sin(2 * M_PI * 1000 * i / sample_rate));
+    }
+    return tone;
+}
+
+static KernelBenchmarkResult BenchmarkResampler(int input_sample_rate, int output_sample_rate) {
+    PolyphaseResampler resampler;
+    resampler.Configure(input_sample_rate, output_sample_rate);
+    auto input = MakeTone(input_sample_rate, input_sample_rate * BENCHMARK_FRAME_MS / 1000);
+    std::vector<int16_t> output(resampler.GetOutputSamples(input.size()) + 1);
+    auto run = [&]() {
+        resampler.Process(input.data(), input.size(), output.data());
+    };
+
+    KernelBenchmarkResult result;
+    result.name = "resample " + std::to_string(input_sample_rate / 1000) + "k->" +
+        std::to_string(output_sample_rate / 1000) + "k";
+    bool simd = resampler.simd_enabled();
+    result.simd_us = simd ? MeasureUs(run) : 0;
+    auto simd_output = output;
+
+    resampler.EnableSimd(false);
+    resampler.Reset();
+    result.scalar_us = MeasureUs(run);
+    // 两种实现使用同样的系数和累加方式，结果应该完全一致
+    result.matches = !simd || simd_output == output;
+    return result;
+}
+
+// simd 和 scalar 处理同样的输入，输出分别写入各自的缓冲区，compare 比较两者的输出
+static KernelBenchmarkResult BenchmarkPcm(const char* name, const std::function<void()>& simd,
+    const std::function<void()>& scalar, const std::function<bool()>& compare) {
+    KernelBenchmarkResult result;
+    result.name = name;
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    result.simd_us = MeasureUs(simd);
+#else
+    // 没有 SIMD 时公开接口就是标量实现，只运行一次用于比较输出
+    simd();
+    result.simd_us = 0;
+#endif
+    result.scalar_us = MeasureUs(scalar);
+    result.matches = compare();
+    return result;
+}
+
+template <typename T>
+static bool Equal(const pcm::AlignedVector<T>& a, const pcm::AlignedVector<T>& b) {
+    return a == b;
+}
+
+static void BenchmarkPcmKernels(std::vector<KernelBenchmarkResult>& results) {
+    // 16kHz 单声道一帧，立体声的数据为两倍
+    const size_t samples = 16000 * BENCHMARK_FRAME_MS / 1000;
+    auto mono = MakeTone(16000, samples);
+    auto stereo = MakeTone(16000, samples * 2);
+    pcm::AlignedVector<int16_t> out16_a(samples * 2), out16_b(samples * 2);
+    pcm::AlignedVector<int16_t> left_a(samples), left_b(samples);
+    pcm::AlignedVector<int32_t> out32_a(samples * 2), out32_b(samples * 2);
+    pcm::AlignedVector<int32_t> in32(samples);
+    for (size_t i = 0; i < samples; i++) {
+        in32[i] = mono[i] << 14;
+    }
+    const int32_t gain_q16 = pcm::VolumeToGainQ16(70);
+
+    results.push_back(BenchmarkPcm("gain q15",
+        [&]() { out16_a.assign(mono.begin(), mono.end()); pcm::ApplyGainQ15(out16_a.data(), samples, 20000); },
+        [&]() { out16_b.assign(mono.begin(), mono.end()); pcm::scalar::ApplyGainQ15(out16_b.data(), samples, 20000); },
+        [&]() { return Equal(out16_a, out16_b); }));
+
+    // PIE 先在 16 位上乘以增益，允许相差不到 2 个 16 位 LSB
+    auto close32 = [&](size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (std::abs(out32_a[i] - out32_b[i]) >= 2 * 65536) {
+                return false;
+            }
+        }
+        return true;
+    };
+    results.push_back(BenchmarkPcm("int16->int32",
+        [&]() { pcm::Int16ToInt32(mono.data(), out32_a.data(), samples, gain_q16); },
+        [&]() { pcm::scalar::Int16ToInt32(mono.data(), out32_b.data(), samples, gain_q16); },
+        [&]() { return close32(samples); }));
+    results.push_back(BenchmarkPcm("int16->int32 stereo",
+        [&]() { pcm::Int16ToInt32Stereo(mono.data(), out32_a.data(), samples, gain_q16); },
+        [&]() { pcm::scalar::Int16ToInt32Stereo(mono.data(), out32_b.data(), samples, gain_q16); },
+        [&]() { return close32(samples * 2); }));
+    results.push_back(BenchmarkPcm("int32->int16",
+        [&]() { pcm::Int32ToInt16(in32.data(), out16_a.data(), samples, 12); },
+        [&]() { pcm::scalar::Int32ToInt16(in32.data(), out16_b.data(), samples, 12); },
+        [&]() { return Equal(out16_a, out16_b); }));
+    results.push_back(BenchmarkPcm("deinterleave",
+        [&]() { pcm::Deinterleave(stereo.data(), left_a.data(), out16_a.data(), samples); },
+        [&]() { pcm::scalar::Deinterleave(stereo.data(), left_b.data(), out16_b.data(), samples); },
+        [&]() { return Equal(left_a, left_b) && Equal(out16_a, out16_b); }));
+    results.push_back(BenchmarkPcm("interleave",
+        [&]() { pcm::Interleave(mono.data(), left_a.data(), out16_a.data(), samples); },
+        [&]() { pcm::scalar::Interleave(mono.data(), left_a.data(), out16_b.data(), samples); },
+        [&]() { return Equal(out16_a, out16_b); }));
+    results.push_back(BenchmarkPcm("mono->stereo",
+        [&]() { pcm::MonoToStereo(mono.data(), out16_a.data(), samples); },
+        [&]() { pcm::scalar::MonoToStereo(mono.data(), out16_b.data(), samples); },
+        [&]() { return Equal(out16_a, out16_b); }));
+
+    uint64_t sum_a = 0, sum_b = 0;
+    int32_t peak_a = 0, peak_b = 0;
+    results.push_back(BenchmarkPcm("level",
+        [&]() { pcm::SumSquaresAndPeak(mono.data(), samples, 1, &sum_a, &peak_a); },
+        [&]() { pcm::scalar::SumSquaresAndPeak(mono.data(), samples, 1, &sum_b, &peak_b); },
+        [&]() { return sum_a == sum_b && peak_a == peak_b; }));
+}
+
+std::vector<KernelBenchmarkResult> RunKernelBenchmarks() {
+    std::vector<KernelBenchmarkResult> results;
+    results.push_back(BenchmarkResampler(16000, 24000));
+    results.push_back(BenchmarkResampler(16000, 48000));
+    results.push_back(BenchmarkResampler(24000, 16000));
+    results.push_back(BenchmarkResampler(48000, 16000));
+    BenchmarkPcmKernels(results);
+    return results;
+}
+
+void PrintKernelBenchmarks(const std::vector<KernelBenchmarkResult>& results) {
+    ESP_LOGI(TAG, "Per %d ms frame, average of %d runs:", BENCHMARK_FRAME_MS, BENCHMARK_ITERATIONS);
+    for (auto& result : results) {
+        if (!result.matches) {
+            ESP_LOGE(TAG, "%-20s SIMD output differs from scalar", result.name.c_str());
+        }
+        if (result.simd_us > 0) {
+            ESP_LOGI(TAG, "%-20s scalar %8.1f us  simd %8.1f us  x%.2f", result.name.c_str(),
+                result.scalar_us, result.simd_us, result.scalar_us / result.simd_us);
+        } else {
+            ESP_LOGI(TAG, "%-20s scalar %8.1f us", result.name.c_str(), result.scalar_us);
+        }
+    }
+}
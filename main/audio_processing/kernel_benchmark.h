@@ -0,0 +1,21 @@
+#ifndef _KERNEL_BENCHMARK_H_
+#define _KERNEL_BENCHMARK_H_
+
+#include <string>
+#include <vector>
+
+struct KernelBenchmarkResult {
+    std::string name;
+    // 每次调用的平均耗时（微秒），simd_us 为 0 表示当前芯片上没有 SIMD 实现
+    float scalar_us;
+    float simd_us;
+    // SIMD 的输出与标量实现一致（允许的误差见各个内核的说明）
+    bool matches;
+};
+
+// 测量音频热路径上的内核处理一帧数据的耗时，并比较 SIMD 和标量实现的耗时和输出
+// 设备上打开 CONFIG_AUDIO_KERNEL_BENCHMARK 后启动完成时运行一次，主机上由 tests/host 的 host_benchmarks 运行
+std::vector<KernelBenchmarkResult> RunKernelBenchmarks();
+void PrintKernelBenchmarks(const std::vector<KernelBenchmarkResult>& results);
+
+#endif // _KERNEL_BENCHMARK_H_
@@ -0,0 +1,165 @@
+#include "p3_reader.h"
+
+#include <esp_log.h>
+#include <cstring>
+
+#define TAG "P3Reader"
+
+#define P3_V1_HEADER_SIZE 4
+// Opus 单包最长 120ms
+#define P3_MAX_FRAME_DURATION_MS 120
+
+static bool IsOpusSampleRate(uint32_t sample_rate) {
+    return sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 ||
+        sample_rate == 24000 || sample_rate == 48000;
+}
+
+P3Reader::P3Reader(const std::string_view& data)
+    : data_(reinterpret_cast<const uint8_t*>(data.data())), size_(data.size()) {
+    if (size_ >= sizeof(P3v2Header) && memcmp(data_, P3_V2_MAGIC, 4) == 0) {
+        if (!ParseV2Header()) {
+            size_ = 0;
+        }
+    } else if (size_ > 0) {
+        // v1 的第一个字节是包类型 0，不会与 v2 的魔数冲突
+        version_ = 1;
+    }
+}
+
+bool P3Reader::ParseV2Header() {
+    P3v2Header header;
+    memcpy(&header, data_, sizeof(header));
+    if (header.version != P3_V2_VERSION) {
+        ESP_LOGE(TAG, "Unsupported version: %d", header.version);
+        return false;
+    }
+    if (header.channels == 0 || header.frame_duration_ms == 0 || header.frame_duration_ms > P3_MAX_FRAME_DURATION_MS ||
+        !IsOpusSampleRate(header.sample_rate)) {
+        ESP_LOGE(TAG, "Unsupported format, %lu Hz, %d channels, %d ms", (unsigned long)header.sample_rate,
+            (int)header.channels, (int)header.frame_duration_ms);
+        return false;
+    }
+
+    // 先限制包数，避免计算偏移表大小时溢出
+    if (header.packet_count >= (size_ - sizeof(header)) / sizeof(uint32_t)) {
+        ESP_LOGE(TAG, "Invalid packet count %lu, size %u", (unsigned long)header.packet_count, (unsigned)size_);
+        return false;
+    }
+    size_t table_size = ((size_t)header.packet_count + 1) * sizeof(uint32_t);
+    if (header.data_offset < sizeof(header) + table_size || header.data_offset > size_) {
+        ESP_LOGE(TAG, "Invalid header, %lu packets, data offset %lu, size %u",
+            (unsigned long)header.packet_count, (unsigned long)header.data_offset, (unsigned)size_);
+        return false;
+    }
+
+    offsets_ = data_ + sizeof(header);
+    packets_ = data_ + header.data_offset;
+    packet_count_ = header.packet_count;
+    packet_count_known_ = true;
+    if (GetOffset(packet_count_) > size_ - header.data_offset) {
+        ESP_LOGE(TAG, "Packet table exceeds data size");
+        return false;
+    }
+    // 偏移必须单调不减，之后读取时不用再检查
+    uint32_t previous = 0;
+    for (size_t i = 0; i <= packet_count_; i++) {
+        uint32_t offset = GetOffset(i);
+        if (offset < previous) {
+            ESP_LOGE(TAG, "Invalid offset of packet %u", (unsigned)i);
+            return false;
+        }
+        previous = offset;
+    }
+
+    version_ = P3_V2_VERSION;
+    sample_rate_ = header.sample_rate;
+    channels_ = header.channels;
+    frame_duration_ = header.frame_duration_ms;
+    return true;
+}
+
+uint32_t P3Reader::GetOffset(size_t index) const {
+    // 数据可能没有按 4 字节对齐
+    uint32_t offset;
+    memcpy(&offset, offsets_ + index * sizeof(uint32_t), sizeof(offset));
+    return offset;
+}
+
+bool P3Reader::IsEnd() const {
+    if (version_ == P3_V2_VERSION) {
+        return position_ >= packet_count_;
+    }
+    return position_ >= size_;
+}
+
+void P3Reader::Rewind() {
+    position_ = 0;
+}
+
+bool P3Reader::Next(const uint8_t*& payload, size_t& size) {
+    if (version_ == P3_V2_VERSION) {
+        if (position_ >= packet_count_) {
+            return false;
+        }
+        uint32_t start = GetOffset(position_);
+        uint32_t end = GetOffset(position_ + 1);
+        position_++;
+        payload = packets_ + start;
+        size = end - start;
+        return true;
+    }
+
+    if (position_ + P3_V1_HEADER_SIZE > size_) {
+        position_ = size_;
+        return false;
+    }
+
+    const uint8_t* header = data_ + position_;
+    size_t payload_size = (header[2] << 8) | header[3];
+    if (position_ + P3_V1_HEADER_SIZE + payload_size > size_) {
+        ESP_LOGE(TAG, "Truncated packet at offset %u", (unsigned)position_);
+        position_ = size_;
+        return false;
+    }
+
+    payload = header + P3_V1_HEADER_SIZE;
+    size = payload_size;
+    position_ += P3_V1_HEADER_SIZE + payload_size;
+    return true;
+}
+
+bool P3Reader::Seek(size_t index) {
+    if (version_ == P3_V2_VERSION) {
+        if (index > packet_count_) {
+            return false;
+        }
+        position_ = index;
+        return true;
+    }
+
+    Rewind();
+    const uint8_t* payload;
+    size_t size;
+    for (size_t i = 0; i < index; i++) {
+        if (!Next(payload, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t P3Reader::GetPacketCount() {
+    if (!packet_count_known_ && version_ == 1) {
+        size_t position = position_;
+        Rewind();
+        const uint8_t* payload;
+        size_t size;
+        packet_count_ = 0;
+        while (Next(payload, size)) {
+            packet_count_++;
+        }
+        position_ = position;
+        packet_count_known_ = true;
+    }
+    return packet_count_;
+}
@@ -0,0 +1,72 @@
+#ifndef P3_READER_H
+#define P3_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// P3 音频格式
+//
+// v1: 没有文件头，连续排列的包，每个包为 4 字节头 (type, reserved, 大端 payload_size) 加 Opus 数据，
+//     固定为 16kHz 单声道 60ms 帧
+//
+// v2: 文件头 + 包偏移表 + 数据区，多字节字段均为小端
+//     P3v2Header
+//     uint32_t offsets[packet_count + 1]  每个包相对数据区起点的偏移，单调不减，最后一项为数据区大小
+//     uint8_t data[]                      连续排列的 Opus 包，没有包头
+#define P3_V2_MAGIC "P3V2"
+#define P3_V2_VERSION 2
+
+struct P3v2Header {
+    char magic[4];
+    uint8_t version;
+    uint8_t channels;
+    uint16_t frame_duration_ms;
+    uint32_t sample_rate;
+    uint32_t packet_count;
+    uint32_t data_offset;   // 数据区相对文件起点的偏移
+} __attribute__((packed));
+
+// 逐包读取 P3 音频，兼容 v1 和 v2
+// 返回的 payload 直接指向原始数据（例如 flash 映射区），不做拷贝
+class P3Reader {
+public:
+    P3Reader() = default;
+    explicit P3Reader(const std::string_view& data);
+
+    bool IsValid() const { return version_ != 0; }
+    int version() const { return version_; }
+    int sample_rate() const { return sample_rate_; }
+    int channels() const { return channels_; }
+    int frame_duration() const { return frame_duration_; }
+
+    bool Next(const uint8_t*& payload, size_t& size);
+    bool IsEnd() const;
+    void Rewind();
+    // 跳到第 index 个包，v2 直接查偏移表，v1 需要从头扫描
+    bool Seek(size_t index);
+    // v1 第一次调用时需要扫描整段数据
+    size_t GetPacketCount();
+    int GetDurationMs() { return GetPacketCount() * frame_duration_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    int version_ = 0;
+    int sample_rate_ = 16000;
+    int channels_ = 1;
+    int frame_duration_ = 60;
+
+    // v1 为下一个包头的偏移，v2 为下一个包的序号
+    size_t position_ = 0;
+    size_t packet_count_ = 0;
+    bool packet_count_known_ = false;
+    // v2 的偏移表和数据区
+    const uint8_t* offsets_ = nullptr;
+    const uint8_t* packets_ = nullptr;
+
+    bool ParseV2Header();
+    uint32_t GetOffset(size_t index) const;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "polyphase_resampler.h"
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+#ifdef ESP_PLATFORM
+#include <sdkconfig.h>
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define POLYPHASE_RESAMPLER_USE_PIE 1
+#else
+#define POLYPHASE_RESAMPLER_USE_PIE 0
+#endif
+
+// 每个相位的基础抽头数，抽取时按比例增加以保证过渡带宽度
+#define BASE_TAPS_PER_PHASE 16
+// 通带边缘占目标奈奎斯特频率的比例
+#define PASSBAND_RATIO 0.9
+#define KAISER_BETA 8.0
+// 超过这个大小的 SIMD 系数表不值得占用内存，例如 44.1k 的 160/441 个相位
+#define MAX_SIMD_TABLE_BYTES (16 * 1024)
+
+static int16_t* AlignTo16Bytes(std::vector<int16_t>& storage) {
+    auto address = reinterpret_cast<uintptr_t>(storage.data());
+    return storage.data() + ((16 - (address & 15)) & 15) / sizeof(int16_t);
+}
+
+static double BesselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static inline int16_t Saturate16(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    } else if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+#if POLYPHASE_RESAMPLER_USE_PIE
+// x 与 h 都必须 16 字节对齐，blocks 为 8 个采样一组的组数，返回 Q15 右移后的结果
+// loopnez 会改写 LBEG/LEND/LCOUNT，而 GCC 不知道内联汇编用到了这几个寄存器，
+// 内联到调用者中时可能破坏编译器自己生成的零开销循环。保持为独立的函数调用：
+// 按调用约定这几个寄存器不跨调用保存，GCC 也不会把包含函数调用的循环变成零开销循环
+static __attribute__((noinline)) int32_t DotProductPie(const int16_t* x, const int16_t* h, int blocks) {
+    int32_t result;
+    int32_t shift = 15;
+    asm volatile (
+        "ee.zero.accx\n"
+        "loopnez %[blocks], 1f\n"
+        "ee.vld.128.ip q0, %[x], 16\n"
+        "ee.vld.128.ip q1, %[h], 16\n"
+        "ee.vmulas.s16.accx q0, q1\n"
+        "1:\n"
+        "ee.srs.accx %[result], %[shift], 0\n"
+        : [x] "+r"(x), [h] "+r"(h), [result] "=r"(result)
+        : [blocks] "r"(blocks), [shift] "r"(shift)
+        : "memory");
+    return result;
+}
+#endif
+
+bool PolyphaseResampler::IsSupported(int input_sample_rate, int output_sample_rate) {
+    auto is_common_rate = [](int rate) {
+        return rate == 24000 || rate == 44100 || rate == 48000;
+    };
+    return (input_sample_rate == 16000 && is_common_rate(output_sample_rate)) ||
+           (output_sample_rate == 16000 && is_common_rate(input_sample_rate));
+}
+
+bool PolyphaseResampler::Configure(int input_sample_rate, int output_sample_rate) {
+    if (!IsSupported(input_sample_rate, output_sample_rate)) {
+        return false;
+    }
+
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+    int divisor = std::gcd(input_sample_rate, output_sample_rate);
+    up_ = output_sample_rate / divisor;
+    down_ = input_sample_rate / divisor;
+    taps_per_phase_ = (BASE_TAPS_PER_PHASE * std::max(up_, down_) / up_ + 7) & ~7;
+
+    DesignFilter();
+    buffer_capacity_ = 0;
+    EnsureBufferCapacity(taps_per_phase_ - 1 + 1024);
+    Reset();
+    return true;
+}
+
+void PolyphaseResampler::Reset() {
+    time_ = 0;
+    if (buffer_ != nullptr) {
+        memset(buffer_, 0, (taps_per_phase_ - 1) * sizeof(int16_t));
+    }
+}
+
+void PolyphaseResampler::DesignFilter() {
+    const int L = up_;
+    const int K = taps_per_phase_;
+    const int N = K * L;
+    // 截止频率，以上采样后的采样率为单位
+    const double cutoff = 0.5 * PASSBAND_RATIO / std::max(up_, down_);
+    const double center = (N - 1) / 2.0;
+    const double i0_beta = BesselI0(KAISER_BETA);
+
+    std::vector<double> prototype(N);
+    for (int n = 0; n < N; n++) {
+        double x = n - center;
+        double sinc = x == 0 ? 1.0 : std::sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+        double r = x / (center + 1);
+        double window = BesselI0(KAISER_BETA * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        prototype[n] = 2 * cutoff * L * sinc * window;
+    }
+
+    // 量化为 Q15，并把每个相位的舍入误差补到最大的系数上，保证直流增益严格为 1
+    taps_.assign(L * K, 0);
+    for (int p = 0; p < L; p++) {
+        double phase_sum = 0;
+        for (int k = 0; k < K; k++) {
+            phase_sum += prototype[p + k * L];
+        }
+        int32_t quantized_sum = 0;
+        int peak = 0;
+        for (int k = 0; k < K; k++) {
+            double value = prototype[p + k * L] / phase_sum;
+            int16_t tap = Saturate16((int32_t)std::lround(value * 32768.0));
+            taps_[p * K + (K - 1 - k)] = tap;
+            quantized_sum += tap;
+            if (std::abs(tap) > std::abs(taps_[p * K + peak])) {
+                peak = K - 1 - k;
+            }
+        }
+        taps_[p * K + peak] = Saturate16(taps_[p * K + peak] + (32768 - quantized_sum));
+    }
+
+    use_simd_ = false;
+    aligned_taps_ = nullptr;
+    aligned_taps_storage_.clear();
+#if POLYPHASE_RESAMPLER_USE_PIE
+    size_t table_size = (size_t)L * 8 * (K + 8);
+    if (table_size * sizeof(int16_t) <= MAX_SIMD_TABLE_BYTES) {
+        aligned_taps_storage_.assign(table_size + 8, 0);
+        aligned_taps_ = AlignTo16Bytes(aligned_taps_storage_);
+        for (int p = 0; p < L; p++) {
+            for (int offset = 0; offset < 8; offset++) {
+                int16_t* dst = aligned_taps_ + (p * 8 + offset) * (K + 8) + offset;
+                memcpy(dst, &taps_[p * K], K * sizeof(int16_t));
+            }
+        }
+        use_simd_ = true;
+    }
+#endif
+}
+
+void PolyphaseResampler::EnableSimd(bool enable) {
+    use_simd_ = enable && aligned_taps_ != nullptr;
+}
+
+void PolyphaseResampler::EnsureBufferCapacity(int samples) {
+    if (samples <= buffer_capacity_) {
+        return;
+    }
+
+    // 额外 16 个采样：8 个用于对齐，8 个用于 SIMD 读越过窗口末尾
+    std::vector<int16_t> storage(samples + 16, 0);
+    int16_t* buffer = AlignTo16Bytes(storage);
+    if (buffer_ != nullptr) {
+        memcpy(buffer, buffer_, (taps_per_phase_ - 1) * sizeof(int16_t));
+    }
+    buffer_storage_ = std::move(storage);
+    buffer_ = buffer;
+    buffer_capacity_ = samples;
+}
+
+inline int16_t PolyphaseResampler::FilterAt(const int16_t* window_start, int phase) const {
+    const int K = taps_per_phase_;
+#if POLYPHASE_RESAMPLER_USE_PIE
+    if (use_simd_) {
+        int offset = (reinterpret_cast<uintptr_t>(window_start) >> 1) & 7;
+        const int16_t* aligned_input = window_start - offset;
+        const int16_t* taps = aligned_taps_ + (phase * 8 + offset) * (K + 8);
+        return Saturate16(DotProductPie(aligned_input, taps, (K + 8) / 8));
+    }
+#endif
+    const int16_t* taps = &taps_[phase * K];
+    int32_t acc = 1 << 14;
+    for (int k = 0; k < K; k += 4) {
+        acc += taps[k] * window_start[k];
+        acc += taps[k + 1] * window_start[k + 1];
+        acc += taps[k + 2] * window_start[k + 2];
+        acc += taps[k + 3] * window_start[k + 3];
+    }
+    return Saturate16(acc >> 15);
+}
+
+int PolyphaseResampler::GetOutputSamples(int input_samples) const {
+    int64_t end = (int64_t)input_samples * up_;
+    if (time_ >= end) {
+        return 0;
+    }
+    return (end - time_ + down_ - 1) / down_;
+}
+
+int PolyphaseResampler::Process(const int16_t* input, int input_samples, int16_t* output) {
+    const int history = taps_per_phase_ - 1;
+    EnsureBufferCapacity(history + input_samples);
+    memcpy(buffer_ + history, input, input_samples * sizeof(int16_t));
+
+    int output_samples = 0;
+    while (true) {
+        int64_t index = time_ / up_;
+        if (index >= input_samples) {
+            break;
+        }
+        output[output_samples++] = FilterAt(buffer_ + index, time_ % up_);
+        time_ += down_;
+    }
+    time_ -= (int64_t)input_samples * up_;
+
+    memmove(buffer_, buffer_ + input_samples, history * sizeof(int16_t));
+    return output_samples;
+}
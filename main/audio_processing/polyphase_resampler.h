@@ -0,0 +1,51 @@
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+
+// 定点多相 FIR 重采样器，单声道 int16
+// 支持 16k 与 24k/44.1k/48k 之间的互相转换，ESP32-S3 上使用 PIE SIMD 指令计算点积
+class PolyphaseResampler {
+public:
+    static bool IsSupported(int input_sample_rate, int output_sample_rate);
+
+    bool Configure(int input_sample_rate, int output_sample_rate);
+    void Reset();
+    // 返回实际输出的采样数，与同一状态下 GetOutputSamples 的结果一致
+    int Process(const int16_t* input, int input_samples, int16_t* output);
+    int GetOutputSamples(int input_samples) const;
+    // 支持时默认使用 SIMD，关闭后使用标量实现，用于测试和性能对比
+    void EnableSimd(bool enable);
+    bool simd_enabled() const { return use_simd_; }
+
+    int input_sample_rate() const { return input_sample_rate_; }
+    int output_sample_rate() const { return output_sample_rate_; }
+
+private:
+    int input_sample_rate_ = 0;
+    int output_sample_rate_ = 0;
+    int up_ = 1;             // 插值倍数 L
+    int down_ = 1;           // 抽取倍数 M
+    int taps_per_phase_ = 0; // K，8 的倍数
+    // 上采样域中下一个输出相对本次输入起点的位置
+    int64_t time_ = 0;
+
+    // 每个相位的系数按时间倒序存放，便于与输入做连续点积
+    std::vector<int16_t> taps_;
+    // SIMD 版本：每个相位再按 0~7 个采样的偏移各存一份，使输入地址可以 16 字节对齐
+    std::vector<int16_t> aligned_taps_storage_;
+    int16_t* aligned_taps_ = nullptr;
+    bool use_simd_ = false;
+
+    // 历史数据 (K-1 个采样) + 本次输入
+    std::vector<int16_t> buffer_storage_;
+    int16_t* buffer_ = nullptr;
+    int buffer_capacity_ = 0;
+
+    void DesignFilter();
+    void EnsureBufferCapacity(int samples);
+    int16_t FilterAt(const int16_t* window_end, int phase) const;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "sound_cache.h"
+#include "audio_resampler.h"
+#include "p3_reader.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <opus.h>
+#include <algorithm>
+
+#define TAG "SoundCache"
+
+// Opus 单包最长 120ms
+#define MAX_OPUS_PACKET_DURATION_MS 120
+
+SoundCache::~SoundCache() {
+    for (auto& [key, entry] : entries_) {
+        heap_caps_free(entry.pcm);
+    }
+}
+
+void SoundCache::Initialize(int output_sample_rate, size_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    output_sample_rate_ = output_sample_rate;
+    budget_bytes_ = budget_bytes;
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) {
+        ESP_LOGI(TAG, "PSRAM not available, sound cache disabled");
+        budget_bytes_ = 0;
+    }
+}
+
+void SoundCache::Allow(const std::string_view& sound) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (budget_bytes_ > 0 && !sound.empty() && allowed_.insert(sound.data()).second) {
+        preload_.push_back(sound);
+    }
+}
+
+void SoundCache::Preload() {
+    std::vector<std::string_view> sounds;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sounds = preload_;
+    }
+    auto start_time = esp_timer_get_time();
+    for (auto& sound : sounds) {
+        Load(sound);
+    }
+    auto stats = GetStats();
+    ESP_LOGI(TAG, "Preloaded %u sounds in %lld ms, used %u/%u bytes, rejected %lu", stats.entries,
+        (esp_timer_get_time() - start_time) / 1000, stats.used_bytes, stats.budget_bytes, stats.rejected);
+}
+
+// 调用时必须持有 mutex_，返回 false 方便直接作为 Load 的返回值
+bool SoundCache::Reject(const std::string_view& sound) {
+    if (rejected_sounds_.insert(sound.data()).second) {
+        rejected_++;
+    }
+    return false;
+}
+
+bool SoundCache::Lookup(const std::string_view& sound, const int16_t*& pcm, size_t& samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (allowed_.find(sound.data()) == allowed_.end()) {
+        return false;
+    }
+    auto it = entries_.find(sound.data());
+    if (it == entries_.end()) {
+        misses_++;
+        return false;
+    }
+    hits_++;
+    pcm = it->second.pcm;
+    samples = it->second.samples;
+    return true;
+}
+
+bool SoundCache::Load(const std::string_view& sound) {
+    P3Reader reader(sound);
+    int output_sample_rate;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.find(sound.data()) != entries_.end()) {
+            return true;
+        }
+        if (rejected_sounds_.find(sound.data()) != rejected_sounds_.end()) {
+            return false;
+        }
+        if (!reader.IsValid()) {
+            return Reject(sound);
+        }
+        // 解码之前先按时长估算输出大小，放不下时不必解码
+        output_sample_rate = output_sample_rate_;
+        size_t estimated_bytes = (size_t)reader.GetDurationMs() * output_sample_rate / 1000 * sizeof(int16_t);
+        if (used_bytes_ + estimated_bytes > budget_bytes_) {
+            ESP_LOGW(TAG, "Budget exceeded, %u + %u > %u bytes", used_bytes_, estimated_bytes, budget_bytes_);
+            return Reject(sound);
+        }
+    }
+
+    // 按音频自身的采样率解码，多声道的音频由解码器混合为单声道
+    auto start_time = esp_timer_get_time();
+    int sample_rate = reader.sample_rate();
+    int error;
+    OpusDecoder* decoder = opus_decoder_create(sample_rate, 1, &error);
+    if (decoder == nullptr) {
+        ESP_LOGE(TAG, "Failed to create decoder: %d", error);
+        return false;
+    }
+
+    // 先按时长确定输出大小，直接在 PSRAM 中分配最终的缓冲区，解码和重采样都写入其中
+    bool resample = output_sample_rate != sample_rate;
+    AudioResampler resampler;
+    size_t capacity = (size_t)reader.GetDurationMs() * sample_rate / 1000;
+    if (resample) {
+        resampler.Configure(sample_rate, output_sample_rate);
+        capacity = resampler.GetOutputSamples(capacity);
+    }
+    auto buffer = (int16_t*)heap_caps_malloc(capacity * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    // 需要重采样时每包先解码到暂存区，暂存区同样放在 PSRAM 中
+    int max_frame_samples = sample_rate * MAX_OPUS_PACKET_DURATION_MS / 1000;
+    int16_t* frame = nullptr;
+    if (resample) {
+        frame = (int16_t*)heap_caps_malloc(max_frame_samples * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    }
+    if (buffer == nullptr || (resample && frame == nullptr)) {
+        ESP_LOGE(TAG, "Failed to allocate %u samples", capacity);
+        heap_caps_free(buffer);
+        heap_caps_free(frame);
+        opus_decoder_destroy(decoder);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return Reject(sound);
+    }
+
+    // 音频比文件头标注的时长更长时截断
+    size_t samples = 0;
+    bool truncated = false;
+    const uint8_t* payload;
+    size_t payload_size;
+    while (!truncated && reader.Next(payload, payload_size)) {
+        if (!resample) {
+            if (samples == capacity) {
+                truncated = true;
+                break;
+            }
+            int frame_samples = opus_decode(decoder, payload, payload_size, buffer + samples,
+                std::min<size_t>(capacity - samples, max_frame_samples), 0);
+            if (frame_samples > 0) {
+                samples += frame_samples;
+            }
+            truncated = frame_samples == OPUS_BUFFER_TOO_SMALL;
+            continue;
+        }
+        int frame_samples = opus_decode(decoder, payload, payload_size, frame, max_frame_samples, 0);
+        if (frame_samples <= 0) {
+            continue;
+        }
+        size_t output_samples = resampler.GetOutputSamples(frame_samples);
+        truncated = samples + output_samples > capacity;
+        if (!truncated) {
+            resampler.Process(frame, frame_samples, buffer + samples);
+            samples += output_samples;
+        }
+    }
+    if (truncated) {
+        ESP_LOGW(TAG, "Sound longer than its header, truncated to %u samples", samples);
+    }
+    heap_caps_free(frame);
+    opus_decoder_destroy(decoder);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 预算按实际分配的大小计算
+    size_t bytes = capacity * sizeof(int16_t);
+    if (samples == 0 || used_bytes_ + bytes > budget_bytes_) {
+        if (samples > 0) {
+            ESP_LOGW(TAG, "Budget exceeded, %u + %u > %u bytes", used_bytes_, bytes, budget_bytes_);
+        }
+        heap_caps_free(buffer);
+        return Reject(sound);
+    }
+    used_bytes_ += bytes;
+    entries_[sound.data()] = Entry{buffer, samples};
+    ESP_LOGI(TAG, "Cached %u samples in %lld ms, used %u/%u bytes", samples,
+        (esp_timer_get_time() - start_time) / 1000, used_bytes_, budget_bytes_);
+    return true;
+}
+
+SoundCacheStats SoundCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return SoundCacheStats{
+        .entries = entries_.size(),
+        .used_bytes = used_bytes_,
+        .budget_bytes = budget_bytes_,
+        .hits = hits_,
+        .misses = misses_,
+        .rejected = rejected_,
+    };
+}
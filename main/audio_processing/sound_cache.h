@@ -0,0 +1,71 @@
+#ifndef SOUND_CACHE_H
+#define SOUND_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct SoundCacheStats {
+    size_t entries;
+    size_t used_bytes;
+    size_t budget_bytes;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t rejected;  // 超出预算没有缓存的音频数
+};
+
+// 常用短提示音解码后的 PCM 缓存，数据放在 PSRAM 中，采样率与 codec 输出一致
+// 只缓存加入白名单的音频，启动时在低优先级任务中预先解码，播放时不会在输出路径上解码
+// 缓存项不会被淘汰，返回的指针一直有效
+class SoundCache {
+public:
+    static SoundCache& GetInstance() {
+        static SoundCache instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    SoundCache(const SoundCache&) = delete;
+    SoundCache& operator=(const SoundCache&) = delete;
+
+    void Initialize(int output_sample_rate, size_t budget_bytes);
+    void Allow(const std::string_view& sound);
+    // 按加入白名单的顺序解码所有尚未缓存的音频，耗时较长，不要在音频任务中调用
+    void Preload();
+
+    // 查找缓存并统计命中率，未命中时返回 false，调用者逐包解码
+    bool Lookup(const std::string_view& sound, const int16_t*& pcm, size_t& samples);
+    // 解码整段音频放入缓存，超出预算或者解码失败时返回 false
+    // 解码前按时长估算大小，放不下的音频记录下来，之后不再尝试
+    bool Load(const std::string_view& sound);
+
+    SoundCacheStats GetStats();
+
+private:
+    SoundCache() = default;
+    ~SoundCache();
+
+    struct Entry {
+        int16_t* pcm;
+        size_t samples;
+    };
+
+    std::mutex mutex_;
+    int output_sample_rate_ = 16000;
+    size_t budget_bytes_ = 0;
+    size_t used_bytes_ = 0;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+    uint32_t rejected_ = 0;
+    std::unordered_set<const char*> allowed_;
+    std::vector<std::string_view> preload_;
+    std::unordered_set<const char*> rejected_sounds_;
+    std::unordered_map<const char*, Entry> entries_;
+
+    bool Reject(const std::string_view& sound);
+};
+
+#endif
@@ -111,10 +111,22 @@ bool WakeWordDetect::IsDetectionRunning() {
     return xEventGroupGetBits(event_group_) & DETECTION_RUNNING_EVENT;
 }
 
-void WakeWordDetect::Feed(const std::vector<int16_t>& data) {
-    input_buffer_.insert(input_buffer_.end(), data.begin(), data.end());
+int WakeWordDetect::GetFeedSize() {
+    return esp_afe_sr_v1.get_feed_chunksize(afe_detection_data_);
+}
 
+void WakeWordDetect::Feed(const PcmFrame& data) {
     auto feed_size = esp_afe_sr_v1.get_feed_chunksize(afe_detection_data_) * channels_;
+    // 采集周期与 feed chunk 对齐时直接送入 AFE，不经过缓冲区
+    size_t offset = 0;
+    if (input_buffer_.empty()) {
+        while (data.size() - offset >= feed_size) {
+            esp_afe_sr_v1.feed(afe_detection_data_, data.data() + offset);
+            offset += feed_size;
+        }
+    }
+    input_buffer_.insert(input_buffer_.end(), data.begin() + offset, data.end());
+
     while (input_buffer_.size() >= feed_size) {
         esp_afe_sr_v1.feed(afe_detection_data_, input_buffer_.data());
         input_buffer_.erase(input_buffer_.begin(), input_buffer_.begin() + feed_size);
@@ -162,7 +174,7 @@ void WakeWordDetect::AudioDetectionTask() {
 
 void WakeWordDetect::StoreWakeWordData(uint16_t* data, size_t samples) {
     // store audio data to wake_word_pcm_
-    wake_word_pcm_.emplace_back(std::vector<int16_t>(data, data + samples));
+    wake_word_pcm_.emplace_back(data, data + samples);
     // keep about 2 seconds of data, detect duration is 32ms (sample_rate == 16000, chunksize == 512)
     while (wake_word_pcm_.size() > 2000 / 32) {
         wake_word_pcm_.pop_front();
@@ -182,9 +194,9 @@ void WakeWordDetect::EncodeWakeWordData() {
             encoder->SetComplexity(0); // 0 is the fastest
 
             for (auto& pcm: this_->wake_word_pcm_) {
-                encoder->Encode(std::move(pcm), [this_](std::vector<uint8_t>&& opus) {
+                encoder->Encode(std::vector<int16_t>(pcm.begin(), pcm.end()), [this_](std::vector<uint8_t>&& opus) {
                     std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
-                    this_->wake_word_opus_.emplace_back(std::move(opus));
+                    this_->wake_word_opus_.emplace_back(opus.begin(), opus.end());
                     this_->wake_word_cv_.notify_all();
                 });
             }
@@ -195,14 +207,14 @@ void WakeWordDetect::EncodeWakeWordData() {
                 this_->wake_word_opus_.size(), (end_time - start_time) / 1000);
 
             std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
-            this_->wake_word_opus_.push_back(std::vector<uint8_t>());
+            this_->wake_word_opus_.push_back(OpusPacket());
             this_->wake_word_cv_.notify_all();
         }
         vTaskDelete(NULL);
     }, "encode_detect_packets", 4096 * 8, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
 }
 
-bool WakeWordDetect::GetWakeWordOpus(std::vector<uint8_t>& opus) {
+bool WakeWordDetect::GetWakeWordOpus(OpusPacket& opus) {
     std::unique_lock<std::mutex> lock(wake_word_mutex_);
     wake_word_cv_.wait(lock, [this]() {
         return !wake_word_opus_.empty();
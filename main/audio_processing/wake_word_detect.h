@@ -15,6 +15,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "memory_pool.h"
+
 
 class WakeWordDetect {
 public:
@@ -22,14 +24,16 @@ public:
     ~WakeWordDetect();
 
     void Initialize(int channels, bool reference);
-    void Feed(const std::vector<int16_t>& data);
+    void Feed(const PcmFrame& data);
+    // 每个声道每次 feed 的采样数 (16kHz)
+    int GetFeedSize();
     void OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback);
     void OnVadStateChange(std::function<void(bool speaking)> callback);
     void StartDetection();
     void StopDetection();
     bool IsDetectionRunning();
     void EncodeWakeWordData();
-    bool GetWakeWordOpus(std::vector<uint8_t>& opus);
+    bool GetWakeWordOpus(OpusPacket& opus);
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
 
 private:
@@ -48,8 +52,8 @@ private:
     TaskHandle_t wake_word_encode_task_ = nullptr;
     StaticTask_t wake_word_encode_task_buffer_;
     StackType_t* wake_word_encode_task_stack_ = nullptr;
-    std::list<std::vector<int16_t>> wake_word_pcm_;
-    std::list<std::vector<uint8_t>> wake_word_opus_;
+    std::list<AfeChunk> wake_word_pcm_;
+    std::list<OpusPacket> wake_word_opus_;
     std::mutex wake_word_mutex_;
     std::condition_variable wake_word_cv_;
 
@@ -1,6 +1,7 @@
 #include "axp2101.h"
 #include "board.h"
 #include "display.h"
+#include "settings.h"
 
 #include <esp_log.h>
 
@@ -31,6 +32,8 @@ int Axp2101::GetBatteryLevel() {
 }
 
 void Axp2101::PowerOff() {
+    // 断电之前写入未保存的设置
+    Settings::Flush();
     uint8_t value = ReadReg(0x10);
     value = value | 0x01;
     WriteReg(0x10, value);
@@ -65,6 +65,7 @@ void Ml307Board::WaitForNetworkReady() {
 
     // Close all previous connections
     modem_.ResetConnections();
+    display->RequestUpdate();
 }
 
 Http* Ml307Board::CreateHttp() {
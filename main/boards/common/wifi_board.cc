@@ -16,6 +16,8 @@
 #include <tls_transport.h>
 #include <web_socket.h>
 #include <esp_log.h>
+#include <esp_event.h>
+#include <esp_wifi.h>
 
 #include <wifi_station.h>
 #include <wifi_configuration_ap.h>
@@ -44,6 +46,7 @@ void WifiBoard::EnterWifiConfigMode() {
     wifi_ap.SetLanguage(Lang::CODE);
     wifi_ap.SetSsidPrefix("Xiaozhi");
     wifi_ap.Start();
+    Board::GetInstance().GetDisplay()->SetNetworkIcon(FONT_AWESOME_WIFI);
 
     // 显示 WiFi 配置 AP 的 SSID 和 Web 服务器 URL
     std::string hint = Lang::Strings::CONNECT_TO_HOTSPOT;
@@ -97,8 +100,14 @@ void WifiBoard::StartNetwork() {
         std::string notification = Lang::Strings::CONNECTED_TO;
         notification += ssid;
         display->ShowNotification(notification.c_str(), 30000);
+        display->RequestUpdate();
     });
     wifi_station.Start();
+    // 断开连接时立即刷新网络图标，不等兜底轮询；在 WifiStation 自己的处理函数之后注册，读到的是新的连接状态
+    esp_event_handler_instance_register(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, [](void* arg, esp_event_base_t base,
+        int32_t id, void* data) {
+        Board::GetInstance().GetDisplay()->RequestUpdate();
+    }, nullptr, nullptr);
 
     // Try to connect to WiFi, if failed, launch the WiFi configuration AP
     if (!wifi_station.WaitForConnected(60 * 1000)) {
@@ -1,9 +1,9 @@
 #include "k10_audio_codec.h"
+#include "pcm_kernels.h"
 
 #include <esp_log.h>
 #include <driver/i2c.h>
 #include <driver/i2s_tdm.h>
-#include <cmath>
 
 static const char TAG[] = "K10AudioCodec";
 
@@ -75,7 +75,7 @@ void K10AudioCodec::CreateDuplexChannels(gpio_num_t mclk, gpio_num_t bclk, gpio_
         .id = I2S_NUM_0,
         .role = I2S_ROLE_MASTER,
         .dma_desc_num = 6,
-        .dma_frame_num = 240,
+        .dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM(input_sample_rate_),
         .auto_clear_after_cb = true,
         .auto_clear_before_cb = false,
         .intr_priority = 0,
@@ -200,26 +200,15 @@ int K10AudioCodec::Read(int16_t* dest, int samples) {
 
 int K10AudioCodec::Write(const int16_t* data, int samples) {
     if (output_enabled_) {
-        std::vector<int32_t> buffer(samples * 2);  // Allocate buffer for 2x samples
-
-        // Apply volume adjustment (same as before)
-        int32_t volume_factor = pow(double(output_volume_) / 100.0, 2) * 65536;
-        for (int i = 0; i < samples; i++) {
-            int64_t temp = int64_t(data[i]) * volume_factor;
-            if (temp > INT32_MAX) {
-            buffer[i * 2] = INT32_MAX;
-            } else if (temp < INT32_MIN) {
-            buffer[i * 2] = INT32_MIN;
-            } else {
-            buffer[i * 2] = static_cast<int32_t>(temp);
-            }
-
-            // Repeat each sample for slow playback (assuming mono audio)
-            buffer[i * 2 + 1] = buffer[i * 2];
+        if (write_buffer_.size() < (size_t)samples * 2) {
+            write_buffer_.resize(samples * 2);
         }
 
+        // Apply volume adjustment and repeat each sample on both channels (assuming mono audio)
+        pcm::Int16ToInt32Stereo(data, write_buffer_.data(), samples, pcm::VolumeToGainQ16(output_volume_));
+
         size_t bytes_written;
-        ESP_ERROR_CHECK(i2s_channel_write(tx_handle_, buffer.data(), samples * 2 * sizeof(int32_t), &bytes_written, portMAX_DELAY));
+        ESP_ERROR_CHECK(i2s_channel_write(tx_handle_, write_buffer_.data(), samples * 2 * sizeof(int32_t), &bytes_written, portMAX_DELAY));
         return bytes_written / sizeof(int32_t);
     }
     return samples;
@@ -36,6 +36,7 @@ void Tcamerapluss3AudioCodec::CreateVoiceHardware(gpio_num_t mic_bclk, gpio_num_
     
     i2s_chan_config_t mic_chan_config = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
     mic_chan_config.auto_clear = true; // Auto clear the legacy data in the DMA buffer
+    mic_chan_config.dma_frame_num = AUDIO_CODEC_DMA_FRAME_NUM(input_sample_rate_);
     i2s_chan_config_t spkr_chan_config = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
     spkr_chan_config.auto_clear = true; // Auto clear the legacy data in the DMA buffer
 
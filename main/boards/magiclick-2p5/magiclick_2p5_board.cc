@@ -55,6 +55,7 @@ public:
         lv_obj_set_style_border_width(content_, 0, 0);
         lv_obj_set_style_text_color(emotion_label_, lv_color_white(), 0);
         lv_obj_set_style_text_color(chat_message_label_, lv_color_white(), 0);
+        lv_obj_set_style_text_color(chat_list_, lv_color_white(), 0);
     }
 };
 
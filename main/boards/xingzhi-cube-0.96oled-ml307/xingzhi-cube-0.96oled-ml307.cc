@@ -8,6 +8,7 @@
 #include "iot/thing_manager.h"
 #include "led/single_led.h"
 #include "assets/lang_config.h"
+#include "settings.h"
 #include "power_save_timer.h"
 #include "../xingzhi-cube-1.54tft-wifi/power_manager.h"
 
@@ -44,6 +45,7 @@ private:
             } else {
                 power_save_timer_->SetEnabled(true);
             }
+            GetDisplay()->RequestUpdate();
         });
     }
 
@@ -70,6 +72,8 @@ private:
             // 启用保持功能，确保睡眠期间电平不变
             rtc_gpio_hold_en(GPIO_NUM_21);
             esp_lcd_panel_disp_on_off(panel_, false); //关闭显示
+            // 深度睡眠不会调用关机回调，先写入未保存的设置
+            Settings::Flush();
             esp_deep_sleep_start();
         });
         power_save_timer_->SetEnabled(true);
@@ -0,0 +1,141 @@
+#include "boot_sequence.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <algorithm>
+
+#define TAG "BootSequence"
+
+// 每个步骤占用事件组中的一位
+#define BOOT_SEQUENCE_MAX_STEPS 24
+#define BOOT_SEQUENCE_BAR_WIDTH 40
+
+BootSequence::BootSequence() {
+    event_group_ = xEventGroupCreate();
+}
+
+BootSequence::~BootSequence() {
+    vEventGroupDelete(event_group_);
+}
+
+int BootSequence::FindStep(const char* name) {
+    for (auto& step : steps_) {
+        if (step.name == name) {
+            return step.index;
+        }
+    }
+    return -1;
+}
+
+void BootSequence::AddStep(const char* name, std::vector<const char*> depends, std::function<void()> callback, uint32_t stack_size) {
+    if (steps_.size() >= BOOT_SEQUENCE_MAX_STEPS) {
+        ESP_LOGE(TAG, "Too many boot steps, %s is executed immediately", name);
+        callback();
+        return;
+    }
+
+    Step step;
+    step.owner = this;
+    step.index = steps_.size();
+    step.name = name;
+    step.callback = callback;
+    step.stack_size = stack_size;
+    for (auto depend : depends) {
+        int index = FindStep(depend);
+        if (index < 0) {
+            ESP_LOGE(TAG, "Step %s depends on unknown step %s", name, depend);
+            continue;
+        }
+        step.depends.push_back(index);
+    }
+    steps_.push_back(std::move(step));
+}
+
+void BootSequence::Execute(Step& step) {
+    step.start_time = esp_timer_get_time();
+    step.callback();
+    step.end_time = esp_timer_get_time();
+    // 步骤已经结束，释放回调中捕获的资源
+    step.callback = nullptr;
+    xEventGroupSetBits(event_group_, BIT(step.index));
+}
+
+void BootSequence::Run() {
+    while (true) {
+        EventBits_t done = xEventGroupGetBits(event_group_);
+        EventBits_t running = 0;
+        bool finished = true;
+        for (auto& step : steps_) {
+            EventBits_t bit = BIT(step.index);
+            if (done & bit) {
+                continue;
+            }
+            finished = false;
+            if (step.started) {
+                running |= bit;
+                continue;
+            }
+
+            bool ready = true;
+            for (auto depend : step.depends) {
+                if (!(done & BIT(depend))) {
+                    ready = false;
+                    break;
+                }
+            }
+            if (!ready) {
+                continue;
+            }
+
+            step.started = true;
+            if (step.stack_size == 0) {
+                // 在当前任务中执行，执行期间其它任务中的步骤继续运行
+                Execute(step);
+                done = xEventGroupGetBits(event_group_);
+            } else if (xTaskCreate([](void* arg) {
+                    Step* step = (Step*)arg;
+                    step->owner->Execute(*step);
+                    vTaskDelete(NULL);
+                }, step.name.c_str(), step.stack_size, &step, uxTaskPriorityGet(NULL), nullptr) == pdPASS) {
+                running |= bit;
+            } else {
+                // 内存不足时退回到在当前任务中执行，否则这一步永远不会完成，启动会一直等待
+                ESP_LOGE(TAG, "Failed to create task for step %s, executing it inline", step.name.c_str());
+                Execute(step);
+                done = xEventGroupGetBits(event_group_);
+            }
+        }
+
+        if (finished) {
+            break;
+        }
+        // 等待任意一个正在运行的步骤结束后重新检查
+        if (running != 0) {
+            xEventGroupWaitBits(event_group_, running, pdFALSE, pdFALSE, portMAX_DELAY);
+        }
+    }
+}
+
+void BootSequence::PrintTimeline() {
+    int64_t total = 0;
+    for (auto& step : steps_) {
+        total = std::max(total, step.end_time);
+    }
+    if (total == 0) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "Boot timeline, ready at %lld ms", total / 1000);
+    for (auto& step : steps_) {
+        char bar[BOOT_SEQUENCE_BAR_WIDTH + 1];
+        int begin = step.start_time * BOOT_SEQUENCE_BAR_WIDTH / total;
+        int end = step.end_time * BOOT_SEQUENCE_BAR_WIDTH / total;
+        for (int i = 0; i < BOOT_SEQUENCE_BAR_WIDTH; i++) {
+            bar[i] = i < begin ? ' ' : (i <= end ? '#' : ' ');
+        }
+        bar[BOOT_SEQUENCE_BAR_WIDTH] = '\0';
+        ESP_LOGI(TAG, "%-10s |%s| %6lld - %6lld ms (%lld ms)", step.name.c_str(), bar,
+            step.start_time / 1000, step.end_time / 1000, (step.end_time - step.start_time) / 1000);
+    }
+}
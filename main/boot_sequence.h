@@ -0,0 +1,48 @@
+#ifndef _BOOT_SEQUENCE_H_
+#define _BOOT_SEQUENCE_H_
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 启动步骤编排，每个步骤声明依赖的步骤，依赖都完成之后才开始执行
+// 互不依赖的步骤在各自的任务中并行执行，并记录每一步的开始和结束时间
+class BootSequence {
+public:
+    BootSequence();
+    ~BootSequence();
+    BootSequence(const BootSequence&) = delete;
+    BootSequence& operator=(const BootSequence&) = delete;
+
+    // depends 中的步骤必须已经添加，因此不会出现循环依赖
+    // stack_size 为 0 时在调用 Run 的任务中执行，否则创建单独的任务
+    void AddStep(const char* name, std::vector<const char*> depends, std::function<void()> callback, uint32_t stack_size = 0);
+    // 阻塞直到所有步骤执行完成
+    void Run();
+    // 打印各步骤的时间线，时间从芯片启动开始计算
+    void PrintTimeline();
+
+private:
+    struct Step {
+        BootSequence* owner;
+        int index;
+        std::string name;
+        std::vector<int> depends;
+        std::function<void()> callback;
+        uint32_t stack_size;
+        bool started = false;
+        int64_t start_time = 0;
+        int64_t end_time = 0;
+    };
+
+    std::vector<Step> steps_;
+    EventGroupHandle_t event_group_ = nullptr;
+
+    int FindStep(const char* name);
+    void Execute(Step& step);
+};
+
+#endif // _BOOT_SEQUENCE_H_
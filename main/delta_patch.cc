@@ -0,0 +1,114 @@
+#include "delta_patch.h"
+
+#include <esp_log.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "DeltaPatch"
+
+static uint32_t ReadUint32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// 把数据追加到 pending_ 直到凑够 needed 字节
+bool DeltaPatch::Fill(const char*& data, size_t& size, size_t needed) {
+    size_t count = std::min(needed - pending_size_, size);
+    memcpy(pending_ + pending_size_, data, count);
+    pending_size_ += count;
+    data += count;
+    size -= count;
+    return pending_size_ == needed;
+}
+
+bool DeltaPatch::ParseHeader() {
+    memcpy(&header_, pending_, sizeof(header_));
+    if (memcmp(header_.magic, DELTA_PATCH_MAGIC, 4) != 0 || header_.version != DELTA_PATCH_VERSION) {
+        ESP_LOGE(TAG, "Invalid patch header");
+        return false;
+    }
+    ESP_LOGI(TAG, "Patch from %lu bytes to %lu bytes", (unsigned long)header_.source_size, (unsigned long)header_.target_size);
+    return !on_header_ || on_header_(header_);
+}
+
+bool DeltaPatch::ParseOp() {
+    if (pending_[0] == kDeltaPatchCopy) {
+        uint32_t source_offset = ReadUint32(pending_ + 1);
+        uint32_t copy_size = ReadUint32(pending_ + 5);
+        if (source_offset + (uint64_t)copy_size > header_.source_size || output_size_ + copy_size > header_.target_size) {
+            ESP_LOGE(TAG, "Copy out of range: %lu+%lu", (unsigned long)source_offset, (unsigned long)copy_size);
+            return false;
+        }
+        output_size_ += copy_size;
+        return !on_copy_ || on_copy_(source_offset, copy_size);
+    }
+
+    uint32_t insert_size = ReadUint32(pending_ + 1);
+    if (output_size_ + insert_size > header_.target_size) {
+        ESP_LOGE(TAG, "Insert out of range: %lu", (unsigned long)insert_size);
+        return false;
+    }
+    insert_remaining_ = insert_size;
+    state_ = kStateInsert;
+    return true;
+}
+
+bool DeltaPatch::Feed(const char* data, size_t size) {
+    while (size > 0) {
+        switch (state_) {
+        case kStateHeader:
+            if (Fill(data, size, sizeof(DeltaPatchHeader))) {
+                pending_size_ = 0;
+                if (!ParseHeader()) {
+                    state_ = kStateError;
+                    return false;
+                }
+                state_ = kStateOp;
+            }
+            break;
+        case kStateOp: {
+            if (IsComplete()) {
+                ESP_LOGE(TAG, "Unexpected data after the end of patch");
+                state_ = kStateError;
+                return false;
+            }
+            // 先读操作类型，再按类型读参数
+            if (pending_size_ == 0) {
+                Fill(data, size, 1);
+                if (pending_[0] != kDeltaPatchCopy && pending_[0] != kDeltaPatchInsert) {
+                    ESP_LOGE(TAG, "Unknown patch op: %u", pending_[0]);
+                    state_ = kStateError;
+                    return false;
+                }
+                continue;
+            }
+            size_t needed = pending_[0] == kDeltaPatchCopy ? 9 : 5;
+            if (Fill(data, size, needed)) {
+                pending_size_ = 0;
+                if (!ParseOp()) {
+                    state_ = kStateError;
+                    return false;
+                }
+            }
+            break;
+        }
+        case kStateInsert: {
+            size_t count = std::min(insert_remaining_, size);
+            if (on_insert_ && !on_insert_(data, count)) {
+                state_ = kStateError;
+                return false;
+            }
+            output_size_ += count;
+            insert_remaining_ -= count;
+            data += count;
+            size -= count;
+            if (insert_remaining_ == 0) {
+                state_ = kStateOp;
+            }
+            break;
+        }
+        case kStateError:
+            return false;
+        }
+    }
+    return state_ != kStateError;
+}
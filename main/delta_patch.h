@@ -0,0 +1,68 @@
+#ifndef _DELTA_PATCH_H_
+#define _DELTA_PATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// 差分升级补丁格式，多字节字段均为小端，由 scripts/gen_delta_ota.py 生成
+//     DeltaPatchHeader
+//     操作序列，直到输出 target_size 字节:
+//         kDeltaPatchCopy   4u source_offset, 4u size    从正在运行的固件复制
+//         kDeltaPatchInsert 4u size, data[size]          插入新数据
+#define DELTA_PATCH_MAGIC "XZDP"
+#define DELTA_PATCH_VERSION 1
+
+struct DeltaPatchHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t source_size;
+    uint32_t target_size;
+    uint8_t source_sha256[32];
+    uint8_t target_sha256[32];
+} __attribute__((packed));
+
+enum DeltaPatchOp : uint8_t {
+    kDeltaPatchCopy = 1,
+    kDeltaPatchInsert = 2,
+};
+
+// 流式解析补丁，数据可以按任意大小分段输入，不需要缓存整个补丁
+class DeltaPatch {
+public:
+    // 收到头部时调用，可以在这里校验源固件
+    void OnHeader(std::function<bool(const DeltaPatchHeader& header)> callback) { on_header_ = callback; }
+    void OnCopy(std::function<bool(size_t source_offset, size_t size)> callback) { on_copy_ = callback; }
+    void OnInsert(std::function<bool(const char* data, size_t size)> callback) { on_insert_ = callback; }
+
+    // 补丁格式错误或者回调返回 false 时返回 false，之后不能再继续输入
+    bool Feed(const char* data, size_t size);
+    bool IsComplete() const { return state_ != kStateHeader && output_size_ == header_.target_size; }
+    const DeltaPatchHeader& header() const { return header_; }
+
+private:
+    enum State {
+        kStateHeader,
+        kStateOp,
+        kStateInsert,
+        kStateError,
+    };
+
+    State state_ = kStateHeader;
+    DeltaPatchHeader header_ = {};
+    // 头部和操作参数可能被分段，凑齐之后再解析
+    uint8_t pending_[sizeof(DeltaPatchHeader)];
+    size_t pending_size_ = 0;
+    size_t insert_remaining_ = 0;
+    size_t output_size_ = 0;
+
+    std::function<bool(const DeltaPatchHeader& header)> on_header_;
+    std::function<bool(size_t source_offset, size_t size)> on_copy_;
+    std::function<bool(const char* data, size_t size)> on_insert_;
+
+    bool Fill(const char*& data, size_t& size, size_t needed);
+    bool ParseHeader();
+    bool ParseOp();
+};
+
+#endif // _DELTA_PATCH_H_
@@ -0,0 +1,121 @@
+#include "chat_history.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "ChatHistory"
+
+// 没有 PSRAM 时每个缓冲区内部内存最多使用的字节数，用户和助手各一个
+#define INTERNAL_BUDGET_BYTES 1024
+
+ChatHistory::ChatHistory(size_t budget_bytes, size_t max_messages)
+    : budget_bytes_(budget_bytes), max_messages_(max_messages) {
+}
+
+ChatHistory::~ChatHistory() {
+    // 界面对象由界面自己销毁，这里不再调用淘汰回调
+    if (buffer_ != nullptr) {
+        heap_caps_free(buffer_);
+    }
+}
+
+// 第一条消息到来时才分配内存，没有屏幕的板子不占用
+bool ChatHistory::Allocate() {
+    if (buffer_ != nullptr) {
+        return true;
+    }
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0) {
+        buffer_ = static_cast<char*>(heap_caps_malloc(budget_bytes_, MALLOC_CAP_SPIRAM));
+    } else {
+        budget_bytes_ = std::min<size_t>(budget_bytes_, INTERNAL_BUDGET_BYTES);
+        buffer_ = static_cast<char*>(heap_caps_malloc(budget_bytes_, MALLOC_CAP_8BIT));
+    }
+    if (buffer_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for chat history", budget_bytes_);
+        return false;
+    }
+    ESP_LOGI(TAG, "Chat history: %u bytes, %u messages", budget_bytes_, max_messages_);
+    return true;
+}
+
+void ChatHistory::EvictOldest() {
+    auto& message = messages_.front();
+    if (on_evict_) {
+        on_evict_(message);
+    }
+    used_bytes_ -= message.size;
+    messages_.pop_front();
+}
+
+// 在最新一条消息之后找一段连续空间，尾部放不下时从缓冲区开头继续，仍然不够就淘汰最旧的消息
+char* ChatHistory::Reserve(size_t size) {
+    while (!messages_.empty()) {
+        auto& oldest = messages_.front();
+        auto& newest = messages_.back();
+        size_t head = oldest.text - buffer_;
+        size_t tail = newest.text - buffer_ + newest.size;
+        if (newest.text >= oldest.text) {
+            if (budget_bytes_ - tail >= size) {
+                return buffer_ + tail;
+            }
+            if (head >= size) {
+                return buffer_;
+            }
+        } else if (head - tail >= size) {
+            return buffer_ + tail;
+        }
+        EvictOldest();
+    }
+    return buffer_;
+}
+
+ChatHistory::Message* ChatHistory::Append(const char* role, const char* text) {
+    if (!Allocate()) {
+        return nullptr;
+    }
+
+    size_t length = strlen(text);
+    if (length + 1 > budget_bytes_) {
+        length = budget_bytes_ - 1;
+        // 不要把多字节字符截成两半
+        while (length > 0 && (text[length] & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    if (messages_.size() >= max_messages_) {
+        EvictOldest();
+    }
+
+    char* dest = Reserve(length + 1);
+    memcpy(dest, text, length);
+    dest[length] = '\0';
+
+    Message message = {};
+    strncpy(message.role, role, sizeof(message.role) - 1);
+    message.text = dest;
+    message.size = length + 1;
+    messages_.push_back(message);
+    used_bytes_ += message.size;
+    return &messages_.back();
+}
+
+void ChatHistory::Clear() {
+    while (!messages_.empty()) {
+        EvictOldest();
+    }
+}
+
+void ChatHistory::RecordLayoutTime(int64_t elapsed_us) {
+    stats_total_us_ += elapsed_us;
+    stats_max_us_ = std::max(stats_max_us_, elapsed_us);
+    if (++stats_count_ < kStatsInterval) {
+        return;
+    }
+    ESP_LOGI(TAG, "%u messages, %u/%u bytes, layout avg %lld us max %lld us", messages_.size(),
+        used_bytes_, budget_bytes_, stats_total_us_ / stats_count_, stats_max_us_);
+    stats_count_ = 0;
+    stats_total_us_ = 0;
+    stats_max_us_ = 0;
+}
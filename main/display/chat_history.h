@@ -0,0 +1,59 @@
+#ifndef CHAT_HISTORY_H
+#define CHAT_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// 聊天记录环形缓冲区
+// 文本保存在一块固定大小的内存中（优先使用 PSRAM），空间或条数不够时淘汰最旧的消息
+// 消息文本在淘汰之前不会移动，界面可以直接引用，不需要再拷贝一份
+class ChatHistory {
+public:
+    struct Message {
+        char role[12];
+        char* text;
+        size_t size;            // 占用的字节数，包含结尾的 0
+        void* user_data;        // 界面为这条消息创建的对象
+    };
+
+    ChatHistory(size_t budget_bytes, size_t max_messages);
+    ~ChatHistory();
+    // 删除拷贝构造函数和赋值运算符
+    ChatHistory(const ChatHistory&) = delete;
+    ChatHistory& operator=(const ChatHistory&) = delete;
+
+    // 被淘汰的消息先交给回调释放界面对象，超出预算的长文本按 UTF-8 字符截断
+    void OnEvict(std::function<void(Message&)> callback) { on_evict_ = callback; }
+    // 失败时（内存不足）返回 nullptr
+    Message* Append(const char* role, const char* text);
+    void Clear();
+
+    size_t count() const { return messages_.size(); }
+    size_t used_bytes() const { return used_bytes_; }
+    size_t budget_bytes() const { return budget_bytes_; }
+
+    // 记录界面排版一条消息的耗时，每 kStatsInterval 条输出一次统计
+    void RecordLayoutTime(int64_t elapsed_us);
+
+private:
+    static constexpr int kStatsInterval = 20;
+
+    char* buffer_ = nullptr;
+    size_t budget_bytes_;
+    size_t max_messages_;
+    size_t used_bytes_ = 0;
+    std::deque<Message> messages_;
+    std::function<void(Message&)> on_evict_;
+
+    int stats_count_ = 0;
+    int64_t stats_total_us_ = 0;
+    int64_t stats_max_us_ = 0;
+
+    bool Allocate();
+    void EvictOldest();
+    char* Reserve(size_t size);
+};
+
+#endif // CHAT_HISTORY_H
@@ -3,6 +3,8 @@
 #include <string>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 #include "display.h"
 #include "board.h"
@@ -14,7 +16,14 @@
 
 #define TAG "Display"
 
-Display::Display() {
+// 状态栏兜底轮询的间隔，状态没有变化时每次翻倍，直到最长间隔
+// 信号强度、电量和 4G 网络状态没有变化事件，最长间隔就是它们在屏幕上的最大延迟
+#define STATUS_POLL_MIN_INTERVAL_MS 1000
+#define STATUS_POLL_MAX_INTERVAL_MS 8000
+
+Display::Display() : update_interval_ms_(STATUS_POLL_MIN_INTERVAL_MS),
+    user_history_(CONFIG_CHAT_HISTORY_SIZE_KB * 1024 / 2, (CONFIG_CHAT_HISTORY_MAX_MESSAGES + 1) / 2),
+    assistant_history_(CONFIG_CHAT_HISTORY_SIZE_KB * 1024 / 2, (CONFIG_CHAT_HISTORY_MAX_MESSAGES + 1) / 2) {
     // Notification timer
     esp_timer_create_args_t notification_timer_args = {
         .callback = [](void *arg) {
@@ -34,7 +43,14 @@ Display::Display() {
     esp_timer_create_args_t update_display_timer_args = {
         .callback = [](void *arg) {
             Display *display = static_cast<Display*>(arg);
+            int interval_ms = display->update_interval_ms_;
+            display->status_changed_ = false;
             display->Update();
+            int next_interval_ms = display->status_changed_ ? STATUS_POLL_MIN_INTERVAL_MS :
+                std::min(interval_ms * 2, STATUS_POLL_MAX_INTERVAL_MS);
+            // 轮询期间 RequestUpdate 已经把间隔改回最短时保留它的值
+            display->update_interval_ms_.compare_exchange_strong(interval_ms, next_interval_ms);
+            display->ScheduleUpdate(display->update_interval_ms_);
         },
         .arg = this,
         .dispatch_method = ESP_TIMER_TASK,
@@ -42,7 +58,7 @@ Display::Display() {
         .skip_unhandled_events = true,
     };
     ESP_ERROR_CHECK(esp_timer_create(&update_display_timer_args, &update_timer_));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(update_timer_, 1000000));
+    ESP_ERROR_CHECK(esp_timer_start_once(update_timer_, update_interval_ms_ * 1000));
 
     // Create a power management lock
     auto ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "display_update", &pm_lock_);
@@ -75,9 +91,151 @@ Display::~Display() {
     if (pm_lock_ != nullptr) {
         esp_pm_lock_delete(pm_lock_);
     }
+
+    if (command_task_ != nullptr) {
+        vTaskDelete(command_task_);
+    }
+    for (auto& pending : pending_commands_) {
+        delete pending.exchange(nullptr);
+    }
+    for (auto& slot : chat_messages_) {
+        delete slot.exchange(nullptr);
+    }
+}
+
+void Display::PostCommand(DisplayCommand* command) {
+    // 第一次提交命令时才创建任务，没有屏幕的板子在 Set* 中已经直接返回，不会走到这里
+    std::call_once(command_task_once_, [this]() {
+        TaskHandle_t task = nullptr;
+        if (xTaskCreate([](void* arg) {
+            Display* display = static_cast<Display*>(arg);
+            display->CommandTask();
+            vTaskDelete(NULL);
+        }, "display_command", 4096, this, 1, &task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create display command task, display updates are dropped");
+            return;
+        }
+        command_task_ = task;
+    });
+    if (command_task_ == nullptr) {
+        delete command;
+        return;
+    }
+
+    command->seq = command_seq_.fetch_add(1);
+    if (command->type == kDisplayCommandChatMessage) {
+        uint32_t index = chat_write_index_.fetch_add(1) % DISPLAY_CHAT_QUEUE_SIZE;
+        auto dropped = chat_messages_[index].exchange(command);
+        if (dropped != nullptr) {
+            ESP_LOGW(TAG, "Chat message queue is full, dropping the oldest message");
+            delete dropped;
+        }
+    } else {
+        delete pending_commands_[command->type].exchange(command);
+    }
+    xTaskNotifyGive(command_task_);
+}
+
+void Display::CommandTask() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        std::vector<DisplayCommand*> commands;
+        // 写入方先分配槽位再放入消息，这里没有取到的消息会在它随后的通知中取走
+        for (auto& slot : chat_messages_) {
+            auto command = slot.exchange(nullptr);
+            if (command != nullptr) {
+                commands.push_back(command);
+            }
+        }
+        for (auto& pending : pending_commands_) {
+            auto command = pending.exchange(nullptr);
+            if (command != nullptr) {
+                commands.push_back(command);
+            }
+        }
+        if (commands.empty()) {
+            continue;
+        }
+        // 状态和通知、表情和图标共用控件，需要按提交顺序执行
+        std::sort(commands.begin(), commands.end(), [](DisplayCommand* a, DisplayCommand* b) {
+            return static_cast<int32_t>(a->seq - b->seq) < 0;
+        });
+
+        {
+            DisplayLockGuard lock(this);
+            for (auto command : commands) {
+                switch (command->type) {
+                case kDisplayCommandStatus:
+                    ApplyStatus(command->text.c_str());
+                    break;
+                case kDisplayCommandNotification:
+                    ApplyNotification(command->text.c_str(), command->duration_ms);
+                    break;
+                case kDisplayCommandEmotion:
+                    ApplyEmotion(command->text.c_str());
+                    break;
+                case kDisplayCommandIcon:
+                    ApplyIcon(command->text.c_str());
+                    break;
+                case kDisplayCommandStatusBar:
+                    ApplyStatusBar();
+                    break;
+                case kDisplayCommandChatMessage:
+                    ApplyChatMessage(command->role.c_str(), command->text.c_str());
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        for (auto command : commands) {
+            delete command;
+        }
+    }
+}
+
+ChatHistory& Display::GetChatHistory(const char* role) {
+    return strcmp(role, "user") == 0 ? user_history_ : assistant_history_;
 }
 
 void Display::SetStatus(const char* status) {
+    if (display_ == nullptr) {
+        return;
+    }
+    PostCommand(new DisplayCommand{kDisplayCommandStatus, 0, status, "", 0});
+}
+
+void Display::ShowNotification(const char* notification, int duration_ms) {
+    if (display_ == nullptr) {
+        return;
+    }
+    PostCommand(new DisplayCommand{kDisplayCommandNotification, 0, notification, "", duration_ms});
+}
+
+void Display::SetEmotion(const char* emotion) {
+    if (display_ == nullptr) {
+        return;
+    }
+    PostCommand(new DisplayCommand{kDisplayCommandEmotion, 0, emotion, "", 0});
+}
+
+void Display::SetIcon(const char* icon) {
+    if (display_ == nullptr) {
+        return;
+    }
+    PostCommand(new DisplayCommand{kDisplayCommandIcon, 0, icon, "", 0});
+}
+
+void Display::SetChatMessage(const char* role, const char* content) {
+    if (display_ == nullptr) {
+        return;
+    }
+    PostCommand(new DisplayCommand{kDisplayCommandChatMessage, 0, content != nullptr ? content : "",
+        role != nullptr ? role : "", 0});
+}
+
+void Display::ApplyStatus(const char* status) {
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
         return;
@@ -91,7 +249,7 @@ void Display::ShowNotification(const std::string &notification, int duration_ms)
     ShowNotification(notification.c_str(), duration_ms);
 }
 
-void Display::ShowNotification(const char* notification, int duration_ms) {
+void Display::ApplyNotification(const char* notification, int duration_ms) {
     DisplayLockGuard lock(this);
     if (notification_label_ == nullptr) {
         return;
@@ -104,65 +262,111 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
-void Display::Update() {
-    auto& board = Board::GetInstance();
-    auto codec = board.GetAudioCodec();
+void Display::ScheduleUpdate(int delay_ms) {
+    // 事件和定时器可能同时重新启动定时器，已经启动时的错误可以忽略
+    esp_timer_stop(update_timer_);
+    esp_timer_start_once(update_timer_, delay_ms * 1000);
+}
 
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
+void Display::RequestUpdate() {
+    update_interval_ms_ = STATUS_POLL_MIN_INTERVAL_MS;
+    ScheduleUpdate(0);
+}
+
+void Display::SetMuted(bool muted) {
+    if (mute_label_ == nullptr || muted_.exchange(muted) == muted) {
+        return;
+    }
+    status_changed_ = true;
+    PostCommand(new DisplayCommand{kDisplayCommandStatusBar, 0, "", "", 0});
+}
+
+void Display::SetBatteryLevel(int level, bool charging, bool discharging) {
+    const char* icon = nullptr;
+    if (charging) {
+        icon = FONT_AWESOME_BATTERY_CHARGING;
+    } else {
+        const char* levels[] = {
+            FONT_AWESOME_BATTERY_EMPTY, // 0-19%
+            FONT_AWESOME_BATTERY_1,    // 20-39%
+            FONT_AWESOME_BATTERY_2,    // 40-59%
+            FONT_AWESOME_BATTERY_3,    // 60-79%
+            FONT_AWESOME_BATTERY_FULL, // 80-99%
+            FONT_AWESOME_BATTERY_FULL, // 100%
+        };
+        icon = levels[std::clamp(level, 0, 100) / 20];
+    }
+    // 低电量提示框只在放电时显示，放电状态变化时即使图标相同也要刷新
+    bool low_battery = strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging;
+    if (battery_label_ == nullptr) {
+        return;
+    }
+    bool icon_changed = battery_icon_.exchange(icon) != icon;
+    bool low_battery_changed = low_battery_.exchange(low_battery) != low_battery;
+    if (!icon_changed && !low_battery_changed) {
+        return;
+    }
+    status_changed_ = true;
+    PostCommand(new DisplayCommand{kDisplayCommandStatusBar, 0, "", "", 0});
+}
 
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
+void Display::SetNetworkIcon(const char* icon) {
+    if (network_label_ == nullptr || icon == nullptr || network_icon_.exchange(icon) == icon) {
+        return;
+    }
+    status_changed_ = true;
+    PostCommand(new DisplayCommand{kDisplayCommandStatusBar, 0, "", "", 0});
+}
+
+// 按最新设置的值刷新状态栏，只修改和屏幕上不同的部分
+void Display::ApplyStatusBar() {
+    DisplayLockGuard lock(this);
+    if (mute_label_ == nullptr) {
+        return;
+    }
+    const char* mute_text = muted_ ? FONT_AWESOME_VOLUME_MUTE : "";
+    if (strcmp(lv_label_get_text(mute_label_), mute_text) != 0) {
+        lv_label_set_text(mute_label_, mute_text);
+    }
+    const char* network_icon = network_icon_;
+    if (network_icon != nullptr && strcmp(lv_label_get_text(network_label_), network_icon) != 0) {
+        lv_label_set_text(network_label_, network_icon);
+    }
+    const char* battery_icon = battery_icon_;
+    if (battery_icon != nullptr && strcmp(lv_label_get_text(battery_label_), battery_icon) != 0) {
+        lv_label_set_text(battery_label_, battery_icon);
+    }
+    if (low_battery_popup_ != nullptr) {
+        if (low_battery_) {
+            if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
+                lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+                auto& app = Application::GetInstance();
+                app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
+            }
+        } else {
+            // Hide the low battery popup when the battery is not empty
+            if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
+                lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+            }
         }
     }
+}
+
+// 兜底轮询，补上没有主动通知的变化（例如电量缓慢下降、信号强度变化）
+void Display::Update() {
+    if (mute_label_ == nullptr) {
+        return;
+    }
+
+    auto& board = Board::GetInstance();
+    SetMuted(board.GetAudioCodec()->output_volume() == 0);
 
     esp_pm_lock_acquire(pm_lock_);
     // 更新电池图标
     int battery_level;
     bool charging, discharging;
-    const char* icon = nullptr;
     if (board.GetBatteryLevel(battery_level, charging, discharging)) {
-        if (charging) {
-            icon = FONT_AWESOME_BATTERY_CHARGING;
-        } else {
-            const char* levels[] = {
-                FONT_AWESOME_BATTERY_EMPTY, // 0-19%
-                FONT_AWESOME_BATTERY_1,    // 20-39%
-                FONT_AWESOME_BATTERY_2,    // 40-59%
-                FONT_AWESOME_BATTERY_3,    // 60-79%
-                FONT_AWESOME_BATTERY_FULL, // 80-99%
-                FONT_AWESOME_BATTERY_FULL, // 100%
-            };
-            icon = levels[battery_level / 20];
-        }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
-
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                    auto& app = Application::GetInstance();
-                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
-            }
-        }
+        SetBatteryLevel(battery_level, charging, discharging);
     }
 
     // 升级固件时，不读取 4G 网络状态，避免占用 UART 资源
@@ -174,19 +378,14 @@ void Display::Update() {
         kDeviceStateListening,
     };
     if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
-        icon = board.GetNetworkStateIcon();
-        if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-            DisplayLockGuard lock(this);
-            network_icon_ = icon;
-            lv_label_set_text(network_label_, network_icon_);
-        }
+        SetNetworkIcon(board.GetNetworkStateIcon());
     }
 
     esp_pm_lock_release(pm_lock_);
 }
 
 
-void Display::SetEmotion(const char* emotion) {
+void Display::ApplyEmotion(const char* emotion) {
     struct Emotion {
         const char* icon;
         const char* text;
@@ -234,7 +433,7 @@ void Display::SetEmotion(const char* emotion) {
     }
 }
 
-void Display::SetIcon(const char* icon) {
+void Display::ApplyIcon(const char* icon) {
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
@@ -242,7 +441,7 @@ void Display::SetIcon(const char* icon) {
     lv_label_set_text(emotion_label_, icon);
 }
 
-void Display::SetChatMessage(const char* role, const char* content) {
+void Display::ApplyChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -5,8 +5,14 @@
 #include <esp_timer.h>
 #include <esp_log.h>
 #include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include <string>
+#include <atomic>
+#include <mutex>
+
+#include "chat_history.h"
 
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
@@ -14,11 +20,34 @@ struct DisplayFonts {
     const lv_font_t* emoji_font = nullptr;
 };
 
+// 界面更新命令，聊天消息按顺序逐条执行，其它命令同一种只保留最新的一条
+enum DisplayCommandType {
+    kDisplayCommandStatus,
+    kDisplayCommandNotification,
+    kDisplayCommandEmotion,
+    kDisplayCommandIcon,
+    kDisplayCommandStatusBar,
+    kDisplayCommandChatMessage,
+    kDisplayCommandCount
+};
+
+// 尚未显示的聊天消息最多保留的条数，超出时丢弃最早的一条
+#define DISPLAY_CHAT_QUEUE_SIZE 8
+
+struct DisplayCommand {
+    DisplayCommandType type;
+    uint32_t seq;
+    std::string text;
+    std::string role;
+    int duration_ms;
+};
+
 class Display {
 public:
     Display();
     virtual ~Display();
 
+    // 以下接口只提交命令，不等待 LVGL 锁，由显示命令任务按提交顺序执行
     virtual void SetStatus(const char* status);
     virtual void ShowNotification(const char* notification, int duration_ms = 3000);
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
@@ -26,6 +55,13 @@ public:
     virtual void SetChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
 
+    // 状态栏由电池、网络和音量的变化事件驱动，内容没有变化时不提交命令
+    virtual void SetBatteryLevel(int level, bool charging, bool discharging);
+    virtual void SetNetworkIcon(const char* icon);
+    virtual void SetMuted(bool muted);
+    // 立即重新读取一次状态，并把兜底轮询的间隔恢复到最短
+    void RequestUpdate();
+
     inline int width() const { return width_; }
     inline int height() const { return height_; }
 
@@ -45,18 +81,52 @@ protected:
     lv_obj_t* chat_message_label_ = nullptr;
     lv_obj_t* low_battery_popup_ = nullptr;
 
-    const char* battery_icon_ = nullptr;
-    const char* network_icon_ = nullptr;
-    bool muted_ = false;
+    // 调用者最新设置的状态栏内容，ApplyStatusBar 读取最新的值，和命令执行的先后无关
+    std::atomic<const char*> battery_icon_ = nullptr;
+    std::atomic<const char*> network_icon_ = nullptr;
+    std::atomic<bool> muted_ = false;
+    std::atomic<bool> low_battery_ = false;
 
     esp_timer_handle_t notification_timer_ = nullptr;
     esp_timer_handle_t update_timer_ = nullptr;
+    // 兜底轮询的间隔，状态没有变化时逐渐拉长；事件可能来自任意任务
+    std::atomic<int> update_interval_ms_;
+    std::atomic<bool> status_changed_ = false;
+
+    // 用户和助手最近的消息各自一个环形缓冲区，各占一半预算，助手的长回复不会把用户的消息挤掉
+    // system 消息是临时提示，不保存
+    ChatHistory user_history_;
+    ChatHistory assistant_history_;
+    ChatHistory& GetChatHistory(const char* role);
 
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
 
     virtual void Update();
+    void ScheduleUpdate(int delay_ms);
+
+    // 在显示命令任务中执行，调用时已经持有 LVGL 锁
+    virtual void ApplyStatus(const char* status);
+    virtual void ApplyNotification(const char* notification, int duration_ms);
+    virtual void ApplyEmotion(const char* emotion);
+    virtual void ApplyIcon(const char* icon);
+    virtual void ApplyChatMessage(const char* role, const char* content);
+    virtual void ApplyStatusBar();
+
+private:
+    // 聊天消息以外的命令每种一个槽位，新命令直接替换尚未执行的旧命令
+    std::atomic<DisplayCommand*> pending_commands_[kDisplayCommandCount] = {};
+    // 聊天消息每条都要显示并记入聊天记录，不能合并，按写入序号轮流放入固定的槽位
+    // 命令任务每次取走所有槽位中的消息再按 seq 排序，写入方覆盖槽位时丢弃的是最早的消息
+    std::atomic<DisplayCommand*> chat_messages_[DISPLAY_CHAT_QUEUE_SIZE] = {};
+    std::atomic<uint32_t> chat_write_index_ = 0;
+    std::atomic<uint32_t> command_seq_ = 0;
+    TaskHandle_t command_task_ = nullptr;
+    std::once_flag command_task_once_;
+
+    void PostCommand(DisplayCommand* command);
+    void CommandTask();
 };
 
 
@@ -0,0 +1,203 @@
+#include "glyph_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+#define TAG "GlyphCache"
+
+// 单个字形超过预算的这个比例时不缓存，避免大字形把缓存冲掉
+#define MAX_GLYPH_BUDGET_DIVISOR 16
+// 平均每个桶对应的预算字节数，16-20 像素的中文字形每个约 300 字节
+#define BUDGET_BYTES_PER_BUCKET 256
+#define MIN_BUCKET_COUNT 16
+
+GlyphCache::GlyphCache() {
+    budget_bytes_ = CONFIG_GLYPH_CACHE_SIZE_KB * 1024;
+    if (budget_bytes_ > 0 && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) == 0) {
+        ESP_LOGI(TAG, "PSRAM not available, glyph cache disabled");
+        budget_bytes_ = 0;
+    }
+}
+
+GlyphCache::~GlyphCache() {
+    RemoveAll();
+    heap_caps_free(buckets_);
+}
+
+const lv_font_t* GlyphCache::Wrap(const lv_font_t* font) {
+    if (font == nullptr || budget_bytes_ == 0 || font->get_glyph_bitmap != lv_font_get_bitmap_fmt_txt) {
+        return font;
+    }
+    auto dsc = static_cast<const lv_font_fmt_txt_dsc_t*>(font->dsc);
+    if (dsc->bitmap_format == LV_FONT_FMT_TXT_PLAIN) {
+        return font;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 副本的 get_glyph_dsc 仍然是原来的实现，会把副本设为 resolved_font，之后取位图时回到这里
+    auto& wrapped = fonts_.emplace_back(*font);
+    wrapped.get_glyph_bitmap = GetGlyphBitmap;
+    ESP_LOGI(TAG, "Caching glyphs of font with line height %d, budget %u bytes", font->line_height, budget_bytes_);
+    return &wrapped;
+}
+
+const void* GlyphCache::GetGlyphBitmap(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf) {
+    auto& cache = GetInstance();
+    uint32_t size = draw_buf->header.stride * g_dsc->box_h;
+    uint64_t key = (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(g_dsc->resolved_font)) << 32) | g_dsc->gid.index;
+    if (size == 0 || size > draw_buf->data_size) {
+        return lv_font_get_bitmap_fmt_txt(g_dsc, draw_buf);
+    }
+    if (cache.Lookup(key, draw_buf, size)) {
+        return draw_buf;
+    }
+
+    auto result = lv_font_get_bitmap_fmt_txt(g_dsc, draw_buf);
+    if (result == draw_buf) {
+        cache.Insert(key, draw_buf, size);
+    }
+    return result;
+}
+
+bool GlyphCache::Lookup(uint64_t key, lv_draw_buf_t* draw_buf, uint32_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = buckets_ != nullptr ? *FindSlot(key) : nullptr;
+    if (entry == nullptr || entry->size != size || entry->stride != draw_buf->header.stride) {
+        misses_++;
+        return false;
+    }
+    hits_++;
+    UnlinkLru(entry);
+    PushFront(entry);
+    memcpy(draw_buf->data, entry->data(), size);
+    return true;
+}
+
+void GlyphCache::Insert(uint64_t key, const lv_draw_buf_t* draw_buf, uint32_t size) {
+    if (size > budget_bytes_ / MAX_GLYPH_BUDGET_DIVISOR) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!AllocateBuckets()) {
+        return;
+    }
+    Entry* old = *FindSlot(key);
+    if (old != nullptr) {
+        // 同一个字形换了 stride，丢掉旧的
+        Remove(old);
+    }
+    size_t total = sizeof(Entry) + size;
+    while (used_bytes_ + total > budget_bytes_ && lru_tail_ != nullptr) {
+        Remove(lru_tail_);
+        evictions_++;
+    }
+    if (used_bytes_ + total > budget_bytes_) {
+        return;
+    }
+
+    auto entry = static_cast<Entry*>(heap_caps_malloc(total, MALLOC_CAP_SPIRAM));
+    if (entry == nullptr) {
+        return;
+    }
+    entry->key = key;
+    entry->size = size;
+    entry->stride = draw_buf->header.stride;
+    memcpy(entry->data(), draw_buf->data, size);
+    Entry** slot = FindSlot(key);
+    entry->hash_next = nullptr;
+    *slot = entry;
+    PushFront(entry);
+    used_bytes_ += total;
+    entry_count_++;
+}
+
+// 哈希表也放在 PSRAM 中并计入预算
+bool GlyphCache::AllocateBuckets() {
+    if (buckets_ != nullptr) {
+        return true;
+    }
+    size_t count = MIN_BUCKET_COUNT;
+    while (count * 2 <= budget_bytes_ / BUDGET_BYTES_PER_BUCKET) {
+        count *= 2;
+    }
+    buckets_ = static_cast<Entry**>(heap_caps_calloc(count, sizeof(Entry*), MALLOC_CAP_SPIRAM));
+    if (buckets_ == nullptr) {
+        return false;
+    }
+    bucket_count_ = count;
+    used_bytes_ += count * sizeof(Entry*);
+    return true;
+}
+
+// 返回指向 key 对应条目的指针的地址，没有时指向哈希链末尾的空指针，可以直接在这里插入或摘除
+GlyphCache::Entry** GlyphCache::FindSlot(uint64_t key) {
+    // 低位是字形编号，高位是字体地址
+    uint32_t hash = static_cast<uint32_t>(key) ^ static_cast<uint32_t>(key >> 32);
+    Entry** slot = &buckets_[hash & (bucket_count_ - 1)];
+    while (*slot != nullptr && (*slot)->key != key) {
+        slot = &(*slot)->hash_next;
+    }
+    return slot;
+}
+
+void GlyphCache::Remove(Entry* entry) {
+    Entry** slot = FindSlot(entry->key);
+    *slot = entry->hash_next;
+    UnlinkLru(entry);
+    used_bytes_ -= sizeof(Entry) + entry->size;
+    entry_count_--;
+    heap_caps_free(entry);
+}
+
+void GlyphCache::RemoveAll() {
+    while (lru_tail_ != nullptr) {
+        Remove(lru_tail_);
+    }
+}
+
+void GlyphCache::PushFront(Entry* entry) {
+    entry->lru_prev = nullptr;
+    entry->lru_next = lru_head_;
+    if (lru_head_ != nullptr) {
+        lru_head_->lru_prev = entry;
+    } else {
+        lru_tail_ = entry;
+    }
+    lru_head_ = entry;
+}
+
+void GlyphCache::UnlinkLru(Entry* entry) {
+    if (entry->lru_prev != nullptr) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        lru_head_ = entry->lru_next;
+    }
+    if (entry->lru_next != nullptr) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        lru_tail_ = entry->lru_prev;
+    }
+}
+
+void GlyphCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RemoveAll();
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+}
+
+GlyphCacheStats GlyphCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return GlyphCacheStats{
+        .entries = entry_count_,
+        .used_bytes = used_bytes_,
+        .metadata_bytes = entry_count_ * sizeof(Entry) + bucket_count_ * sizeof(Entry*),
+        .budget_bytes = budget_bytes_,
+        .hits = hits_,
+        .misses = misses_,
+        .evictions = evictions_,
+    };
+}
@@ -0,0 +1,85 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <lvgl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+
+struct GlyphCacheStats {
+    size_t entries;
+    size_t used_bytes;          // 位图、条目头部和哈希表，全部在 PSRAM 中，计入预算
+    size_t metadata_bytes;      // used_bytes 中条目头部和哈希表占用的部分
+    size_t budget_bytes;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+};
+
+// 压缩字体（中文字库）解压后的字形缓存，数据放在 PSRAM 中，按最近最少使用淘汰
+// 通过替换字体的 get_glyph_bitmap 接入 LVGL，命中时直接拷贝解压好的 A8 位图
+class GlyphCache {
+public:
+    static GlyphCache& GetInstance() {
+        static GlyphCache instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    // 返回带缓存的字体副本，字体没有压缩或者缓存被禁用时返回原字体
+    const lv_font_t* Wrap(const lv_font_t* font);
+    // 释放所有缓存的字形并清零统计，字体副本保持有效
+    void Clear();
+
+    GlyphCacheStats GetStats();
+
+private:
+    GlyphCache();
+    ~GlyphCache();
+
+    // 条目头部和位图在同一块 PSRAM 中分配，位图紧跟在头部之后
+    // LRU 链表和哈希链都是侵入式的，内部内存不随条目数量增长
+    struct Entry {
+        uint64_t key;
+        Entry* lru_prev;
+        Entry* lru_next;
+        Entry* hash_next;
+        uint32_t size;
+        uint32_t stride;
+
+        uint8_t* data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+
+    std::mutex mutex_;
+    size_t budget_bytes_ = 0;
+    size_t used_bytes_ = 0;
+    size_t entry_count_ = 0;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+    uint32_t evictions_ = 0;
+    // 最近使用的在前面
+    Entry* lru_head_ = nullptr;
+    Entry* lru_tail_ = nullptr;
+    // 第一次插入时分配，桶的数量是 2 的幂
+    Entry** buckets_ = nullptr;
+    size_t bucket_count_ = 0;
+    // 字体副本的地址必须保持不变
+    std::list<lv_font_t> fonts_;
+
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf);
+    bool Lookup(uint64_t key, lv_draw_buf_t* draw_buf, uint32_t size);
+    void Insert(uint64_t key, const lv_draw_buf_t* draw_buf, uint32_t size);
+
+    bool AllocateBuckets();
+    Entry** FindSlot(uint64_t key);
+    void Remove(Entry* entry);
+    void RemoveAll();
+    void PushFront(Entry* entry);
+    void UnlinkLru(Entry* entry);
+};
+
+#endif // GLYPH_CACHE_H
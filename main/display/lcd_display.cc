@@ -5,12 +5,20 @@
 #include <esp_log.h>
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cstring>
 #include "assets/lang_config.h"
 
 #include "board.h"
 
 #define TAG "LcdDisplay"
 
+// 清屏时每次传输的最大字节数
+#define FILL_BLOCK_SIZE (16 * 1024)
+// 帧率统计的输出间隔
+#define RENDER_STATS_INTERVAL_US (5 * 1000 * 1000)
+
 LV_FONT_DECLARE(font_awesome_30_4);
 
 SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
@@ -21,10 +29,7 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     height_ = height;
 
     // draw white
-    std::vector<uint16_t> buffer(width_, 0xFFFF);
-    for (int y = 0; y < height_; y++) {
-        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + 1, buffer.data());
-    }
+    FillPanel(0xFFFF);
 
     // Set the display to on
     ESP_LOGI(TAG, "Turning display on");
@@ -38,14 +43,31 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     port_cfg.task_priority = 1;
     lvgl_port_init(&port_cfg);
 
-    ESP_LOGI(TAG, "Adding LCD screen");
+    // 缓冲区可以直接 DMA 时，esp_lvgl_port 在它注册的 on_color_trans_done 回调里通知 LVGL 刷新完成，
+    // 双缓冲时传输期间 LVGL 继续绘制另一块缓冲区
+#if CONFIG_LCD_RENDER_PROFILE_PSRAM
+    // PSRAM 不能直接用于 DMA，esp_lvgl_port 在刷新回调中分段拷贝到内部 DMA 内存，
+    // 每段发送完成后才拷贝下一段，整块发送完才通知 LVGL，传输和绘制不能并行
+    uint32_t buffer_size = width_ * std::max(height_ / 4, 10);
+    bool double_buffer = true;
+    uint32_t trans_size = width_ * 10;
+#elif CONFIG_LCD_RENDER_PROFILE_BALANCED
+    uint32_t buffer_size = width_ * 20;
+    bool double_buffer = true;
+    uint32_t trans_size = 0;
+#else
+    uint32_t buffer_size = width_ * 10;
+    bool double_buffer = false;
+    uint32_t trans_size = 0;
+#endif
+    ESP_LOGI(TAG, "Adding LCD screen, buffer %lu pixels x%d", buffer_size, double_buffer ? 2 : 1);
     const lvgl_port_display_cfg_t display_cfg = {
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 10),
-        .double_buffer = false,
-        .trans_size = 0,
+        .buffer_size = buffer_size,
+        .double_buffer = double_buffer,
+        .trans_size = trans_size,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
         .monochrome = false,
@@ -56,8 +78,8 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         },
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
+            .buff_dma = trans_size == 0,
+            .buff_spiram = trans_size != 0,
             .sw_rotate = 0,
             .swap_bytes = 1,
             .full_refresh = 0,
@@ -75,6 +97,9 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         lv_display_set_offset(display_, offset_x, offset_y);
     }
 
+#if CONFIG_LCD_RENDER_STATS
+    StartRenderStats();
+#endif
     SetupUI();
 }
 
@@ -88,10 +113,7 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
     height_ = height;
     
     // draw white
-    std::vector<uint16_t> buffer(width_, 0xFFFF);
-    for (int y = 0; y < height_; y++) {
-        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + 1, buffer.data());
-    }
+    FillPanel(0xFFFF);
 
     ESP_LOGI(TAG, "Initialize LVGL library");
     lv_init();
@@ -168,6 +190,57 @@ LcdDisplay::~LcdDisplay() {
     }
 }
 
+void LcdDisplay::FillPanel(uint16_t color) {
+    int lines = std::clamp<int>(FILL_BLOCK_SIZE / (width_ * sizeof(uint16_t)), 1, height_);
+    size_t pixels = width_ * lines;
+    auto buffer = static_cast<uint16_t*>(heap_caps_malloc(pixels * sizeof(uint16_t), MALLOC_CAP_DMA));
+    if (buffer == nullptr) {
+        ESP_LOGW(TAG, "Failed to allocate fill buffer, filling line by line");
+        std::vector<uint16_t> line(width_, color);
+        for (int y = 0; y < height_; y++) {
+            esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, y + 1, line.data());
+        }
+        return;
+    }
+
+    std::fill(buffer, buffer + pixels, color);
+    for (int y = 0; y < height_; y += lines) {
+        esp_lcd_panel_draw_bitmap(panel_, 0, y, width_, std::min(y + lines, height_), buffer);
+    }
+    // SPI 的颜色数据是排队异步发送的，发送一条同步命令等待队列清空后才能释放缓冲区
+    esp_lcd_panel_io_tx_param(panel_io_, -1, nullptr, 0);
+    heap_caps_free(buffer);
+}
+
+#if CONFIG_LCD_RENDER_STATS
+void LcdDisplay::StartRenderStats() {
+    // 事件在 LVGL 任务中触发，统计数据不需要加锁
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        self->render_start_us_ = esp_timer_get_time();
+    }, LV_EVENT_RENDER_START, this);
+    lv_display_add_event_cb(display_, [](lv_event_t* e) {
+        auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+        int64_t now = esp_timer_get_time();
+        int64_t elapsed = now - self->render_start_us_;
+        self->render_total_us_ += elapsed;
+        self->render_max_us_ = std::max(self->render_max_us_, elapsed);
+        self->render_frames_++;
+        if (self->stats_start_us_ == 0) {
+            self->stats_start_us_ = now;
+        } else if (now - self->stats_start_us_ >= RENDER_STATS_INTERVAL_US) {
+            ESP_LOGI(TAG, "%dx%d: %.1f fps, render avg %lld us max %lld us", self->width_, self->height_,
+                self->render_frames_ * 1000000.0f / (now - self->stats_start_us_),
+                self->render_total_us_ / self->render_frames_, self->render_max_us_);
+            self->stats_start_us_ = now;
+            self->render_total_us_ = 0;
+            self->render_max_us_ = 0;
+            self->render_frames_ = 0;
+        }
+    }, LV_EVENT_RENDER_READY, this);
+}
+#endif
+
 bool LcdDisplay::Lock(int timeout_ms) {
     return lvgl_port_lock(timeout_ms);
 }
@@ -216,6 +289,25 @@ void LcdDisplay::SetupUI() {
     lv_label_set_long_mode(chat_message_label_, LV_LABEL_LONG_WRAP); // 设置为自动换行模式
     lv_obj_set_style_text_align(chat_message_label_, LV_TEXT_ALIGN_CENTER, 0); // 设置文本居中对齐
 
+    // 聊天记录，每条消息一个标签，超出高度时滚动到最新的消息
+    chat_list_ = lv_obj_create(content_);
+    lv_obj_set_size(chat_list_, LV_HOR_RES * 0.9, LV_SIZE_CONTENT);
+    lv_obj_set_style_max_height(chat_list_, LV_PCT(70), 0);
+    lv_obj_set_flex_flow(chat_list_, LV_FLEX_FLOW_COLUMN);
+    lv_obj_set_style_pad_all(chat_list_, 0, 0);
+    lv_obj_set_style_pad_row(chat_list_, 4, 0);
+    lv_obj_set_style_border_width(chat_list_, 0, 0);
+    lv_obj_set_style_bg_opa(chat_list_, LV_OPA_TRANSP, 0);
+    lv_obj_set_scrollbar_mode(chat_list_, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_add_flag(chat_list_, LV_OBJ_FLAG_HIDDEN);
+    auto on_evict = [](ChatHistory::Message& message) {
+        if (message.user_data != nullptr) {
+            lv_obj_del(static_cast<lv_obj_t*>(message.user_data));
+        }
+    };
+    user_history_.OnEvict(on_evict);
+    assistant_history_.OnEvict(on_evict);
+
     /* Status bar */
     lv_obj_set_flex_flow(status_bar_, LV_FLEX_FLOW_ROW);
     lv_obj_set_style_pad_all(status_bar_, 0, 0);
@@ -260,7 +352,7 @@ void LcdDisplay::SetupUI() {
     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
 }
 
-void LcdDisplay::SetEmotion(const char* emotion) {
+void LcdDisplay::ApplyEmotion(const char* emotion) {
     struct Emotion {
         const char* icon;
         const char* text;
@@ -309,7 +401,42 @@ void LcdDisplay::SetEmotion(const char* emotion) {
     }
 }
 
-void LcdDisplay::SetIcon(const char* icon) {
+void LcdDisplay::ApplyChatMessage(const char* role, const char* content) {
+    DisplayLockGuard lock(this);
+    if (chat_list_ == nullptr) {
+        return;
+    }
+
+    // system 消息和清空操作只使用单独的提示标签，聊天记录先隐藏起来
+    if (strcmp(role, "system") == 0 || content[0] == '\0') {
+        lv_label_set_text(chat_message_label_, content);
+        lv_obj_add_flag(chat_list_, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(chat_message_label_, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    auto& history = GetChatHistory(role);
+    auto message = history.Append(role, content);
+    if (message == nullptr) {
+        return;
+    }
+    // 新消息单独创建标签，直接引用聊天记录中的文本，之前的消息不需要重新排版
+    lv_obj_t* label = lv_label_create(chat_list_);
+    lv_obj_set_width(label, LV_PCT(100));
+    lv_label_set_long_mode(label, LV_LABEL_LONG_WRAP);
+    lv_obj_set_style_text_align(label, LV_TEXT_ALIGN_CENTER, 0);
+    lv_label_set_text_static(label, message->text);
+    message->user_data = label;
+
+    lv_obj_add_flag(chat_message_label_, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_clear_flag(chat_list_, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_update_layout(chat_list_);
+    lv_obj_scroll_to_view(label, LV_ANIM_OFF);
+    history.RecordLayoutTime(esp_timer_get_time() - start_time);
+}
+
+void LcdDisplay::ApplyIcon(const char* icon) {
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
         return;
@@ -2,6 +2,7 @@
 #define LCD_DISPLAY_H
 
 #include "display.h"
+#include "glyph_cache.h"
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
@@ -19,6 +20,7 @@ protected:
     lv_obj_t* content_ = nullptr;
     lv_obj_t* container_ = nullptr;
     lv_obj_t* side_bar_ = nullptr;
+    lv_obj_t* chat_list_ = nullptr;
 
     DisplayFonts fonts_;
 
@@ -26,15 +28,32 @@ protected:
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
+    // 用一块 DMA 内存分块填充整个面板，替代逐行绘制
+    void FillPanel(uint16_t color);
+
+#if CONFIG_LCD_RENDER_STATS
+    int64_t render_start_us_ = 0;
+    int64_t stats_start_us_ = 0;
+    int64_t render_total_us_ = 0;
+    int64_t render_max_us_ = 0;
+    int render_frames_ = 0;
+    void StartRenderStats();
+#endif
+
 protected:
     // 添加protected构造函数
+    // 中文字库是压缩的，通过字形缓存避免每次绘制都重新解压
     LcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel, DisplayFonts fonts)
-        : panel_io_(panel_io), panel_(panel), fonts_(fonts) {}
+        : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
+        fonts_.text_font = GlyphCache::GetInstance().Wrap(fonts_.text_font);
+    }
     
+    virtual void ApplyEmotion(const char* emotion) override;
+    virtual void ApplyIcon(const char* icon) override;
+    virtual void ApplyChatMessage(const char* role, const char* content) override;
+
 public:
     ~LcdDisplay();
-    virtual void SetEmotion(const char* emotion) override;
-    virtual void SetIcon(const char* icon) override;
 };
 
 // RGB LCD显示器
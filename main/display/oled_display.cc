@@ -1,9 +1,11 @@
 #include "oled_display.h"
+#include "glyph_cache.h"
 #include "font_awesome_symbols.h"
 #include "assets/lang_config.h"
 
 #include <string>
 #include <algorithm>
+#include <cstring>
 
 #include <esp_log.h>
 #include <esp_err.h>
@@ -11,13 +13,19 @@
 
 #define TAG "OledDisplay"
 
+// 刷新统计的输出间隔
+#define FLUSH_STATS_INTERVAL_US (60 * 1000 * 1000)
+
 LV_FONT_DECLARE(font_awesome_30_1);
 
+OledDisplay* OledDisplay::flush_instance_ = nullptr;
+
 OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handle_t panel,
     int width, int height, bool mirror_x, bool mirror_y, DisplayFonts fonts)
     : panel_io_(panel_io), panel_(panel), fonts_(fonts) {
     width_ = width;
     height_ = height;
+    fonts_.text_font = GlyphCache::GetInstance().Wrap(fonts_.text_font);
 
     ESP_LOGI(TAG, "Initialize LVGL");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
@@ -55,6 +63,24 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
         return;
     }
 
+    // 替换 esp_lvgl_port 的整屏刷新，第一次刷新时面板内容未知，发送整屏
+    frame_.resize(width_ * height_ / 8);
+    shown_.resize(frame_.size());
+    flush_instance_ = this;
+    {
+        DisplayLockGuard lock(this);
+        lv_display_set_flush_cb(display_, [](lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+            flush_instance_->Flush(area, px_map);
+            lv_display_flush_ready(disp);
+        });
+    }
+    // esp_lvgl_port 在面板 IO 的传输完成回调里通知 LVGL 刷新完成，每页发送一次就会通知一次，
+    // I2C 的发送是同步的，所有页发送完后由上面的刷新回调通知一次，去掉面板 IO 的回调
+    const esp_lcd_panel_io_callbacks_t io_callbacks = {
+        .on_color_trans_done = nullptr,
+    };
+    esp_lcd_panel_io_register_event_callbacks(panel_io_, &io_callbacks, nullptr);
+
     if (height_ == 64) {
         SetupUI_128x64();
     } else {
@@ -83,6 +109,71 @@ OledDisplay::~OledDisplay() {
         esp_lcd_panel_io_del(panel_io_);
     }
     lvgl_port_deinit();
+    flush_instance_ = nullptr;
+}
+
+void OledDisplay::Flush(const lv_area_t* area, const uint8_t* px_map) {
+    // 与 esp_lvgl_port 的单色转换一致：绘制缓冲区是整屏 RGB565，亮色为熄灭的像素
+    auto colors = reinterpret_cast<const uint16_t*>(px_map);
+    for (int y = area->y1; y <= area->y2; y++) {
+        uint8_t mask = 1 << (y % 8);
+        uint8_t* page = frame_.data() + width_ * (y / 8);
+        for (int x = area->x1; x <= area->x2; x++) {
+            bool bright = (colors[width_ * y + x] & 0x1F) > 16;
+            if (bright) {
+                page[x] &= ~mask;
+            } else {
+                page[x] |= mask;
+            }
+        }
+    }
+
+    // 面板内容未知时（第一次刷新）发送整屏
+    lv_area_t dirty = *area;
+    if (!shown_valid_) {
+        dirty = {0, 0, width_ - 1, height_ - 1};
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    size_t bytes = 0;
+    for (int page = dirty.y1 / 8; page <= dirty.y2 / 8; page++) {
+        const uint8_t* data = frame_.data() + width_ * page;
+        uint8_t* shown = shown_.data() + width_ * page;
+        int x1 = dirty.x1;
+        int x2 = dirty.x2;
+        if (shown_valid_) {
+            while (x1 <= x2 && data[x1] == shown[x1]) {
+                x1++;
+            }
+            while (x2 >= x1 && data[x2] == shown[x2]) {
+                x2--;
+            }
+            if (x1 > x2) {
+                continue;
+            }
+        }
+        esp_lcd_panel_draw_bitmap(panel_, x1, page * 8, x2 + 1, page * 8 + 8, data + x1);
+        memcpy(shown + x1, data + x1, x2 - x1 + 1);
+        bytes += x2 - x1 + 1;
+    }
+    shown_valid_ = true;
+
+    // 统计每次刷新发送的字节数和 I2C 总线占用时间
+    int64_t now = esp_timer_get_time();
+    flush_count_++;
+    bytes_sent_ += bytes;
+    bus_busy_us_ += now - start_time;
+    if (stats_start_us_ == 0) {
+        stats_start_us_ = now;
+    } else if (now - stats_start_us_ >= FLUSH_STATS_INTERVAL_US) {
+        ESP_LOGI(TAG, "%lu flushes, %u bytes per flush (full screen %u), bus busy %lld.%lld%%", flush_count_,
+            bytes_sent_ / flush_count_, frame_.size(), bus_busy_us_ * 100 / (now - stats_start_us_),
+            bus_busy_us_ * 1000 / (now - stats_start_us_) % 10);
+        flush_count_ = 0;
+        bytes_sent_ = 0;
+        bus_busy_us_ = 0;
+        stats_start_us_ = now;
+    }
 }
 
 bool OledDisplay::Lock(int timeout_ms) {
@@ -93,25 +184,24 @@ void OledDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
-void OledDisplay::SetChatMessage(const char* role, const char* content) {
+void OledDisplay::ApplyChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
     }
 
+    if (content_right_ != nullptr && content[0] == '\0') {
+        lv_obj_add_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    // 屏幕只显示最新的一条，不保存聊天记录，聊天记录的缓冲区在第一次使用时才分配，OLED 上不会分配
     // Replace all newlines with spaces
     std::string content_str = content;
     std::replace(content_str.begin(), content_str.end(), '\n', ' ');
-
-    if (content_right_ == nullptr) {
-        lv_label_set_text(chat_message_label_, content_str.c_str());
-    } else {
-        if (content == nullptr || content[0] == '\0') {
-            lv_obj_add_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
-        } else {
-            lv_label_set_text(chat_message_label_, content_str.c_str());
-            lv_obj_clear_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
-        }
+    lv_label_set_text(chat_message_label_, content_str.c_str());
+    if (content_right_ != nullptr) {
+        lv_obj_clear_flag(content_right_, LV_OBJ_FLAG_HIDDEN);
     }
 }
 
@@ -6,6 +6,8 @@
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
 
+#include <vector>
+
 class OledDisplay : public Display {
 private:
     esp_lcd_panel_io_handle_t panel_io_ = nullptr;
@@ -20,9 +22,24 @@ private:
 
     DisplayFonts fonts_;
 
+    // 按页排列的 1 位像素（每页 8 行，每字节一列），frame_ 是最新画面，shown_ 是面板上的内容
+    // 刷新时逐页比较，只发送有变化的列范围，I2C 总线通常还要和 codec、电源芯片共用
+    std::vector<uint8_t> frame_;
+    std::vector<uint8_t> shown_;
+    bool shown_valid_ = false;
+    uint32_t flush_count_ = 0;
+    size_t bytes_sent_ = 0;
+    int64_t bus_busy_us_ = 0;
+    int64_t stats_start_us_ = 0;
+
+    // 显示对象的 user_data 是 esp_lvgl_port 的上下文，刷新回调通过这个指针找到 OledDisplay，每块板子只有一个 OLED
+    static OledDisplay* flush_instance_;
+
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
+    void Flush(const lv_area_t* area, const uint8_t* px_map);
+
     void SetupUI_128x64();
     void SetupUI_128x32();
 
@@ -31,7 +48,8 @@ public:
                 DisplayFonts fonts);
     ~OledDisplay();
 
-    virtual void SetChatMessage(const char* role, const char* content) override;
+protected:
+    virtual void ApplyChatMessage(const char* role, const char* content) override;
 };
 
 #endif // OLED_DISPLAY_H
@@ -0,0 +1,250 @@
+#include "latency_tracker.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+#include <cstdio>
+#include <cstdlib>
+
+#define TAG "LatencyTracker"
+
+static const char* const STAGE_NAMES[kLatencyStageCount] = {
+    "wake_to_open",
+    "channel_open",
+    "open_to_uplink",
+    "server_response",
+    "first_downlink",
+    "playback_start",
+    "speaking",
+};
+
+// 每个阶段的起止时间点
+static const LatencyMarker STAGE_MARKERS[kLatencyStageCount][2] = {
+    {kLatencyMarkerWakeWord, kLatencyMarkerChannelOpenStart},
+    {kLatencyMarkerChannelOpenStart, kLatencyMarkerChannelOpenEnd},
+    {kLatencyMarkerChannelOpenEnd, kLatencyMarkerFirstUplink},
+    {kLatencyMarkerListenStop, kLatencyMarkerTtsStart},
+    {kLatencyMarkerTtsStart, kLatencyMarkerFirstDownlink},
+    {kLatencyMarkerFirstDownlink, kLatencyMarkerFirstPlayback},
+    {kLatencyMarkerFirstPlayback, kLatencyMarkerTtsStop},
+};
+
+// 直方图桶的上界（毫秒），最后一个桶收集所有更大的值
+static const uint32_t BUCKET_LIMITS_MS[LATENCY_HISTOGRAM_BUCKETS - 1] = {
+    50, 100, 200, 400, 800, 1600, 3200
+};
+
+void LatencyHistogram::Add(uint32_t ms) {
+    int bucket = 0;
+    while (bucket < LATENCY_HISTOGRAM_BUCKETS - 1 && ms >= BUCKET_LIMITS_MS[bucket]) {
+        bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    total_ms += ms;
+    if (ms > max_ms) {
+        max_ms = ms;
+    }
+}
+
+LatencyTracker::LatencyTracker() {
+    for (auto& mark : marks_) {
+        mark.store(0);
+    }
+    Load();
+}
+
+void LatencyTracker::Mark(LatencyMarker marker) {
+    if (marker == kLatencyMarkerWakeWord) {
+        Reset();
+    }
+    marks_[marker].store(esp_timer_get_time());
+}
+
+void LatencyTracker::MarkOnce(LatencyMarker marker) {
+    int64_t expected = 0;
+    marks_[marker].compare_exchange_strong(expected, esp_timer_get_time());
+}
+
+bool LatencyTracker::IsMarked(LatencyMarker marker) const {
+    return marks_[marker].load() != 0;
+}
+
+void LatencyTracker::Reset() {
+    for (auto& mark : marks_) {
+        mark.store(0);
+    }
+}
+
+// response 覆盖的阶段
+static const LatencyStage RESPONSE_STAGES[] = {
+    kLatencyStageServerResponse,
+    kLatencyStageFirstDownlink,
+    kLatencyStagePlaybackStart,
+};
+
+LatencyTurn LatencyTracker::ComputeTurn(const int64_t marks[kLatencyMarkerCount]) {
+    LatencyTurn turn;
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        int64_t start = marks[STAGE_MARKERS[i][0]];
+        int64_t end = marks[STAGE_MARKERS[i][1]];
+        turn.stage_ms[i] = (start == 0 || end == 0 || end < start) ? -1 : end / 1000 - start / 1000;
+    }
+
+    int64_t start = marks[kLatencyMarkerListenStop];
+    int64_t end = marks[kLatencyMarkerFirstPlayback];
+    if (start == 0 || end == 0 || end < start) {
+        return turn;
+    }
+    turn.response_ms = end / 1000 - start / 1000;
+    turn.unaccounted_ms = turn.response_ms;
+    for (auto stage : RESPONSE_STAGES) {
+        if (turn.stage_ms[stage] >= 0) {
+            turn.unaccounted_ms -= turn.stage_ms[stage];
+        }
+    }
+    return turn;
+}
+
+std::string LatencyTracker::FinishTurn() {
+    int64_t marks[kLatencyMarkerCount];
+    for (int i = 0; i < kLatencyMarkerCount; i++) {
+        marks[i] = marks_[i].exchange(0);
+    }
+    auto turn = ComputeTurn(marks);
+
+    cJSON* root = cJSON_CreateObject();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        if (turn.stage_ms[i] < 0) {
+            continue;
+        }
+        histograms_[i].Add(turn.stage_ms[i]);
+        cJSON_AddNumberToObject(root, STAGE_NAMES[i], turn.stage_ms[i]);
+        dirty_ = true;
+    }
+
+    // 中间的时间点缺失或者乱序（例如音频先于 tts start 到达）时，各阶段之和不等于总耗时，
+    // 差值单独上报，服务端不需要自己去对账
+    if (turn.response_ms >= 0) {
+        cJSON_AddNumberToObject(root, "response", turn.response_ms);
+        if (turn.unaccounted_ms != 0) {
+            cJSON_AddNumberToObject(root, "unaccounted", turn.unaccounted_ms);
+            ESP_LOGW(TAG, "Turn response latency: %ld ms, %ld ms not covered by stages",
+                (long)turn.response_ms, (long)turn.unaccounted_ms);
+        } else {
+            ESP_LOGI(TAG, "Turn response latency: %ld ms", (long)turn.response_ms);
+        }
+    }
+
+    std::string json;
+    if (cJSON_GetArraySize(root) > 0) {
+        char* str = cJSON_PrintUnformatted(root);
+        json = str;
+        cJSON_free(str);
+    }
+    cJSON_Delete(root);
+    return json;
+}
+
+std::string LatencyTracker::GetHistogramsJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cJSON* root = cJSON_CreateObject();
+    cJSON* limits = cJSON_CreateArray();
+    for (auto limit : BUCKET_LIMITS_MS) {
+        cJSON_AddItemToArray(limits, cJSON_CreateNumber(limit));
+    }
+    cJSON_AddItemToObject(root, "bucket_limits_ms", limits);
+
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        auto& histogram = histograms_[i];
+        if (histogram.count == 0) {
+            continue;
+        }
+        cJSON* stage = cJSON_CreateObject();
+        cJSON* buckets = cJSON_CreateArray();
+        for (auto bucket : histogram.buckets) {
+            cJSON_AddItemToArray(buckets, cJSON_CreateNumber(bucket));
+        }
+        cJSON_AddItemToObject(stage, "buckets", buckets);
+        cJSON_AddNumberToObject(stage, "count", histogram.count);
+        cJSON_AddNumberToObject(stage, "avg_ms", histogram.total_ms / histogram.count);
+        cJSON_AddNumberToObject(stage, "max_ms", histogram.max_ms);
+        cJSON_AddItemToObject(root, STAGE_NAMES[i], stage);
+    }
+
+    char* str = cJSON_PrintUnformatted(root);
+    std::string json = str;
+    cJSON_free(str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void LatencyTracker::PrintHistograms() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        auto& h = histograms_[i];
+        if (h.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-16s n=%lu avg=%lums max=%lums [%lu %lu %lu %lu %lu %lu %lu %lu]",
+            STAGE_NAMES[i], h.count, h.total_ms / h.count, h.max_ms,
+            h.buckets[0], h.buckets[1], h.buckets[2], h.buckets[3],
+            h.buckets[4], h.buckets[5], h.buckets[6], h.buckets[7]);
+    }
+}
+
+void LatencyTracker::Load() {
+    Settings settings("latency", false);
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        auto value = settings.GetString("s" + std::to_string(i));
+        if (value.empty()) {
+            continue;
+        }
+
+        // 格式: b0,b1,...,b7,count,total_ms,max_ms
+        uint32_t fields[LATENCY_HISTOGRAM_BUCKETS + 3];
+        const char* p = value.c_str();
+        size_t n = 0;
+        while (n < sizeof(fields) / sizeof(fields[0]) && *p != '\0') {
+            char* end;
+            fields[n++] = strtoul(p, &end, 10);
+            p = (*end == ',') ? end + 1 : end;
+        }
+        if (n != sizeof(fields) / sizeof(fields[0])) {
+            ESP_LOGW(TAG, "Invalid histogram for stage %s", STAGE_NAMES[i]);
+            continue;
+        }
+
+        auto& h = histograms_[i];
+        for (int j = 0; j < LATENCY_HISTOGRAM_BUCKETS; j++) {
+            h.buckets[j] = fields[j];
+        }
+        h.count = fields[LATENCY_HISTOGRAM_BUCKETS];
+        h.total_ms = fields[LATENCY_HISTOGRAM_BUCKETS + 1];
+        h.max_ms = fields[LATENCY_HISTOGRAM_BUCKETS + 2];
+    }
+}
+
+void LatencyTracker::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_) {
+        return;
+    }
+
+    Settings settings("latency", true);
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        auto& h = histograms_[i];
+        if (h.count == 0) {
+            continue;
+        }
+        std::string value;
+        for (auto bucket : h.buckets) {
+            value += std::to_string(bucket) + ",";
+        }
+        value += std::to_string(h.count) + "," + std::to_string(h.total_ms) + "," + std::to_string(h.max_ms);
+        settings.SetString("s" + std::to_string(i), value);
+    }
+    dirty_ = false;
+}
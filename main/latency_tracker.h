@@ -0,0 +1,94 @@
+#ifndef _LATENCY_TRACKER_H_
+#define _LATENCY_TRACKER_H_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+// 一次对话回合中的时间点，按发生顺序排列
+enum LatencyMarker {
+    kLatencyMarkerWakeWord,
+    kLatencyMarkerChannelOpenStart,
+    kLatencyMarkerChannelOpenEnd,
+    kLatencyMarkerFirstUplink,
+    kLatencyMarkerListenStop,
+    kLatencyMarkerTtsStart,
+    kLatencyMarkerFirstDownlink,
+    kLatencyMarkerFirstPlayback,
+    kLatencyMarkerTtsStop,
+    kLatencyMarkerCount
+};
+
+// 相邻两个时间点之间的阶段
+enum LatencyStage {
+    kLatencyStageWakeToOpen,        // WakeWord -> ChannelOpenStart
+    kLatencyStageChannelOpen,       // ChannelOpenStart -> ChannelOpenEnd
+    kLatencyStageOpenToUplink,      // ChannelOpenEnd -> FirstUplink
+    kLatencyStageServerResponse,    // ListenStop -> TtsStart
+    kLatencyStageFirstDownlink,     // TtsStart -> FirstDownlink
+    kLatencyStagePlaybackStart,     // FirstDownlink -> FirstPlayback
+    kLatencyStageSpeaking,          // FirstPlayback -> TtsStop
+    kLatencyStageCount
+};
+
+#define LATENCY_HISTOGRAM_BUCKETS 8
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS] = {0};
+    uint32_t count = 0;
+    uint32_t total_ms = 0;
+    uint32_t max_ms = 0;
+
+    void Add(uint32_t ms);
+};
+
+// 一个回合的统计结果，-1 表示缺少时间点或时间点顺序不对
+struct LatencyTurn {
+    int32_t stage_ms[kLatencyStageCount];
+    // 从停止说话到开始播放回复的总耗时
+    int32_t response_ms = -1;
+    // 总耗时中没有被 server_response、first_downlink、playback_start 覆盖的部分
+    int32_t unaccounted_ms = 0;
+};
+
+class LatencyTracker {
+public:
+    static LatencyTracker& GetInstance() {
+        static LatencyTracker instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    LatencyTracker(const LatencyTracker&) = delete;
+    LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+    // 记录时间点，覆盖本回合之前的记录
+    void Mark(LatencyMarker marker);
+    // 只记录本回合内第一次出现的时间点，用于首包类的标记
+    void MarkOnce(LatencyMarker marker);
+    bool IsMarked(LatencyMarker marker) const;
+
+    // 结束当前回合，把各阶段耗时计入直方图，返回本回合的 JSON 描述
+    std::string FinishTurn();
+    // 由时间点（微秒）计算各阶段耗时，不修改任何状态
+    // 每个时间点先取整到毫秒再相减，相邻阶段之和正好等于总耗时，不会因为分别取整差几毫秒
+    static LatencyTurn ComputeTurn(const int64_t marks[kLatencyMarkerCount]);
+    // 新会话开始，清除所有时间点
+    void Reset();
+
+    std::string GetHistogramsJson();
+    void PrintHistograms();
+    void Save();
+
+private:
+    LatencyTracker();
+
+    std::atomic<int64_t> marks_[kLatencyMarkerCount];
+    std::mutex mutex_;
+    LatencyHistogram histograms_[kLatencyStageCount];
+    bool dirty_ = false;
+
+    void Load();
+};
+
+#endif // _LATENCY_TRACKER_H_
@@ -1,10 +1,19 @@
 #include "circular_strip.h"
 #include "application.h"
+#include "board.h"
+#include "audio_codec.h"
 #include <esp_log.h>
+#include <algorithm>
+#include <cmath>
 
 #define TAG "CircularStrip"
 
-#define BLINK_INFINITE -1
+// 空闲时渐暗熄灭的步数
+#define FADE_OUT_STEPS 8
+
+// 音量条的刷新间隔，以及全灭对应的电平（dBFS）
+#define VU_METER_INTERVAL_MS 50
+#define VU_METER_FLOOR_DB -48.0f
 
 CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_leds) {
     // If the gpio is not connected, you should use NoLed class
@@ -24,24 +33,17 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip_));
     led_strip_clear(led_strip_);
 
-    esp_timer_create_args_t strip_timer_args = {
-        .callback = [](void *arg) {
-            auto strip = static_cast<CircularStrip*>(arg);
-            std::lock_guard<std::mutex> lock(strip->mutex_);
-            if (strip->strip_callback_ != nullptr) {
-                strip->strip_callback_();
-            }
-        },
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "strip_timer",
-        .skip_unhandled_events = false,
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&strip_timer_args, &strip_timer_));
+    channel_ = LedAnimator::GetInstance().AddChannel(max_leds_, [this](const std::vector<StripColor>& frame) {
+        for (int i = 0; i < max_leds_; i++) {
+            led_strip_set_pixel(led_strip_, i, frame[i].red, frame[i].green, frame[i].blue);
+        }
+        led_strip_refresh(led_strip_);
+    });
+    LedAnimator::GetInstance().SetBrightness(channel_, default_brightness_);
 }
 
 CircularStrip::~CircularStrip() {
-    esp_timer_stop(strip_timer_);
+    LedAnimator::GetInstance().RemoveChannel(channel_);
     if (led_strip_ != nullptr) {
         led_strip_del(led_strip_);
     }
@@ -49,151 +51,87 @@ CircularStrip::~CircularStrip() {
 
 
 void CircularStrip::SetAllColor(StripColor color) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = color;
-        led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
-    }
-    led_strip_refresh(led_strip_);
+    LedAnimator::GetInstance().Play(channel_, 0, [this, color](LedFrameGenerator& generator) {
+        std::fill(colors_.begin(), colors_.end(), color);
+        generator.Solid(colors_);
+    });
 }
 
 void CircularStrip::SetSingleColor(uint8_t index, StripColor color) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    colors_[index] = color;
-    led_strip_set_pixel(led_strip_, index, color.red, color.green, color.blue);
-    led_strip_refresh(led_strip_);
+    LedAnimator::GetInstance().Play(channel_, 0, [this, index, color](LedFrameGenerator& generator) {
+        colors_[index] = color;
+        generator.Solid(colors_);
+    });
 }
 
 void CircularStrip::Blink(StripColor color, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = color;
-    }
-    StartStripTask(interval_ms, [this]() {
-        static bool on = true;
-        if (on) {
-            for (int i = 0; i < max_leds_; i++) {
-                led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-            }
-            led_strip_refresh(led_strip_);
-        } else {
-            led_strip_clear(led_strip_);
-        }
-        on = !on;
+    LedAnimator::GetInstance().Play(channel_, interval_ms, [this, color](LedFrameGenerator& generator) {
+        std::fill(colors_.begin(), colors_.end(), color);
+        generator.Blink(color);
     });
 }
 
 void CircularStrip::FadeOut(int interval_ms) {
-    StartStripTask(interval_ms, [this]() {
-        bool all_off = true;
-        for (int i = 0; i < max_leds_; i++) {
-            colors_[i].red /= 2;
-            colors_[i].green /= 2;
-            colors_[i].blue /= 2;
-            if (colors_[i].red != 0 || colors_[i].green != 0 || colors_[i].blue != 0) {
-                all_off = false;
-            }
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-        }
-        if (all_off) {
-            led_strip_clear(led_strip_);
-            esp_timer_stop(strip_timer_);
-        } else {
-            led_strip_refresh(led_strip_);
-        }
+    LedAnimator::GetInstance().Play(channel_, interval_ms, [this](LedFrameGenerator& generator) {
+        std::fill(colors_.begin(), colors_.end(), StripColor{});
+        generator.FadeOut(FADE_OUT_STEPS);
     });
 }
 
 void CircularStrip::Breathe(StripColor low, StripColor high, int interval_ms) {
-    StartStripTask(interval_ms, [this, low, high]() {
-        static bool increase = true;
-        static StripColor color = low;
-        if (increase) {
-            if (color.red < high.red) {
-                color.red++;
-            }
-            if (color.green < high.green) {
-                color.green++;
-            }
-            if (color.blue < high.blue) {
-                color.blue++;
-            }
-            if (color.red == high.red && color.green == high.green && color.blue == high.blue) {
-                increase = false;
-            }
-        } else {
-            if (color.red > low.red) {
-                color.red--;
-            }
-            if (color.green > low.green) {
-                color.green--;
-            }
-            if (color.blue > low.blue) {
-                color.blue--;
-            }
-            if (color.red == low.red && color.green == low.green && color.blue == low.blue) {
-                increase = true;
-            }
-        }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
-        }
-        led_strip_refresh(led_strip_);
+    LedAnimator::GetInstance().Play(channel_, interval_ms, [low, high](LedFrameGenerator& generator) {
+        generator.Breathe(low, high);
     });
 }
 
 void CircularStrip::Scroll(StripColor low, StripColor high, int length, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = low;
-    }
-    StartStripTask(interval_ms, [this, low, high, length]() {
-        static int offset = 0;
-        for (int i = 0; i < max_leds_; i++) {
-            colors_[i] = low;
-        }
-        for (int j = 0; j < length; j++) {
-            int i = (offset + j) % max_leds_;
-            colors_[i] = high;
-        }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-        }
-        led_strip_refresh(led_strip_);
-        offset = (offset + 1) % max_leds_;
+    LedAnimator::GetInstance().Play(channel_, interval_ms, [this, low, high, length](LedFrameGenerator& generator) {
+        std::fill(colors_.begin(), colors_.end(), low);
+        generator.Scroll(low, high, length);
     });
 }
 
-void CircularStrip::StartStripTask(int interval_ms, std::function<void()> cb) {
-    if (led_strip_ == nullptr) {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    
-    strip_callback_ = cb;
-    esp_timer_start_periodic(strip_timer_, interval_ms * 1000);
+// 按对数刻度把 rms 换算成点亮的灯数，每一步读取一次最新的电平快照
+void CircularStrip::ShowLevel(StripColor color, bool input) {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    auto meter = input ? &codec->input_level() : &codec->output_level();
+    LedAnimator::GetInstance().Play(channel_, VU_METER_INTERVAL_MS, [this, color](LedFrameGenerator& generator) {
+        std::fill(colors_.begin(), colors_.end(), color);
+        generator.Meter(StripColor{}, color, 0);
+    }, [this, meter, color](LedFrameGenerator& generator) {
+        auto level = meter->Get();
+        int lit = 0;
+        if (level.rms > 0) {
+            float db = 20.0f * std::log10(level.rms / 32768.0f);
+            lit = std::lround((db - VU_METER_FLOOR_DB) / -VU_METER_FLOOR_DB * max_leds_);
+            lit = std::clamp(lit, 0, max_leds_);
+        }
+        generator.Meter(StripColor{}, color, lit);
+    });
 }
 
 void CircularStrip::SetBrightness(uint8_t default_brightness, uint8_t low_brightness) {
     default_brightness_ = default_brightness;
     low_brightness_ = low_brightness;
+    LedAnimator::GetInstance().SetBrightness(channel_, default_brightness_);
     OnStateChanged();
 }
 
 void CircularStrip::OnStateChanged() {
     auto& app = Application::GetInstance();
     auto device_state = app.GetDeviceState();
+    // 亮度查找表把 255 缩放到 default_brightness_，low_brightness_ 换算成相对于它的比例
+    uint8_t high_level = 255;
+    uint8_t low_level = default_brightness_ > 0 ? std::min(low_brightness_ * 255 / default_brightness_, 255) : 0;
     switch (device_state) {
         case kDeviceStateStarting: {
             StripColor low = { 0, 0, 0 };
-            StripColor high = { low_brightness_, low_brightness_, default_brightness_ };
+            StripColor high = { low_level, low_level, high_level };
             Scroll(low, high, 3, 100);
             break;
         }
         case kDeviceStateWifiConfiguring: {
-            StripColor color = { low_brightness_, low_brightness_, default_brightness_ };
+            StripColor color = { low_level, low_level, high_level };
             Blink(color, 500);
             break;
         }
@@ -201,27 +139,35 @@ void CircularStrip::OnStateChanged() {
             FadeOut(50);
             break;
         case kDeviceStateConnecting: {
-            StripColor color = { low_brightness_, low_brightness_, default_brightness_ };
+            StripColor color = { low_level, low_level, high_level };
             SetAllColor(color);
             break;
         }
         case kDeviceStateListening: {
-            StripColor color = { default_brightness_, low_brightness_, low_brightness_ };
+            StripColor color = { high_level, low_level, low_level };
+#if CONFIG_LED_STRIP_VU_METER
+            ShowLevel(color, true);
+#else
             SetAllColor(color);
+#endif
             break;
         }
         case kDeviceStateSpeaking: {
-            StripColor color = { low_brightness_, default_brightness_, low_brightness_ };
+            StripColor color = { low_level, high_level, low_level };
+#if CONFIG_LED_STRIP_VU_METER
+            ShowLevel(color, false);
+#else
             SetAllColor(color);
+#endif
             break;
         }
         case kDeviceStateUpgrading: {
-            StripColor color = { low_brightness_, default_brightness_, low_brightness_ };
+            StripColor color = { low_level, high_level, low_level };
             Blink(color, 100);
             break;
         }
         case kDeviceStateActivating: {
-            StripColor color = { low_brightness_, default_brightness_, low_brightness_ };
+            StripColor color = { low_level, high_level, low_level };
             Blink(color, 500);
             break;
         }
@@ -13,8 +13,6 @@
 #define UPGRADING_BRIGHTNESS 25
 #define ACTIVATING_BRIGHTNESS 35
 
-#define BLINK_INFINITE -1
-
 // GPIO_LED
 #define LEDC_LS_TIMER          LEDC_TIMER_1
 #define LEDC_LS_MODE           LEDC_LOW_SPEED_MODE
@@ -55,29 +53,24 @@ GpioLed::GpioLed(gpio_num_t gpio, int output_invert) {
     // Initialize fade service.
     ledc_fade_func_install(0);
 
-    // When the callback registered by ledc_cb_degister is called, run led ->OnFadeEnd()
-    ledc_cbs_t ledc_callbacks = {
-        .fade_cb = FadeCallback
-    };
-    ledc_cb_register(ledc_channel_.speed_mode, ledc_channel_.channel, &ledc_callbacks, this);
-
-    esp_timer_create_args_t blink_timer_args = {
-        .callback = [](void *arg) {
-            auto led = static_cast<GpioLed*>(arg);
-            led->OnBlinkTimer();
-        },
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "Blink Timer",
-        .skip_unhandled_events = false,
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&blink_timer_args, &blink_timer_));
+    // 亮度变化由 LedAnimator 统一驱动，每一帧只取红色通道作为亮度，已经按 SetBrightness 缩放
+    channel_ = LedAnimator::GetInstance().AddChannel(1, [this](const std::vector<StripColor>& frame) {
+        uint32_t duty = frame[0].red * LEDC_DUTY / 255;
+        ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
+        if (fade_time_ms_ > 0) {
+            ledc_set_fade_with_time(ledc_channel_.speed_mode, ledc_channel_.channel, duty, fade_time_ms_);
+            ledc_fade_start(ledc_channel_.speed_mode, ledc_channel_.channel, LEDC_FADE_NO_WAIT);
+        } else {
+            ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty);
+            ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+        }
+    });
 
     ledc_initialized_ = true;
 }
 
 GpioLed::~GpioLed() {
-    esp_timer_stop(blink_timer_);
+    LedAnimator::GetInstance().RemoveChannel(channel_);
     if (ledc_initialized_) {
         ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
         ledc_fade_func_uninstall();
@@ -86,7 +79,7 @@ GpioLed::~GpioLed() {
 
 
 void GpioLed::SetBrightness(uint8_t brightness) {
-    duty_ = brightness * LEDC_DUTY / 100;
+    LedAnimator::GetInstance().SetBrightness(channel_, brightness * 255 / 100);
 }
 
 void GpioLed::TurnOn() {
@@ -94,11 +87,10 @@ void GpioLed::TurnOn() {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty_);
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    LedAnimator::GetInstance().Play(channel_, 0, [this](LedFrameGenerator& generator) {
+        fade_time_ms_ = 0;
+        generator.Solid(StripColor{255, 0, 0});
+    });
 }
 
 void GpioLed::TurnOff() {
@@ -106,84 +98,34 @@ void GpioLed::TurnOff() {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
-}
-
-void GpioLed::BlinkOnce() {
-    Blink(1, 100);
-}
-
-void GpioLed::Blink(int times, int interval_ms) {
-    StartBlinkTask(times, interval_ms);
+    LedAnimator::GetInstance().Play(channel_, 0, [this](LedFrameGenerator& generator) {
+        fade_time_ms_ = 0;
+        generator.Solid(StripColor{});
+    });
 }
 
 void GpioLed::StartContinuousBlink(int interval_ms) {
-    StartBlinkTask(BLINK_INFINITE, interval_ms);
-}
-
-void GpioLed::StartBlinkTask(int times, int interval_ms) {
     if (!ledc_initialized_) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-
-    blink_counter_ = times * 2;
-    blink_interval_ms_ = interval_ms;
-    esp_timer_start_periodic(blink_timer_, interval_ms * 1000);
-}
-
-void GpioLed::OnBlinkTimer() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    blink_counter_--;
-    if (blink_counter_ & 1) {
-        ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty_);
-    } else {
-        ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
-
-        if (blink_counter_ == 0) {
-            esp_timer_stop(blink_timer_);
-        }
-    }
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    LedAnimator::GetInstance().Play(channel_, interval_ms, [this](LedFrameGenerator& generator) {
+        fade_time_ms_ = 0;
+        generator.Blink(StripColor{255, 0, 0});
+    });
 }
 
+// 在全灭和当前亮度之间呼吸，单程 LEDC_FADE_TIME
+// 每个单程由 LEDC 硬件渐变完成，动画只在全亮和全灭之间交替，定时器每个单程唤醒一次
 void GpioLed::StartFadeTask() {
     if (!ledc_initialized_) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    fade_up_ = true;
-    ledc_set_fade_with_time(ledc_channel_.speed_mode,
-                            ledc_channel_.channel, LEDC_DUTY, LEDC_FADE_TIME);
-    ledc_fade_start(ledc_channel_.speed_mode,
-                    ledc_channel_.channel, LEDC_FADE_NO_WAIT);
-}
-
-void GpioLed::OnFadeEnd() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    fade_up_ = !fade_up_;
-    ledc_set_fade_with_time(ledc_channel_.speed_mode,
-                            ledc_channel_.channel, fade_up_ ? LEDC_DUTY : 0, LEDC_FADE_TIME);
-    ledc_fade_start(ledc_channel_.speed_mode,
-                    ledc_channel_.channel, LEDC_FADE_NO_WAIT);
-}
-
-bool GpioLed::FadeCallback(const ledc_cb_param_t *param, void *user_arg) {
-    if (param->event == LEDC_FADE_END_EVT) {
-        auto led = static_cast<GpioLed*>(user_arg);
-        led->OnFadeEnd();
-    }
-    return true;
+    LedAnimator::GetInstance().Play(channel_, LEDC_FADE_TIME, [this](LedFrameGenerator& generator) {
+        fade_time_ms_ = LEDC_FADE_TIME;
+        generator.Blink(StripColor{255, 0, 0});
+    });
 }
 
 void GpioLed::OnStateChanged() {
@@ -1,14 +1,10 @@
 #ifndef _GPIO_LED_H_
 #define _GPIO_LED_H_
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
 #include "led.h"
+#include "led_animator.h"
 #include <driver/gpio.h>
 #include <driver/ledc.h>
-#include <esp_timer.h>
-#include <atomic>
-#include <mutex>
 
 class GpioLed : public Led {
 public:
@@ -18,28 +14,18 @@ public:
     void OnStateChanged() override;
 
 private:
-    std::mutex mutex_;
-    TaskHandle_t blink_task_ = nullptr;
     ledc_channel_config_t ledc_channel_ = {0};
     bool ledc_initialized_ = false;
-    uint32_t duty_ = 0;
-    int blink_counter_ = 0;
-    int blink_interval_ms_ = 0;
-    esp_timer_handle_t blink_timer_ = nullptr;
-    bool fade_up_ = true;
+    // 不为 0 时 sink 用 LEDC 硬件渐变到新的亮度，而不是直接设置占空比，只在动画定时器的锁内访问
+    int fade_time_ms_ = 0;
+    LedAnimator::Channel* channel_ = nullptr;
 
-    void StartBlinkTask(int times, int interval_ms);
-    void OnBlinkTimer();
-
-    void BlinkOnce();
-    void Blink(int times, int interval_ms);
     void StartContinuousBlink(int interval_ms);
     void TurnOn();
     void TurnOff();
+    // 0-100，经过动画通道的亮度查找表缩放
     void SetBrightness(uint8_t brightness);
     void StartFadeTask();
-    void OnFadeEnd();
-    static bool FadeCallback(const ledc_cb_param_t *param, void *user_arg);
 };
 
 #endif // _GPIO_LED_H_
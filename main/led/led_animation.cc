@@ -0,0 +1,137 @@
+#include "led_animation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+#define GAMMA 2.2f
+
+// 人眼对亮度的感知不是线性的，混合比例按 gamma 曲线走，渐变在暗部不会显得突兀
+static std::array<uint8_t, 256> BuildGammaLut() {
+    std::array<uint8_t, 256> lut;
+    for (int i = 0; i < 256; i++) {
+        lut[i] = static_cast<uint8_t>(std::lround(255.0f * std::pow(i / 255.0f, GAMMA)));
+    }
+    return lut;
+}
+
+static const std::array<uint8_t, 256> kGammaLut = BuildGammaLut();
+
+static inline uint8_t Mix(uint8_t a, uint8_t b, uint8_t mix) {
+    return (a * (255 - mix) + b * mix + 127) / 255;
+}
+
+LedFrameGenerator::LedFrameGenerator(size_t num_leds)
+    : from_(num_leds), to_(num_leds), pixels_(num_leds), frame_(num_leds) {
+    SetBrightness(255);
+}
+
+void LedFrameGenerator::SetBrightness(uint8_t brightness) {
+    for (int i = 0; i < 256; i++) {
+        brightness_lut_[i] = (i * brightness + 127) / 255;
+    }
+}
+
+void LedFrameGenerator::Start(bool loop, size_t rotate_step) {
+    position_ = 0;
+    loop_ = loop;
+    offset_ = 0;
+    rotate_step_ = rotate_step;
+}
+
+// 追加 steps 步，最后一步正好落在 to
+void LedFrameGenerator::AppendRamp(uint8_t from, uint8_t to, int steps) {
+    for (int i = 1; i <= steps; i++) {
+        int value = from + (to - from) * i / steps;
+        keyframes_.push_back(kGammaLut[value]);
+    }
+}
+
+void LedFrameGenerator::Solid(StripColor color) {
+    std::fill(to_.begin(), to_.end(), color);
+    keyframes_.assign(1, 255);
+    Start(false, 0);
+}
+
+void LedFrameGenerator::Solid(const std::vector<StripColor>& colors) {
+    std::copy_n(colors.begin(), std::min(colors.size(), to_.size()), to_.begin());
+    keyframes_.assign(1, 255);
+    Start(false, 0);
+}
+
+void LedFrameGenerator::Blink(StripColor color) {
+    std::fill(from_.begin(), from_.end(), StripColor{});
+    std::fill(to_.begin(), to_.end(), color);
+    keyframes_ = {255, 0};
+    Start(true, 0);
+}
+
+void LedFrameGenerator::Breathe(StripColor low, StripColor high, int steps) {
+    if (steps <= 0) {
+        steps = std::max({std::abs(high.red - low.red), std::abs(high.green - low.green),
+            std::abs(high.blue - low.blue), 1});
+    }
+    std::fill(from_.begin(), from_.end(), low);
+    std::fill(to_.begin(), to_.end(), high);
+    keyframes_.assign(1, 0);
+    AppendRamp(0, 255, steps);
+    AppendRamp(255, 0, steps);
+    // 最后一步和第一步相同，循环时去掉
+    keyframes_.pop_back();
+    Start(true, 0);
+}
+
+void LedFrameGenerator::FadeOut(int steps) {
+    std::fill(from_.begin(), from_.end(), StripColor{});
+    to_ = pixels_;
+    keyframes_.clear();
+    AppendRamp(255, 0, std::max(steps, 1));
+    Start(false, 0);
+}
+
+void LedFrameGenerator::Scroll(StripColor low, StripColor high, int length) {
+    std::fill(from_.begin(), from_.end(), low);
+    for (size_t i = 0; i < to_.size(); i++) {
+        to_[i] = static_cast<int>(i) < length ? high : low;
+    }
+    keyframes_.assign(1, 255);
+    Start(true, 1);
+}
+
+void LedFrameGenerator::Meter(StripColor low, StripColor high, int lit) {
+    std::fill(from_.begin(), from_.end(), low);
+    for (size_t i = 0; i < to_.size(); i++) {
+        to_[i] = static_cast<int>(i) < lit ? high : low;
+    }
+    keyframes_.assign(1, 255);
+    Start(true, 0);
+}
+
+bool LedFrameGenerator::Advance() {
+    if (finished() || frame_.empty()) {
+        return false;
+    }
+
+    uint8_t mix = keyframes_[position_++];
+    if (loop_ && position_ == keyframes_.size()) {
+        position_ = 0;
+    }
+
+    size_t count = frame_.size();
+    bool changed = !frame_valid_;
+    for (size_t i = 0; i < count; i++) {
+        const auto& from = from_[i];
+        const auto& to = to_[(i + count - offset_) % count];
+        StripColor pixel = {Mix(from.red, to.red, mix), Mix(from.green, to.green, mix), Mix(from.blue, to.blue, mix)};
+        pixels_[i] = pixel;
+        StripColor output = {brightness_lut_[pixel.red], brightness_lut_[pixel.green], brightness_lut_[pixel.blue]};
+        if (output != frame_[i]) {
+            frame_[i] = output;
+            changed = true;
+        }
+    }
+    offset_ = (offset_ + rotate_step_) % count;
+    frame_valid_ = true;
+    return changed;
+}
@@ -0,0 +1,69 @@
+#ifndef _LED_ANIMATION_H_
+#define _LED_ANIMATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct StripColor {
+    uint8_t red = 0, green = 0, blue = 0;
+};
+
+inline bool operator==(const StripColor& a, const StripColor& b) {
+    return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+inline bool operator!=(const StripColor& a, const StripColor& b) {
+    return !(a == b);
+}
+
+// LED 帧生成器，不依赖任何硬件，可以在主机上测试
+// 每个像素是两组颜色 from/to 之间的混合，动画开始时把每一步的混合比例（经过 gamma 校正）预先算好，
+// 每一步只需要查表和一次整数插值；输出再经过亮度查找表
+class LedFrameGenerator {
+public:
+    explicit LedFrameGenerator(size_t num_leds);
+
+    // 整体亮度，255 表示不缩放
+    void SetBrightness(uint8_t brightness);
+
+    void Solid(StripColor color);
+    void Solid(const std::vector<StripColor>& colors);
+    void Blink(StripColor color);
+    // steps 为 0 时按颜色差值决定步数，和原来每步加减 1 的速度一致
+    void Breathe(StripColor low, StripColor high, int steps = 0);
+    // 从当前画面渐暗到全黑，然后结束
+    void FadeOut(int steps);
+    // 长度为 length 的一段 high 颜色每步移动一个位置
+    void Scroll(StripColor low, StripColor high, int length);
+    // 前 lit 个灯为 high，其余为 low，用于音量条，可以每一步重新设置
+    void Meter(StripColor low, StripColor high, int lit);
+
+    // 计算下一帧，返回 true 表示和上一次输出的帧不同，需要刷新
+    bool Advance();
+    // 非循环的动画播放完毕
+    bool finished() const { return !loop_ && position_ >= keyframes_.size(); }
+    const std::vector<StripColor>& frame() const { return frame_; }
+    size_t size() const { return frame_.size(); }
+
+private:
+    std::vector<StripColor> from_;
+    std::vector<StripColor> to_;
+    // 每一步的混合比例，0 为 from，255 为 to
+    std::vector<uint8_t> keyframes_;
+    size_t position_ = 0;
+    bool loop_ = false;
+    size_t offset_ = 0;
+    size_t rotate_step_ = 0;
+
+    // 插值后、亮度缩放前的颜色，FadeOut 从这里开始
+    std::vector<StripColor> pixels_;
+    std::vector<StripColor> frame_;
+    bool frame_valid_ = false;
+    uint8_t brightness_lut_[256];
+
+    void Start(bool loop, size_t rotate_step);
+    void AppendRamp(uint8_t from, uint8_t to, int steps);
+};
+
+#endif // _LED_ANIMATION_H_
@@ -0,0 +1,111 @@
+#include "led_animator.h"
+
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "LedAnimator"
+
+// 在这个时间之内到期的动画合并到同一次唤醒中执行
+#define LED_ANIMATION_SLACK_US 2000
+
+struct LedAnimator::Channel {
+    LedFrameGenerator generator;
+    LedSink sink;
+    std::function<void(LedFrameGenerator&)> update;
+    int64_t interval_us = 0;
+    int64_t next_time_us = 0;
+    bool active = false;
+
+    Channel(size_t num_leds, LedSink sink) : generator(num_leds), sink(sink) {}
+};
+
+LedAnimator::LedAnimator() {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void *arg) {
+            auto animator = static_cast<LedAnimator*>(arg);
+            animator->OnTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_animator",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_));
+}
+
+LedAnimator::~LedAnimator() {
+    if (timer_ != nullptr) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+    }
+}
+
+LedAnimator::Channel* LedAnimator::AddChannel(size_t num_leds, LedSink sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return &channels_.emplace_back(num_leds, sink);
+}
+
+void LedAnimator::RemoveChannel(Channel* channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    channels_.remove_if([channel](const Channel& c) { return &c == channel; });
+    Schedule();
+}
+
+void LedAnimator::Play(Channel* channel, int interval_ms, const std::function<void(LedFrameGenerator&)>& setup,
+    std::function<void(LedFrameGenerator&)> update) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    setup(channel->generator);
+    channel->update = std::move(update);
+    channel->interval_us = std::max(interval_ms, 1) * 1000LL;
+    Step(*channel);
+    channel->active = !channel->generator.finished();
+    channel->next_time_us = esp_timer_get_time() + channel->interval_us;
+    Schedule();
+}
+
+void LedAnimator::SetBrightness(Channel* channel, uint8_t brightness) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    channel->generator.SetBrightness(brightness);
+}
+
+void LedAnimator::Step(Channel& channel) {
+    if (channel.update) {
+        channel.update(channel.generator);
+    }
+    if (channel.generator.Advance()) {
+        channel.sink(channel.generator.frame());
+    }
+}
+
+void LedAnimator::OnTimer() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = esp_timer_get_time();
+    for (auto& channel : channels_) {
+        if (!channel.active || channel.next_time_us > now + LED_ANIMATION_SLACK_US) {
+            continue;
+        }
+        Step(channel);
+        channel.active = !channel.generator.finished();
+        // 保持固定的节奏，落后超过一个间隔时（例如 esp_timer 任务被占用）不补帧
+        channel.next_time_us += channel.interval_us;
+        if (channel.next_time_us <= now) {
+            channel.next_time_us = now + channel.interval_us;
+        }
+    }
+    Schedule();
+}
+
+void LedAnimator::Schedule() {
+    int64_t next_time_us = INT64_MAX;
+    for (auto& channel : channels_) {
+        if (channel.active) {
+            next_time_us = std::min(next_time_us, channel.next_time_us);
+        }
+    }
+    esp_timer_stop(timer_);
+    // 所有动画都停下来以后不再唤醒
+    if (next_time_us == INT64_MAX) {
+        return;
+    }
+    esp_timer_start_once(timer_, std::max<int64_t>(next_time_us - esp_timer_get_time(), 0));
+}
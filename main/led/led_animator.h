@@ -0,0 +1,54 @@
+#ifndef _LED_ANIMATOR_H_
+#define _LED_ANIMATOR_H_
+
+#include "led_animation.h"
+
+#include <esp_timer.h>
+#include <functional>
+#include <list>
+#include <mutex>
+
+// 把生成的帧写到硬件
+typedef std::function<void(const std::vector<StripColor>& frame)> LedSink;
+
+// 所有 LED 设备共用的动画定时器
+// 定时器是单次的，每次只在最早到期的一路动画的时间点唤醒，没有动画播放时不运行
+// 帧内容没有变化时不调用 sink，省掉一次刷新
+class LedAnimator {
+public:
+    struct Channel;
+
+    static LedAnimator& GetInstance() {
+        static LedAnimator instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    LedAnimator(const LedAnimator&) = delete;
+    LedAnimator& operator=(const LedAnimator&) = delete;
+
+    Channel* AddChannel(size_t num_leds, LedSink sink);
+    // 返回之后 sink 不会再被调用
+    void RemoveChannel(Channel* channel);
+
+    // 在锁内用 setup 设置新的动画，立即输出第一帧，之后每 interval_ms 前进一步
+    // update 不为空时每一步之前调用，用于跟随外部数据（例如音量）修改动画
+    void Play(Channel* channel, int interval_ms, const std::function<void(LedFrameGenerator&)>& setup,
+        std::function<void(LedFrameGenerator&)> update = nullptr);
+    // 这一路的整体亮度，经过帧生成器的亮度查找表缩放，从下一帧开始生效
+    void SetBrightness(Channel* channel, uint8_t brightness);
+
+private:
+    LedAnimator();
+    ~LedAnimator();
+
+    std::mutex mutex_;
+    esp_timer_handle_t timer_ = nullptr;
+    std::list<Channel> channels_;
+
+    void Step(Channel& channel);
+    void OnTimer();
+    // 按所有动画中最早的到期时间重新启动定时器，调用时持有锁
+    void Schedule();
+};
+
+#endif // _LED_ANIMATOR_H_
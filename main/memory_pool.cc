@@ -0,0 +1,159 @@
+#include "memory_pool.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+
+#define TAG "MemoryPool"
+
+static std::mutex registry_mutex;
+static std::vector<MemoryPool*>& GetRegistry() {
+    static std::vector<MemoryPool*> registry;
+    return registry;
+}
+
+MemoryPool::MemoryPool(const char* name, size_t block_size, size_t block_count, MemoryPlacement placement)
+    : name_(name), block_count_(block_count), placement_(placement) {
+    // 块大小和起始地址都按 16 字节对齐，池中的 PCM 数据可以直接使用 PIE SIMD 指令处理
+    block_size_ = (std::max(block_size, sizeof(FreeBlock)) + 15) & ~(size_t)15;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    GetRegistry().push_back(this);
+}
+
+MemoryPool::~MemoryPool() {
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto& registry = GetRegistry();
+        registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+    }
+    if (arena_ != nullptr) {
+        heap_caps_free(arena_);
+    }
+}
+
+uint32_t MemoryPool::GetHeapCaps() const {
+    switch (placement_) {
+        case kMemoryPlacementPsram:
+            return MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+        default:
+            return MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    }
+}
+
+bool MemoryPool::InitializeArena() {
+    arena_ = (uint8_t*)heap_caps_aligned_alloc(16, block_size_ * block_count_, GetHeapCaps());
+    in_psram_ = arena_ != nullptr && placement_ == kMemoryPlacementPsram;
+    if (arena_ == nullptr && placement_ == kMemoryPlacementPsram) {
+        // 没有 PSRAM 的板子上不建池，每次都从系统堆分配，用完即还，不长期占用内部 SRAM
+        ESP_LOGI(TAG, "Pool %s disabled without PSRAM", name_);
+        block_count_ = 0;
+        return false;
+    }
+    if (arena_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate pool %s (%u x %u bytes)", name_, block_count_, block_size_);
+        block_count_ = 0;
+        return false;
+    }
+
+    for (size_t i = 0; i < block_count_; i++) {
+        auto block = (FreeBlock*)(arena_ + i * block_size_);
+        block->next = free_list_;
+        free_list_ = block;
+    }
+    ESP_LOGI(TAG, "Pool %s: %u x %u bytes in %s", name_, block_count_, block_size_, in_psram_ ? "PSRAM" : "SRAM");
+    return true;
+}
+
+void* MemoryPool::Allocate(size_t size) {
+    if (size <= block_size_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (arena_ == nullptr && block_count_ > 0) {
+            InitializeArena();
+        }
+        if (free_list_ != nullptr) {
+            auto block = free_list_;
+            free_list_ = block->next;
+            blocks_in_use_++;
+            if (blocks_in_use_ > peak_blocks_in_use_) {
+                peak_blocks_in_use_ = blocks_in_use_;
+            }
+            return block;
+        }
+        fallback_allocations_++;
+    } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fallback_allocations_++;
+    }
+    if (placement_ == kMemoryPlacementPsram) {
+        return heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT);
+    }
+    return heap_caps_malloc(size, GetHeapCaps());
+}
+
+void MemoryPool::Deallocate(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    // arena_ 和 block_count_ 在第一次分配时才确定，必须在锁内读取
+    auto p = (uint8_t*)ptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (arena_ != nullptr && p >= arena_ && p < arena_ + block_size_ * block_count_) {
+            auto block = (FreeBlock*)p;
+            block->next = free_list_;
+            free_list_ = block;
+            blocks_in_use_--;
+            return;
+        }
+    }
+    heap_caps_free(ptr);
+}
+
+MemoryPoolStats MemoryPool::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    MemoryPoolStats stats;
+    stats.name = name_;
+    stats.block_size = block_size_;
+    stats.block_count = block_count_;
+    stats.blocks_in_use = blocks_in_use_;
+    stats.peak_blocks_in_use = peak_blocks_in_use_;
+    stats.fallback_allocations = fallback_allocations_;
+    stats.in_psram = in_psram_;
+    return stats;
+}
+
+std::vector<MemoryPoolStats> MemoryPool::GetAllStats() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::vector<MemoryPoolStats> all_stats;
+    for (auto pool : GetRegistry()) {
+        all_stats.push_back(pool->GetStats());
+    }
+    return all_stats;
+}
+
+void MemoryPool::PrintAllStats() {
+    for (auto& stats : GetAllStats()) {
+        ESP_LOGI(TAG, "%-12s %4u bytes x %3u in %s, in use: %u peak: %u fallback: %lu", stats.name,
+            stats.block_size, stats.block_count, stats.in_psram ? "PSRAM" : "SRAM",
+            stats.blocks_in_use, stats.peak_blocks_in_use, stats.fallback_allocations);
+    }
+}
+
+MemoryPool& OpusPacketPool::Get() {
+    static MemoryPool pool("opus_packet", 512, 128, kMemoryPlacementPsram);
+    return pool;
+}
+
+MemoryPool& AfeChunkPool::Get() {
+    // 唤醒词检测保留约 2 秒的数据，每块 32ms
+    static MemoryPool pool("afe_chunk", 512 * sizeof(int16_t), 2000 / 32 + 2, kMemoryPlacementPsram);
+    return pool;
+}
+
+MemoryPool& PcmFramePool::Get() {
+    // 采集、重采样和等待编码的帧同时存在，4 块足够；更大的帧（例如 24kHz 双声道）退回系统堆
+    static MemoryPool pool("pcm_frame", 960 * 2 * sizeof(int16_t), 4, kMemoryPlacementInternal);
+    return pool;
+}
@@ -0,0 +1,115 @@
+#ifndef _MEMORY_POOL_H_
+#define _MEMORY_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+enum MemoryPlacement {
+    kMemoryPlacementInternal,
+    kMemoryPlacementPsram, // 没有 PSRAM 时不建池，直接从系统堆分配
+};
+
+struct MemoryPoolStats {
+    const char* name;
+    size_t block_size;
+    size_t block_count;
+    size_t blocks_in_use;
+    size_t peak_blocks_in_use;
+    // 超过块大小或池已满时从系统堆分配的次数
+    uint32_t fallback_allocations;
+    bool in_psram;
+};
+
+// 固定大小内存块池，所有块在第一次使用时一次性分配，之后不再碎片化系统堆
+class MemoryPool {
+public:
+    MemoryPool(const char* name, size_t block_size, size_t block_count, MemoryPlacement placement);
+    ~MemoryPool();
+    // 删除拷贝构造函数和赋值运算符
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    void* Allocate(size_t size);
+    void Deallocate(void* ptr);
+    MemoryPoolStats GetStats();
+
+    static void PrintAllStats();
+    static std::vector<MemoryPoolStats> GetAllStats();
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const char* name_;
+    size_t block_size_;
+    size_t block_count_;
+    MemoryPlacement placement_;
+    std::mutex mutex_;
+    uint8_t* arena_ = nullptr;
+    FreeBlock* free_list_ = nullptr;
+    size_t blocks_in_use_ = 0;
+    size_t peak_blocks_in_use_ = 0;
+    uint32_t fallback_allocations_ = 0;
+    bool in_psram_ = false;
+
+    bool InitializeArena();
+    uint32_t GetHeapCaps() const;
+};
+
+// 可用于 STL 容器的分配器，Pool 需要提供 static MemoryPool& Get()
+template <typename T, typename Pool>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, Pool>;
+    };
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, Pool>&) noexcept {}
+
+    T* allocate(size_t n) {
+        void* ptr = Pool::Get().Allocate(n * sizeof(T));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        Pool::Get().Deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, Pool>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U, Pool>&) const noexcept { return false; }
+};
+
+// 网络收发的 Opus 包，60ms 一帧通常不超过 512 字节
+struct OpusPacketPool {
+    static MemoryPool& Get();
+};
+
+// 唤醒词检测缓存的 AFE 数据块，16kHz 单声道 512 个采样
+struct AfeChunkPool {
+    static MemoryPool& Get();
+};
+
+// 采集路径上 30/60ms 的 PCM 帧，块大小为 16kHz 双声道 60ms（1920 个采样）
+struct PcmFramePool {
+    static MemoryPool& Get();
+};
+
+using OpusPacket = std::vector<uint8_t, PoolAllocator<uint8_t, OpusPacketPool>>;
+using AfeChunk = std::vector<int16_t, PoolAllocator<int16_t, AfeChunkPool>>;
+using PcmFrame = std::vector<int16_t, PoolAllocator<int16_t, PcmFramePool>>;
+
+#endif // _MEMORY_POOL_H_
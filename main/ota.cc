@@ -2,20 +2,33 @@
 #include "system_info.h"
 #include "board.h"
 #include "settings.h"
+#include "delta_patch.h"
+#include "ota_downloader.h"
 
 #include <cJSON.h>
 #include <esp_log.h>
 #include <esp_partition.h>
 #include <esp_ota_ops.h>
 #include <esp_app_format.h>
+#include <spi_flash_mmap.h>
+#include <mbedtls/sha256.h>
 
 #include <cstring>
+#include <ctime>
 #include <vector>
+#include <memory>
 #include <sstream>
 #include <algorithm>
 
 #define TAG "Ota"
 
+// 每块的大小，必须是 flash 扇区大小的整数倍
+#define OTA_BLOCK_SIZE (16 * 1024)
+// 写入这么多数据后保存一次进度，减少 NVS 写入次数
+#define OTA_PROGRESS_SAVE_INTERVAL (64 * 1024)
+// 早于这个时间 (2024-01-01) 说明系统时间还没有同步过
+#define OTA_VALID_TIME 1704067200
+
 
 Ota::Ota() {
 }
@@ -123,6 +136,8 @@ bool Ota::CheckVersion() {
         }
     }
 
+    SaveCachedConfig();
+
     cJSON *firmware = cJSON_GetObjectItem(root, "firmware");
     if (firmware == NULL) {
         ESP_LOGE(TAG, "Failed to get firmware object");
@@ -144,6 +159,15 @@ bool Ota::CheckVersion() {
 
     firmware_version_ = version->valuestring;
     firmware_url_ = url->valuestring;
+    // 可选的差分补丁，服务器根据请求中的当前版本生成
+    delta_url_.clear();
+    cJSON *delta = cJSON_GetObjectItem(firmware, "delta");
+    if (delta != NULL) {
+        cJSON *delta_url = cJSON_GetObjectItem(delta, "url");
+        if (cJSON_IsString(delta_url)) {
+            delta_url_ = delta_url->valuestring;
+        }
+    }
     cJSON_Delete(root);
 
     // Check if the version is newer, for example, 0.1.0 is newer than 0.0.1
@@ -156,6 +180,40 @@ bool Ota::CheckVersion() {
     return true;
 }
 
+void Ota::SaveCachedConfig() {
+    Settings settings("ota_cache", true);
+    time_t now = time(NULL);
+    settings.SetInt("saved_at", now > OTA_VALID_TIME ? now : 0);
+    settings.SetInt("activation", has_activation_code_);
+    settings.SetInt("mqtt", has_mqtt_config_);
+    settings.SetInt("server_time", has_server_time_);
+}
+
+bool Ota::LoadCachedConfig() {
+    Settings settings("ota_cache");
+    int32_t saved_at = settings.GetInt("saved_at", -1);
+    if (saved_at < 0) {
+        return false;
+    }
+    if (settings.GetInt("activation")) {
+        ESP_LOGI(TAG, "Cached config requires activation");
+        return false;
+    }
+
+    // 软件重启后 RTC 时间仍然有效，可以判断缓存是否过期；断电后时间未知，直接使用缓存
+    time_t now = time(NULL);
+    bool clock_valid = now > OTA_VALID_TIME;
+    if (clock_valid && saved_at > 0 && now - saved_at > CONFIG_OTA_CONFIG_CACHE_TTL_HOURS * 3600) {
+        ESP_LOGI(TAG, "Cached config expired");
+        return false;
+    }
+
+    has_mqtt_config_ = settings.GetInt("mqtt");
+    has_server_time_ = clock_valid && settings.GetInt("server_time");
+    ESP_LOGI(TAG, "Loaded cached config, saved at %ld", (long)saved_at);
+    return true;
+}
+
 void Ota::MarkCurrentVersionValid() {
     auto partition = esp_ota_get_running_partition();
     if (strcmp(partition->label, "factory") == 0) {
@@ -176,120 +234,362 @@ void Ota::MarkCurrentVersionValid() {
     }
 }
 
-void Ota::Upgrade(const std::string& firmware_url) {
-    ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
-    esp_ota_handle_t update_handle = 0;
-    auto update_partition = esp_ota_get_next_update_partition(NULL);
-    if (update_partition == NULL) {
-        ESP_LOGE(TAG, "Failed to get update partition");
-        return;
-    }
+void Ota::SaveProgress(size_t offset) {
+    Settings settings("ota", true);
+    settings.SetInt("offset", offset);
+}
 
-    ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition->label, update_partition->address);
-    bool image_header_checked = false;
-    std::string image_header;
+void Ota::ClearProgress() {
+    Settings settings("ota", true);
+    settings.EraseAll();
+}
 
-    auto http = Board::GetInstance().CreateHttp();
-    if (!http->Open("GET", firmware_url)) {
-        ESP_LOGE(TAG, "Failed to open HTTP connection");
-        delete http;
-        return;
+bool Ota::CheckImageHeader(const UpgradeBlock& block) {
+    if (block.size < sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
+        ESP_LOGE(TAG, "Firmware is too small");
+        return false;
     }
 
-    size_t content_length = http->GetBodyLength();
-    if (content_length == 0) {
-        ESP_LOGE(TAG, "Failed to get content length");
-        delete http;
-        return;
+    esp_app_desc_t new_app_info;
+    memcpy(&new_app_info, block.data.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
+    ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
+
+    auto current_version = esp_app_get_description()->version;
+    if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
+        ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
+        return false;
     }
+    return true;
+}
 
-    char buffer[512];
-    size_t total_read = 0, recent_read = 0;
-    auto last_calc_time = esp_timer_get_time();
-    while (true) {
-        int ret = http->Read(buffer, sizeof(buffer));
-        if (ret < 0) {
-            ESP_LOGE(TAG, "Failed to read HTTP data: %s", esp_err_to_name(ret));
-            delete http;
-            return;
+bool Ota::GetPartitionSha256(const esp_partition_t* partition, size_t size, uint8_t* sha256) {
+    std::vector<uint8_t> buffer(SPI_FLASH_SEC_SIZE);
+    mbedtls_sha256_context context;
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts(&context, 0);
+    for (size_t offset = 0; offset < size; offset += buffer.size()) {
+        size_t count = std::min(buffer.size(), size - offset);
+        esp_err_t err = esp_partition_read(partition, offset, buffer.data(), count);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read partition %s: %s", partition->label, esp_err_to_name(err));
+            mbedtls_sha256_free(&context);
+            return false;
         }
+        mbedtls_sha256_update(&context, buffer.data(), count);
+    }
+    mbedtls_sha256_finish(&context, sha256);
+    mbedtls_sha256_free(&context);
+    return true;
+}
 
-        // Calculate speed and progress every second
-        recent_read += ret;
-        total_read += ret;
-        if (esp_timer_get_time() - last_calc_time >= 1000000 || ret == 0) {
-            size_t progress = total_read * 100 / content_length;
-            ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s", progress, total_read, content_length, recent_read);
-            if (upgrade_callback_) {
-                upgrade_callback_(progress, recent_read);
+// 把下载的数据写入 OTA 分区，块的起始位置都是扇区对齐的
+void Ota::WriterTask() {
+    size_t written = saved_offset_;
+    UpgradeBlock* block;
+    while (xQueueReceive(full_blocks_, &block, portMAX_DELAY) == pdTRUE && block != nullptr) {
+        if (!write_failed_) {
+            size_t erase_size = (block->size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+            esp_err_t err = esp_partition_erase_range(update_partition_, block->offset, erase_size);
+            if (err == ESP_OK) {
+                err = esp_partition_write(update_partition_, block->offset, block->data.data(), block->size);
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to write OTA data at 0x%zx: %s", block->offset, esp_err_to_name(err));
+                write_failed_ = true;
+            } else {
+                written = block->offset + block->size;
+                if (resumable_ && written - saved_offset_ >= OTA_PROGRESS_SAVE_INTERVAL) {
+                    SaveProgress(written);
+                    saved_offset_ = written;
+                }
             }
-            last_calc_time = esp_timer_get_time();
-            recent_read = 0;
         }
+        xQueueSend(free_blocks_, &block, portMAX_DELAY);
+    }
 
-        if (ret == 0) {
-            break;
+    // 下载中断时也保存已经写入的位置，下次从这里继续
+    if (resumable_ && written != saved_offset_) {
+        SaveProgress(written);
+        saved_offset_ = written;
+    }
+    xSemaphoreGive(writer_done_);
+}
+
+void Ota::StartWriter(size_t offset) {
+    saved_offset_ = offset;
+    output_offset_ = offset;
+    current_block_ = nullptr;
+    write_failed_ = false;
+
+    // full_blocks_ 多留一个位置给结束标记
+    free_blocks_ = xQueueCreate(2, sizeof(UpgradeBlock*));
+    full_blocks_ = xQueueCreate(3, sizeof(UpgradeBlock*));
+    writer_done_ = xSemaphoreCreateBinary();
+    for (auto& block : upgrade_blocks_) {
+        block.data.resize(OTA_BLOCK_SIZE);
+        UpgradeBlock* ptr = &block;
+        xQueueSend(free_blocks_, &ptr, 0);
+    }
+
+    xTaskCreate([](void* arg) {
+        Ota* ota = (Ota*)arg;
+        ota->WriterTask();
+        vTaskDelete(NULL);
+    }, "ota_writer", 4096, this, uxTaskPriorityGet(NULL), nullptr);
+}
+
+// 等待写入任务处理完所有的块，返回是否全部写入成功
+bool Ota::StopWriter() {
+    UpgradeBlock* end_marker = nullptr;
+    xQueueSend(full_blocks_, &end_marker, portMAX_DELAY);
+    xSemaphoreTake(writer_done_, portMAX_DELAY);
+    vQueueDelete(free_blocks_);
+    vQueueDelete(full_blocks_);
+    vSemaphoreDelete(writer_done_);
+    free_blocks_ = nullptr;
+    full_blocks_ = nullptr;
+    writer_done_ = nullptr;
+    current_block_ = nullptr;
+    for (auto& block : upgrade_blocks_) {
+        std::vector<char>().swap(block.data);
+    }
+    return !write_failed_;
+}
+
+// 取得正在填充的块，没有时等待写入任务归还一块
+bool Ota::AcquireBlock() {
+    if (current_block_ == nullptr) {
+        xQueueReceive(free_blocks_, &current_block_, portMAX_DELAY);
+        if (write_failed_) {
+            return false;
         }
+        current_block_->offset = output_offset_;
+        current_block_->size = 0;
+    }
+    return true;
+}
 
-        if (!image_header_checked) {
-            image_header.append(buffer, ret);
-            if (image_header.size() >= sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t)) {
-                esp_app_desc_t new_app_info;
-                memcpy(&new_app_info, image_header.data() + sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t), sizeof(esp_app_desc_t));
-                ESP_LOGI(TAG, "New firmware version: %s", new_app_info.version);
-
-                auto current_version = esp_app_get_description()->version;
-                if (memcmp(new_app_info.version, current_version, sizeof(new_app_info.version)) == 0) {
-                    ESP_LOGE(TAG, "Firmware version is the same, skipping upgrade");
-                    delete http;
-                    return;
-                }
+// 块写满或者 flush 时交给写入任务，第一块提交前检查镜像头
+bool Ota::CommitBlock(bool flush) {
+    auto block = current_block_;
+    if (block == nullptr || block->size == 0 || (!flush && block->size < block->data.size())) {
+        return true;
+    }
+    if (block->offset == 0 && !CheckImageHeader(*block)) {
+        return false;
+    }
+    xQueueSend(full_blocks_, &block, portMAX_DELAY);
+    current_block_ = nullptr;
+    return true;
+}
 
-                if (esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &update_handle)) {
-                    esp_ota_abort(update_handle);
-                    delete http;
-                    ESP_LOGE(TAG, "Failed to begin OTA");
-                    return;
-                }
+bool Ota::WriteOutput(const char* data, size_t size) {
+    while (size > 0) {
+        if (!AcquireBlock()) {
+            return false;
+        }
+        size_t count = std::min(current_block_->data.size() - current_block_->size, size);
+        memcpy(current_block_->data.data() + current_block_->size, data, count);
+        current_block_->size += count;
+        output_offset_ += count;
+        data += count;
+        size -= count;
+        if (!CommitBlock(false)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-                image_header_checked = true;
-                std::string().swap(image_header);
-            }
+// 差分升级时从正在运行的分区直接读到块里，不经过中间缓冲区
+bool Ota::CopyOutput(const esp_partition_t* source, size_t source_offset, size_t size) {
+    while (size > 0) {
+        if (!AcquireBlock()) {
+            return false;
         }
-        auto err = esp_ota_write(update_handle, buffer, ret);
+        size_t count = std::min(current_block_->data.size() - current_block_->size, size);
+        esp_err_t err = esp_partition_read(source, source_offset, current_block_->data.data() + current_block_->size, count);
         if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to write OTA data: %s", esp_err_to_name(err));
-            esp_ota_abort(update_handle);
-            delete http;
-            return;
+            ESP_LOGE(TAG, "Failed to read running partition: %s", esp_err_to_name(err));
+            return false;
+        }
+        current_block_->size += count;
+        output_offset_ += count;
+        source_offset += count;
+        size -= count;
+        if (!CommitBlock(false)) {
+            return false;
         }
     }
-    delete http;
+    return true;
+}
+
+// 下载到 total_size 为止，连接断开时用 Range 请求从 offset 继续
+// on_data 返回 false 或者写入任务失败时放弃下载，不再重试
+bool Ota::Download(const std::string& url, size_t& offset, size_t& total_size, std::function<bool(const char* data, size_t size)> on_data) {
+    OtaDownloader downloader([]() {
+        return Board::GetInstance().CreateHttp();
+    });
+    downloader.SetBandwidthLimit(bandwidth_limit_);
+    downloader.SetPauseCallback(pause_callback_);
+    downloader.OnProgress(upgrade_callback_);
+    downloader.OnTotalSize([this, &url](size_t total_size) {
+        if (resumable_) {
+            Settings settings("ota", true);
+            settings.SetString("url", url);
+            settings.SetString("partition", update_partition_->label);
+            settings.SetInt("size", total_size);
+        }
+    });
+    downloader.OnSizeChanged([this]() {
+        // 服务器上的文件已经更换，之前下载的数据无效
+        ClearProgress();
+    });
+    return downloader.Download(url, offset, total_size, [this, &on_data](const char* data, size_t size) {
+        return !write_failed_ && on_data(data, size);
+    });
+}
 
-    esp_err_t err = esp_ota_end(update_handle);
+// 设置启动分区时会校验整个镜像，无论成功与否下载进度都不再需要
+bool Ota::ApplyUpgrade() {
+    esp_err_t err = esp_ota_set_boot_partition(update_partition_);
+    ClearProgress();
     if (err != ESP_OK) {
         if (err == ESP_ERR_OTA_VALIDATE_FAILED) {
             ESP_LOGE(TAG, "Image validation failed, image is corrupted");
         } else {
-            ESP_LOGE(TAG, "Failed to end OTA: %s", esp_err_to_name(err));
+            ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
         }
-        return;
-    }
-
-    err = esp_ota_set_boot_partition(update_partition);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set boot partition: %s", esp_err_to_name(err));
-        return;
+        return false;
     }
 
+    Settings::Flush();
     ESP_LOGI(TAG, "Firmware upgrade successful, rebooting in 3 seconds...");
     vTaskDelay(pdMS_TO_TICKS(3000));
     esp_restart();
+    return true;
 }
 
-void Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
+bool Ota::StageFirmware(const std::string& firmware_url) {
+    ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
+    update_partition_ = esp_ota_get_next_update_partition(NULL);
+    if (update_partition_ == NULL) {
+        ESP_LOGE(TAG, "Failed to get update partition");
+        return false;
+    }
+    ESP_LOGI(TAG, "Writing to partition %s at offset 0x%lx", update_partition_->label, update_partition_->address);
+
+    // 上次升级被中断时，从已经写入的位置继续下载
+    size_t offset = 0, total_size = 0;
+    {
+        Settings settings("ota");
+        if (settings.GetString("url") == firmware_url && settings.GetString("partition") == update_partition_->label) {
+            offset = settings.GetInt("offset");
+            total_size = settings.GetInt("size");
+        }
+    }
+    if (offset > total_size || total_size > update_partition_->size) {
+        offset = 0;
+        total_size = 0;
+    }
+    if (offset > 0) {
+        ESP_LOGI(TAG, "Resuming upgrade from %zu/%zu", offset, total_size);
+    } else {
+        ClearProgress();
+    }
+
+    resumable_ = true;
+    StartWriter(offset);
+    bool success = Download(firmware_url, offset, total_size, [this](const char* data, size_t size) {
+        if (output_offset_ + size > update_partition_->size) {
+            ESP_LOGE(TAG, "Firmware exceeds partition size %lu", update_partition_->size);
+            return false;
+        }
+        return WriteOutput(data, size);
+    });
+    success = success && CommitBlock(true);
+    return StopWriter() && success;
+}
+
+// 补丁中只有新增的数据，其余部分从正在运行的分区复制，写完之后校验 SHA-256
+bool Ota::StageDelta(const std::string& delta_url) {
+    ESP_LOGI(TAG, "Upgrading firmware with delta patch from %s", delta_url.c_str());
+    auto running_partition = esp_ota_get_running_partition();
+    update_partition_ = esp_ota_get_next_update_partition(NULL);
+    if (update_partition_ == NULL) {
+        ESP_LOGE(TAG, "Failed to get update partition");
+        return false;
+    }
+
+    DeltaPatch patch;
+    patch.OnHeader([this, running_partition](const DeltaPatchHeader& header) {
+        if (header.source_size > running_partition->size || header.target_size > update_partition_->size) {
+            ESP_LOGE(TAG, "Patch size does not fit the partitions");
+            return false;
+        }
+        uint8_t sha256[32];
+        if (!GetPartitionSha256(running_partition, header.source_size, sha256)) {
+            return false;
+        }
+        if (memcmp(sha256, header.source_sha256, sizeof(sha256)) != 0) {
+            ESP_LOGE(TAG, "Patch is not made for the running firmware");
+            return false;
+        }
+        return true;
+    });
+    patch.OnCopy([this, running_partition](size_t source_offset, size_t size) {
+        return CopyOutput(running_partition, source_offset, size);
+    });
+    patch.OnInsert([this](const char* data, size_t size) {
+        return WriteOutput(data, size);
+    });
+
+    // 补丁的输出位置和下载位置不对应，中断之后不能跨重启续传
+    // 差分升级会覆盖更新分区，之前保存的完整升级进度失效，失败后退回完整升级时要从头下载
+    resumable_ = false;
+    ClearProgress();
+    StartWriter(0);
+    size_t offset = 0, total_size = 0;
+    bool success = Download(delta_url, offset, total_size, [&patch](const char* data, size_t size) {
+        return patch.Feed(data, size);
+    });
+    if (success && !patch.IsComplete()) {
+        ESP_LOGE(TAG, "Patch is incomplete");
+        success = false;
+    }
+    success = success && CommitBlock(true);
+    success = StopWriter() && success;
+    if (!success) {
+        return false;
+    }
+
+    uint8_t sha256[32];
+    if (!GetPartitionSha256(update_partition_, patch.header().target_size, sha256)) {
+        return false;
+    }
+    if (memcmp(sha256, patch.header().target_sha256, sizeof(sha256)) != 0) {
+        ESP_LOGE(TAG, "Patched firmware hash mismatch");
+        return false;
+    }
+    return true;
+}
+
+bool Ota::StageUpgrade(std::function<void(int progress, size_t speed)> callback) {
     upgrade_callback_ = callback;
-    Upgrade(firmware_url_);
+    // 差分升级失败时退回完整升级
+    if (!delta_url_.empty()) {
+        if (StageDelta(delta_url_)) {
+            return true;
+        }
+        ESP_LOGW(TAG, "Delta upgrade failed, falling back to the full image");
+    }
+    return StageFirmware(firmware_url_);
+}
+
+void Ota::StartUpgrade(std::function<void(int progress, size_t speed)> callback) {
+    if (StageUpgrade(callback)) {
+        ApplyUpgrade();
+    }
 }
 
 std::vector<int> Ota::ParseVersion(const std::string& version) {
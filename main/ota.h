@@ -4,6 +4,14 @@
 #include <functional>
 #include <string>
 #include <map>
+#include <vector>
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <esp_partition.h>
 
 class Ota {
 public:
@@ -19,7 +27,16 @@ public:
     bool HasActivationCode() { return has_activation_code_; }
     bool HasServerTime() { return has_server_time_; }
     void StartUpgrade(std::function<void(int progress, size_t speed)> callback);
+    // 只下载和写入新固件，不切换启动分区，之后调用 ApplyUpgrade 校验并重启
+    bool StageUpgrade(std::function<void(int progress, size_t speed)> callback);
+    bool ApplyUpgrade();
+    // 后台下载时限制带宽，bytes_per_second 为 0 时不限速
+    void SetBandwidthLimit(size_t bytes_per_second) { bandwidth_limit_ = bytes_per_second; }
+    // 回调返回 true 时断开连接暂停下载，返回 false 后从断点继续
+    void SetPauseCallback(std::function<bool()> callback) { pause_callback_ = callback; }
     void MarkCurrentVersionValid();
+    // 使用上一次成功的版本检查结果（MQTT 配置在 NVS 中），需要激活或者已过期时返回 false
+    bool LoadCachedConfig();
 
     const std::string& GetFirmwareVersion() const { return firmware_version_; }
     const std::string& GetCurrentVersion() const { return current_version_; }
@@ -40,7 +57,42 @@ private:
     std::string post_data_;
     std::map<std::string, std::string> headers_;
 
-    void Upgrade(const std::string& firmware_url);
+    // 下载任务把固件分块交给写入任务，两块缓冲区轮流使用，下载和写 flash 同时进行
+    struct UpgradeBlock {
+        std::vector<char> data;
+        size_t size = 0;
+        size_t offset = 0;
+    };
+    UpgradeBlock upgrade_blocks_[2];
+    UpgradeBlock* current_block_ = nullptr;
+    QueueHandle_t free_blocks_ = nullptr;
+    QueueHandle_t full_blocks_ = nullptr;
+    SemaphoreHandle_t writer_done_ = nullptr;
+    const esp_partition_t* update_partition_ = nullptr;
+    std::atomic<bool> write_failed_ = false;
+    // 完整升级时在 NVS 中保存进度，重启后可以继续
+    bool resumable_ = false;
+    size_t saved_offset_ = 0;
+    size_t output_offset_ = 0;
+    std::string delta_url_;
+    size_t bandwidth_limit_ = 0;
+    std::function<bool()> pause_callback_;
+
+    bool StageFirmware(const std::string& firmware_url);
+    bool StageDelta(const std::string& delta_url);
+    bool Download(const std::string& url, size_t& offset, size_t& total_size, std::function<bool(const char* data, size_t size)> on_data);
+    void StartWriter(size_t offset);
+    bool StopWriter();
+    void WriterTask();
+    bool AcquireBlock();
+    bool CommitBlock(bool flush);
+    bool WriteOutput(const char* data, size_t size);
+    bool CopyOutput(const esp_partition_t* source, size_t source_offset, size_t size);
+    bool CheckImageHeader(const UpgradeBlock& block);
+    bool GetPartitionSha256(const esp_partition_t* partition, size_t size, uint8_t* sha256);
+    void SaveCachedConfig();
+    void SaveProgress(size_t offset);
+    void ClearProgress();
     std::function<void(int progress, size_t speed)> upgrade_callback_;
     std::vector<int> ParseVersion(const std::string& version);
     bool IsNewVersionAvailable(const std::string& currentVersion, const std::string& newVersion);
@@ -0,0 +1,156 @@
+#include "ota_downloader.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#define TAG "OtaDownloader"
+
+#define OTA_READ_BUFFER_SIZE 4096
+// 连续失败这么多次后放弃，下次升级时继续
+#define OTA_MAX_RETRIES 10
+#define OTA_MAX_RETRY_DELAY_MS 16000
+
+OtaDownloader::OtaDownloader(std::function<Http*()> create_http) : create_http_(create_http) {
+}
+
+bool OtaDownloader::Download(const std::string& url, size_t& offset, size_t& total_size,
+    std::function<bool(const char* data, size_t size)> on_data) {
+    std::vector<char> buffer(OTA_READ_BUFFER_SIZE);
+    size_t recent_read = 0;
+    auto last_calc_time = esp_timer_get_time();
+    int retries = 0;
+    while (total_size == 0 || offset < total_size) {
+        if (pause_callback_ && pause_callback_()) {
+            ESP_LOGI(TAG, "Download paused at %zu/%zu", offset, total_size);
+            while (pause_callback_()) {
+                vTaskDelay(pdMS_TO_TICKS(1000));
+            }
+            ESP_LOGI(TAG, "Download resumed");
+        }
+        if (retries > 0) {
+            if (retries > OTA_MAX_RETRIES) {
+                ESP_LOGE(TAG, "Too many failures, giving up at %zu/%zu", offset, total_size);
+                return false;
+            }
+            int delay_ms = std::min(1000 << (retries - 1), OTA_MAX_RETRY_DELAY_MS);
+            ESP_LOGW(TAG, "Retrying in %dms (%d/%d)", delay_ms, retries, OTA_MAX_RETRIES);
+            vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        }
+
+        std::unique_ptr<Http> http(create_http_());
+        if (offset > 0) {
+            http->SetHeader("Range", "bytes=" + std::to_string(offset) + "-");
+        }
+        if (!http->Open("GET", url)) {
+            ESP_LOGE(TAG, "Failed to open HTTP connection");
+            retries++;
+            continue;
+        }
+
+        int status_code = http->GetStatusCode();
+        size_t body_length = http->GetBodyLength();
+        size_t skip = 0;
+        size_t new_total_size;
+        if (status_code == 206) {
+            new_total_size = offset + body_length;
+        } else if (status_code == 200) {
+            // 服务器不支持 Range 时从头读取，跳过已经下载的部分
+            if (offset > 0) {
+                ESP_LOGW(TAG, "Server does not support range requests, skipping %zu bytes", offset);
+            }
+            skip = offset;
+            new_total_size = body_length;
+        } else {
+            ESP_LOGE(TAG, "Unexpected HTTP status code: %d", status_code);
+            http->Close();
+            retries++;
+            continue;
+        }
+        if (body_length == 0) {
+            ESP_LOGE(TAG, "Failed to get content length");
+            http->Close();
+            retries++;
+            continue;
+        }
+
+        if (total_size == 0) {
+            total_size = new_total_size;
+            if (on_total_size_) {
+                on_total_size_(total_size);
+            }
+        } else if (new_total_size != total_size) {
+            ESP_LOGE(TAG, "Download size changed from %zu to %zu", total_size, new_total_size);
+            http->Close();
+            if (on_size_changed_) {
+                on_size_changed_();
+            }
+            return false;
+        }
+
+        bool disconnected = false;
+        size_t window_read = 0;
+        auto window_start = esp_timer_get_time();
+        while (offset < total_size) {
+            size_t to_read = buffer.size();
+            if (skip > 0) {
+                to_read = std::min(to_read, skip);
+            } else {
+                to_read = std::min(to_read, total_size - offset);
+            }
+            int ret = http->Read(buffer.data(), to_read);
+            if (ret <= 0) {
+                ESP_LOGW(TAG, "Connection lost at %zu/%zu: %d", offset, total_size, ret);
+                disconnected = true;
+                break;
+            }
+            retries = 0;
+            if (skip > 0) {
+                skip -= ret;
+                continue;
+            }
+
+            if (!on_data(buffer.data(), ret)) {
+                http->Close();
+                return false;
+            }
+            offset += ret;
+            recent_read += ret;
+
+            // Calculate speed and progress every second
+            if (esp_timer_get_time() - last_calc_time >= 1000000 || offset == total_size) {
+                size_t progress = offset * 100 / total_size;
+                ESP_LOGI(TAG, "Progress: %zu%% (%zu/%zu), Speed: %zuB/s", progress, offset, total_size, recent_read);
+                if (on_progress_) {
+                    on_progress_(progress, recent_read);
+                }
+                last_calc_time = esp_timer_get_time();
+                recent_read = 0;
+            }
+
+            // 读得比限速快时等待，让出网络给正常的对话
+            if (bandwidth_limit_ > 0) {
+                window_read += ret;
+                int64_t expected_us = (int64_t)window_read * 1000000 / bandwidth_limit_;
+                int64_t elapsed_us = esp_timer_get_time() - window_start;
+                if (expected_us > elapsed_us) {
+                    vTaskDelay(pdMS_TO_TICKS((expected_us - elapsed_us) / 1000));
+                }
+            }
+            // 断开连接，恢复之后用 Range 请求继续
+            if (pause_callback_ && pause_callback_()) {
+                break;
+            }
+        }
+        http->Close();
+        if (disconnected) {
+            retries++;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef _OTA_DOWNLOADER_H_
+#define _OTA_DOWNLOADER_H_
+
+#include <http.h>
+
+#include <functional>
+#include <string>
+
+// 可以断点续传的 HTTP 下载，连接断开时按指数退避重试，用 Range 请求从已经收到的位置继续
+// 不依赖 Board，创建连接的方法由调用者提供，可以在主机上用模拟的 Http 测试
+class OtaDownloader {
+public:
+    explicit OtaDownloader(std::function<Http*()> create_http);
+
+    // 限制下载带宽，bytes_per_second 为 0 时不限速
+    void SetBandwidthLimit(size_t bytes_per_second) { bandwidth_limit_ = bytes_per_second; }
+    // 回调返回 true 时断开连接暂停下载，返回 false 后从断点继续
+    void SetPauseCallback(std::function<bool()> callback) { pause_callback_ = callback; }
+    // 每秒报告一次进度和速度
+    void OnProgress(std::function<void(int progress, size_t speed)> callback) { on_progress_ = callback; }
+    // 第一次得到文件大小时调用
+    void OnTotalSize(std::function<void(size_t total_size)> callback) { on_total_size_ = callback; }
+    // 重试时服务器上的文件大小和之前不同，已经下载的数据无效
+    void OnSizeChanged(std::function<void()> callback) { on_size_changed_ = callback; }
+
+    // 从 offset 下载到 total_size 为止，total_size 为 0 时由第一次响应决定，返回时两者都已更新
+    // on_data 返回 false 时放弃下载，不再重试
+    bool Download(const std::string& url, size_t& offset, size_t& total_size,
+        std::function<bool(const char* data, size_t size)> on_data);
+
+private:
+    std::function<Http*()> create_http_;
+    size_t bandwidth_limit_ = 0;
+    std::function<bool()> pause_callback_;
+    std::function<void(int progress, size_t speed)> on_progress_;
+    std::function<void(size_t total_size)> on_total_size_;
+    std::function<void()> on_size_changed_;
+};
+
+#endif // _OTA_DOWNLOADER_H_
@@ -0,0 +1,201 @@
+#include "profiler.h"
+#include "memory_pool.h"
+#include "sound_cache.h"
+#include "glyph_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cJSON.h>
+#include <algorithm>
+
+#define TAG "Profiler"
+
+Profiler::Profiler() {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            Profiler* profiler = (Profiler*)arg;
+            profiler->Print();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "profiler_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&timer_args, &periodic_timer_);
+}
+
+Profiler::~Profiler() {
+    if (periodic_timer_ != nullptr) {
+        esp_timer_stop(periodic_timer_);
+        esp_timer_delete(periodic_timer_);
+    }
+}
+
+void Profiler::StartPeriodic(int interval_seconds) {
+    esp_timer_stop(periodic_timer_);
+    if (interval_seconds > 0) {
+        ESP_LOGI(TAG, "Start periodic profiling every %d seconds", interval_seconds);
+        esp_timer_start_periodic(periodic_timer_, interval_seconds * 1000000LL);
+    }
+}
+
+void Profiler::StopPeriodic() {
+    esp_timer_stop(periodic_timer_);
+}
+
+HeapProfile Profiler::GetHeapProfile(uint32_t caps) {
+    HeapProfile profile;
+    profile.free_size = heap_caps_get_free_size(caps);
+    profile.minimum_free_size = heap_caps_get_minimum_free_size(caps);
+    profile.largest_free_block = heap_caps_get_largest_free_block(caps);
+    return profile;
+}
+
+bool Profiler::Sample() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 预留几个位置，防止采样期间有新任务创建
+    std::vector<TaskStatus_t> tasks(uxTaskGetNumberOfTasks() + 5);
+    configRUN_TIME_COUNTER_TYPE run_time = 0;
+    UBaseType_t count = uxTaskGetSystemState(tasks.data(), tasks.size(), &run_time);
+    if (count == 0) {
+        ESP_LOGE(TAG, "Failed to get system state");
+        return false;
+    }
+    tasks.resize(count);
+
+    // 两次采样间隔较长时，乘以核数后会超出 32 位
+    uint64_t total_elapsed = (uint64_t)(run_time - last_run_time_) * CONFIG_FREERTOS_NUMBER_OF_CORES;
+    tasks_.clear();
+    tasks_.reserve(count);
+    for (auto& task : tasks) {
+        uint32_t task_elapsed = task.ulRunTimeCounter;
+        auto it = std::find_if(last_tasks_.begin(), last_tasks_.end(), [&task](const TaskStatus_t& last) {
+            return last.xHandle == task.xHandle;
+        });
+        if (it != last_tasks_.end()) {
+            task_elapsed -= it->ulRunTimeCounter;
+        }
+
+        TaskProfile profile;
+        profile.name = task.pcTaskName;
+        profile.priority = task.uxCurrentPriority;
+        profile.stack_high_water_mark = task.usStackHighWaterMark;
+        profile.cpu_permille = total_elapsed > 0 ? (uint64_t)task_elapsed * 1000 / total_elapsed : 0;
+        tasks_.push_back(std::move(profile));
+    }
+    std::sort(tasks_.begin(), tasks_.end(), [](const TaskProfile& a, const TaskProfile& b) {
+        return a.cpu_permille > b.cpu_permille;
+    });
+
+    last_tasks_ = std::move(tasks);
+    last_run_time_ = run_time;
+    last_sample_time_ = esp_timer_get_time();
+
+    internal_heap_ = GetHeapProfile(MALLOC_CAP_INTERNAL);
+    psram_heap_ = GetHeapProfile(MALLOC_CAP_SPIRAM);
+    return true;
+}
+
+static cJSON* HeapProfileToJson(const HeapProfile& profile) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "free", profile.free_size);
+    cJSON_AddNumberToObject(json, "minimum_free", profile.minimum_free_size);
+    cJSON_AddNumberToObject(json, "largest_free_block", profile.largest_free_block);
+    return json;
+}
+
+std::string Profiler::GetJson() {
+    if (!Sample()) {
+        return "{}";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "uptime_ms", last_sample_time_ / 1000);
+
+    cJSON* tasks = cJSON_CreateArray();
+    for (auto& task : tasks_) {
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", task.name.c_str());
+        cJSON_AddNumberToObject(item, "priority", task.priority);
+        cJSON_AddNumberToObject(item, "cpu", task.cpu_permille / 10.0);
+        cJSON_AddNumberToObject(item, "stack_high_water_mark", task.stack_high_water_mark);
+        cJSON_AddItemToArray(tasks, item);
+    }
+    cJSON_AddItemToObject(root, "tasks", tasks);
+
+    cJSON* heap = cJSON_CreateObject();
+    cJSON_AddItemToObject(heap, "internal", HeapProfileToJson(internal_heap_));
+    cJSON_AddItemToObject(heap, "psram", HeapProfileToJson(psram_heap_));
+    cJSON_AddItemToObject(root, "heap", heap);
+
+    cJSON* pools = cJSON_CreateArray();
+    for (auto& stats : MemoryPool::GetAllStats()) {
+        cJSON* item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", stats.name);
+        cJSON_AddNumberToObject(item, "block_size", stats.block_size);
+        cJSON_AddNumberToObject(item, "block_count", stats.block_count);
+        cJSON_AddNumberToObject(item, "in_use", stats.blocks_in_use);
+        cJSON_AddNumberToObject(item, "peak_in_use", stats.peak_blocks_in_use);
+        cJSON_AddNumberToObject(item, "fallback", stats.fallback_allocations);
+        cJSON_AddBoolToObject(item, "psram", stats.in_psram);
+        cJSON_AddItemToArray(pools, item);
+    }
+    cJSON_AddItemToObject(root, "pools", pools);
+
+    auto sound_cache = SoundCache::GetInstance().GetStats();
+    cJSON* cache = cJSON_CreateObject();
+    cJSON_AddNumberToObject(cache, "entries", sound_cache.entries);
+    cJSON_AddNumberToObject(cache, "used", sound_cache.used_bytes);
+    cJSON_AddNumberToObject(cache, "budget", sound_cache.budget_bytes);
+    cJSON_AddNumberToObject(cache, "hits", sound_cache.hits);
+    cJSON_AddNumberToObject(cache, "misses", sound_cache.misses);
+    cJSON_AddNumberToObject(cache, "rejected", sound_cache.rejected);
+    cJSON_AddItemToObject(root, "sound_cache", cache);
+
+    auto glyph_cache = GlyphCache::GetInstance().GetStats();
+    cache = cJSON_CreateObject();
+    cJSON_AddNumberToObject(cache, "entries", glyph_cache.entries);
+    cJSON_AddNumberToObject(cache, "used", glyph_cache.used_bytes);
+    cJSON_AddNumberToObject(cache, "metadata", glyph_cache.metadata_bytes);
+    cJSON_AddNumberToObject(cache, "budget", glyph_cache.budget_bytes);
+    cJSON_AddNumberToObject(cache, "hits", glyph_cache.hits);
+    cJSON_AddNumberToObject(cache, "misses", glyph_cache.misses);
+    cJSON_AddNumberToObject(cache, "evictions", glyph_cache.evictions);
+    cJSON_AddItemToObject(root, "glyph_cache", cache);
+
+    char* str = cJSON_PrintUnformatted(root);
+    std::string json = str;
+    cJSON_free(str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void Profiler::Print() {
+    if (!Sample()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ESP_LOGI(TAG, "%-16s %4s %7s %6s", "Task", "Prio", "CPU", "Stack");
+    for (auto& task : tasks_) {
+        ESP_LOGI(TAG, "%-16s %4u %3lu.%lu%% %6lu", task.name.c_str(), task.priority,
+            task.cpu_permille / 10, task.cpu_permille % 10, task.stack_high_water_mark);
+    }
+    ESP_LOGI(TAG, "Internal free: %u minimal: %u largest: %u", internal_heap_.free_size,
+        internal_heap_.minimum_free_size, internal_heap_.largest_free_block);
+    ESP_LOGI(TAG, "PSRAM free: %u minimal: %u largest: %u", psram_heap_.free_size,
+        psram_heap_.minimum_free_size, psram_heap_.largest_free_block);
+    MemoryPool::PrintAllStats();
+
+    auto sound_cache = SoundCache::GetInstance().GetStats();
+    ESP_LOGI(TAG, "Sound cache: %u entries, %u/%u bytes, hits: %lu misses: %lu rejected: %lu",
+        sound_cache.entries, sound_cache.used_bytes, sound_cache.budget_bytes,
+        sound_cache.hits, sound_cache.misses, sound_cache.rejected);
+
+    auto glyph_cache = GlyphCache::GetInstance().GetStats();
+    ESP_LOGI(TAG, "Glyph cache: %u entries, %u/%u bytes (metadata %u), hits: %lu misses: %lu evictions: %lu",
+        glyph_cache.entries, glyph_cache.used_bytes, glyph_cache.budget_bytes, glyph_cache.metadata_bytes,
+        glyph_cache.hits, glyph_cache.misses, glyph_cache.evictions);
+}
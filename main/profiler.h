@@ -0,0 +1,62 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+struct TaskProfile {
+    std::string name;
+    UBaseType_t priority;
+    uint32_t stack_high_water_mark;
+    // 单位为 0.1%，相对于所有核心的总时间
+    uint32_t cpu_permille;
+};
+
+struct HeapProfile {
+    size_t free_size;
+    size_t minimum_free_size;
+    size_t largest_free_block;
+};
+
+// 只在被调用时采样，空闲时没有任何开销
+class Profiler {
+public:
+    static Profiler& GetInstance() {
+        static Profiler instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // CPU 占用按与上一次采样之间的时间计算
+    bool Sample();
+    std::string GetJson();
+    void Print();
+
+    void StartPeriodic(int interval_seconds);
+    void StopPeriodic();
+
+private:
+    Profiler();
+    ~Profiler();
+
+    std::mutex mutex_;
+    esp_timer_handle_t periodic_timer_ = nullptr;
+    std::vector<TaskStatus_t> last_tasks_;
+    configRUN_TIME_COUNTER_TYPE last_run_time_ = 0;
+    int64_t last_sample_time_ = 0;
+
+    std::vector<TaskProfile> tasks_;
+    HeapProfile internal_heap_ = {};
+    HeapProfile psram_heap_ = {};
+
+    static HeapProfile GetHeapProfile(uint32_t caps);
+};
+
+#endif // _PROFILER_H_
@@ -81,7 +81,7 @@ bool IdiomProtocol::StartIdiomClient(bool report_error) {
         {
             // 处理音频数据
             ESP_LOGE(TAG, "Received audio data");
-            std::vector<uint8_t> audio_data(payload.begin(), payload.end());
+            OpusPacket audio_data(payload.begin(), payload.end());
             auto& app = Application::GetInstance();
             Protocol* protocol_ = app.GetMqttProtocol();
             if(protocol_ != nullptr)
@@ -173,7 +173,7 @@ void IdiomProtocol::SendText(const std::string& text) {
     }
 }
 
-void IdiomProtocol::SendAudio(const std::vector<uint8_t>& data) {
+void IdiomProtocol::SendAudio(const OpusPacket& data) {
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return;
@@ -270,7 +270,7 @@ bool IdiomProtocol::OpenAudioChannel() {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
         }
 
-        std::vector<uint8_t> decrypted;
+        OpusPacket decrypted;
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
         uint8_t stream_block[16] = {0};
@@ -110,7 +110,7 @@ void MqttProtocol::SendText(const std::string& text) {
     }
 }
 
-void MqttProtocol::SendAudio(const std::vector<uint8_t>& data) {
+void MqttProtocol::SendAudio(const OpusPacket& data) {
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return;
@@ -207,7 +207,7 @@ bool MqttProtocol::OpenAudioChannel() {
             ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
         }
 
-        std::vector<uint8_t> decrypted;
+        OpusPacket decrypted;
         size_t decrypted_size = data.size() - aes_nonce_.size();
         size_t nc_off = 0;
         uint8_t stream_block[16] = {0};
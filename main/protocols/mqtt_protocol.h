@@ -26,7 +26,7 @@ public:
     ~MqttProtocol();
 
     void Start() override;
-    void SendAudio(const std::vector<uint8_t>& data) override;
+    void SendAudio(const OpusPacket& data) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -8,7 +8,7 @@ void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
 
-void Protocol::OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback) {
+void Protocol::OnIncomingAudio(std::function<void(OpusPacket&& data)> callback) {
     on_incoming_audio_ = callback;
 }
 
@@ -115,6 +115,11 @@ void Protocol::SendIotStates(const std::string& states) {
     SendText(message);
 }
 
+void Protocol::SendLatency(const char* kind, const std::string& stats) {
+    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"latency\",\"kind\":\"" + kind + "\",\"stats\":" + stats + "}";
+    SendText(message);
+}
+
 bool Protocol::IsTimeout() const {
     const int kTimeoutSeconds = 120;
     auto now = std::chrono::steady_clock::now();
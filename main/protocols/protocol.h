@@ -6,6 +6,8 @@
 #include <functional>
 #include <chrono>
 
+#include "memory_pool.h"
+
 struct BinaryProtocol3 {
     uint8_t type;
     uint8_t reserved;
@@ -35,7 +37,7 @@ public:
         return session_id_;
     }
 
-    void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback);
+    void OnIncomingAudio(std::function<void(OpusPacket&& data)> callback);
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
@@ -45,17 +47,18 @@ public:
     virtual bool OpenAudioChannel() = 0;
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
-    virtual void SendAudio(const std::vector<uint8_t>& data) = 0;
+    virtual void SendAudio(const OpusPacket& data) = 0;
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
+    virtual void SendLatency(const char* kind, const std::string& stats);
 
 protected:
     std::function<void(const cJSON* root)> on_incoming_json_;
-    std::function<void(std::vector<uint8_t>&& data)> on_incoming_audio_;
+    std::function<void(OpusPacket&& data)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
     std::function<void()> on_audio_channel_closed_;
     std::function<void(const std::string& message)> on_network_error_;
@@ -25,7 +25,7 @@ WebsocketProtocol::~WebsocketProtocol() {
 void WebsocketProtocol::Start() {
 }
 
-void WebsocketProtocol::SendAudio(const std::vector<uint8_t>& data) {
+void WebsocketProtocol::SendAudio(const OpusPacket& data) {
     if (websocket_ == nullptr) {
         return;
     }
@@ -72,7 +72,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
         if (binary) {
             if (on_incoming_audio_ != nullptr) {
-                on_incoming_audio_(std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len));
+                on_incoming_audio_(OpusPacket((uint8_t*)data, (uint8_t*)data + len));
             }
         } else {
             // Parse JSON data
@@ -16,7 +16,7 @@ public:
     ~WebsocketProtocol();
 
     void Start() override;
-    void SendAudio(const std::vector<uint8_t>& data) override;
+    void SendAudio(const OpusPacket& data) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
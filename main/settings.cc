@@ -1,58 +1,43 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
+#include <algorithm>
 
 #define TAG "Settings"
 
+// 最后一次修改之后等待这么久再写入，拖动音量等连续修改只写一次
+#define SETTINGS_FLUSH_DELAY_MS 1000
+// 一直有修改时最多推迟这么久
+#define SETTINGS_MAX_FLUSH_DELAY_MS 5000
+#define SETTINGS_FLUSH_TASK_PRIORITY 1
+
 Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
 }
 
 Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
-        }
-        nvs_close(nvs_handle_);
-    }
 }
 
 std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
-    }
-
     std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    if (!SettingsStore::GetInstance().GetString(ns_, key, value)) {
+        return default_value;
     }
     return value;
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        SettingsStore::GetInstance().SetString(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
     int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    if (!SettingsStore::GetInstance().GetInt(ns_, key, value)) {
         return default_value;
     }
     return value;
@@ -60,8 +45,7 @@ int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        SettingsStore::GetInstance().SetInt(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -69,10 +53,7 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsStore::GetInstance().EraseKey(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,8 +61,256 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsStore::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsStore::GetInstance().Flush();
+}
+
+SettingsStore::SettingsStore() {
+    xTaskCreate([](void* arg) {
+        SettingsStore* store = (SettingsStore*)arg;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            store->Flush();
+        }
+    }, "settings_flush", 4096, this, SETTINGS_FLUSH_TASK_PRIORITY, &flush_task_);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            SettingsStore* store = (SettingsStore*)arg;
+            xTaskNotifyGive(store->flush_task_);
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "settings_flush",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&timer_args, &flush_timer_);
+
+    // esp_restart 之前写入所有修改
+    esp_register_shutdown_handler([]() {
+        SettingsStore::GetInstance().Flush();
+    });
+}
+
+SettingsStore::~SettingsStore() {
+    Flush();
+    if (flush_timer_ != nullptr) {
+        esp_timer_stop(flush_timer_);
+        esp_timer_delete(flush_timer_);
+    }
+    for (auto& [name, ns] : namespaces_) {
+        if (ns.handle != 0) {
+            nvs_close(ns.handle);
+        }
+    }
+}
+
+// 只读打开不存在的命名空间会失败，这时每次读取都重新尝试，第一次写入时再以读写方式打开
+SettingsStore::Namespace* SettingsStore::Open(const std::string& ns, bool writable) {
+    auto& entry = namespaces_[ns];
+    if (entry.handle != 0 && (entry.writable || !writable)) {
+        return &entry;
+    }
+    if (entry.handle != 0) {
+        nvs_close(entry.handle);
+        entry.handle = 0;
+    }
+    esp_err_t err = nvs_open(ns.c_str(), writable ? NVS_READWRITE : NVS_READONLY, &entry.handle);
+    if (err != ESP_OK) {
+        if (writable) {
+            ESP_LOGE(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+        }
+        entry.handle = 0;
+        return nullptr;
+    }
+    entry.writable = writable;
+    return &entry;
+}
+
+bool SettingsStore::GetString(const std::string& ns, const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& values = namespaces_[ns].values;
+    auto it = values.find(key);
+    if (it != values.end()) {
+        if (!it->second.is_string) {
+            return false;
+        }
+        value = it->second.string_value;
+        return true;
+    }
+
+    auto entry = Open(ns, false);
+    if (entry == nullptr) {
+        return false;
+    }
+    size_t length = 0;
+    if (nvs_get_str(entry->handle, key.c_str(), nullptr, &length) != ESP_OK) {
+        return false;
+    }
+    value.resize(length);
+    if (nvs_get_str(entry->handle, key.c_str(), value.data(), &length) != ESP_OK) {
+        return false;
+    }
+    while (!value.empty() && value.back() == '\0') {
+        value.pop_back();
+    }
+
+    auto& cached = values[key];
+    cached.is_string = true;
+    cached.string_value = value;
+    return true;
+}
+
+void SettingsStore::SetString(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& values = namespaces_[ns].values;
+    auto it = values.find(key);
+    if (it != values.end() && it->second.is_string && it->second.string_value == value) {
+        return;
+    }
+    auto& cached = values[key];
+    cached.is_string = true;
+    cached.string_value = value;
+    cached.dirty = true;
+    ScheduleFlush();
+}
+
+bool SettingsStore::GetInt(const std::string& ns, const std::string& key, int32_t& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& values = namespaces_[ns].values;
+    auto it = values.find(key);
+    if (it != values.end()) {
+        if (it->second.is_string) {
+            return false;
+        }
+        value = it->second.int_value;
+        return true;
+    }
+
+    auto entry = Open(ns, false);
+    if (entry == nullptr || nvs_get_i32(entry->handle, key.c_str(), &value) != ESP_OK) {
+        return false;
+    }
+    auto& cached = values[key];
+    cached.is_string = false;
+    cached.int_value = value;
+    return true;
+}
+
+void SettingsStore::SetInt(const std::string& ns, const std::string& key, int32_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& values = namespaces_[ns].values;
+    auto it = values.find(key);
+    if (it != values.end() && !it->second.is_string && it->second.int_value == value) {
+        return;
+    }
+    auto& cached = values[key];
+    cached.is_string = false;
+    cached.int_value = value;
+    cached.dirty = true;
+    ScheduleFlush();
+}
+
+// 删除操作很少发生，直接写入 flash
+void SettingsStore::EraseKey(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = Open(ns, true);
+    if (entry == nullptr) {
+        return;
+    }
+    entry->values.erase(key);
+    auto err = nvs_erase_key(entry->handle, key.c_str());
+    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGE(TAG, "Failed to erase %s.%s: %s", ns.c_str(), key.c_str(), esp_err_to_name(err));
+        return;
+    }
+    nvs_commit(entry->handle);
+}
+
+void SettingsStore::EraseAll(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entry = Open(ns, true);
+    if (entry == nullptr) {
+        return;
+    }
+    entry->values.clear();
+    auto err = nvs_erase_all(entry->handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase namespace %s: %s", ns.c_str(), esp_err_to_name(err));
+        return;
+    }
+    nvs_commit(entry->handle);
+}
+
+void SettingsStore::ScheduleFlush() {
+    int64_t now = esp_timer_get_time();
+    if (first_dirty_time_ == 0) {
+        first_dirty_time_ = now;
+    }
+    int64_t delay_us = std::min<int64_t>(SETTINGS_FLUSH_DELAY_MS * 1000,
+        first_dirty_time_ + SETTINGS_MAX_FLUSH_DELAY_MS * 1000 - now);
+    esp_timer_stop(flush_timer_);
+    esp_timer_start_once(flush_timer_, std::max<int64_t>(delay_us, 0));
+}
+
+void SettingsStore::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlushLocked();
+}
+
+void SettingsStore::FlushLocked() {
+    if (first_dirty_time_ == 0) {
+        return;
+    }
+    first_dirty_time_ = 0;
+
+    bool failed = false;
+    for (auto& [name, ns] : namespaces_) {
+        bool dirty = std::any_of(ns.values.begin(), ns.values.end(), [](const auto& item) {
+            return item.second.dirty;
+        });
+        if (!dirty) {
+            continue;
+        }
+        auto entry = Open(name, true);
+        if (entry == nullptr) {
+            failed = true;
+            continue;
+        }
+
+        int count = 0;
+        for (auto& [key, value] : entry->values) {
+            if (!value.dirty) {
+                continue;
+            }
+            esp_err_t err;
+            if (value.is_string) {
+                err = nvs_set_str(entry->handle, key.c_str(), value.string_value.c_str());
+            } else {
+                err = nvs_set_i32(entry->handle, key.c_str(), value.int_value);
+            }
+            if (err != ESP_OK) {
+                // 保留修改，下次修改或者调用 Flush 时重试
+                ESP_LOGE(TAG, "Failed to write %s.%s: %s", name.c_str(), key.c_str(), esp_err_to_name(err));
+                failed = true;
+                continue;
+            }
+            value.dirty = false;
+            count++;
+        }
+        esp_err_t err = nvs_commit(entry->handle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit namespace %s: %s", name.c_str(), esp_err_to_name(err));
+        }
+        ESP_LOGD(TAG, "Flushed %d values to namespace %s", count, name.c_str());
+    }
+    if (failed) {
+        first_dirty_time_ = esp_timer_get_time();
+    }
+}
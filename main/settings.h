@@ -2,8 +2,14 @@
 #define SETTINGS_H
 
 #include <string>
+#include <map>
+#include <mutex>
 #include <nvs_flash.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
+// 读写都经过 SettingsStore 的内存缓存，写入先记在内存中，由定时器合并后在低优先级任务中写入 flash
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -16,11 +22,61 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // 立即把所有未写入的修改写入 flash，重启时会自动调用，深度睡眠和断电之前需要手动调用
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
+};
+
+// 每个命名空间的 NVS 句柄只打开一次，读过的值缓存在内存中
+class SettingsStore {
+public:
+    static SettingsStore& GetInstance() {
+        static SettingsStore instance;
+        return instance;
+    }
+    // 删除拷贝构造函数和赋值运算符
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    bool GetString(const std::string& ns, const std::string& key, std::string& value);
+    void SetString(const std::string& ns, const std::string& key, const std::string& value);
+    bool GetInt(const std::string& ns, const std::string& key, int32_t& value);
+    void SetInt(const std::string& ns, const std::string& key, int32_t value);
+    void EraseKey(const std::string& ns, const std::string& key);
+    void EraseAll(const std::string& ns);
+    void Flush();
+
+private:
+    SettingsStore();
+    ~SettingsStore();
+
+    struct Value {
+        bool is_string = false;
+        std::string string_value;
+        int32_t int_value = 0;
+        bool dirty = false;
+    };
+
+    struct Namespace {
+        nvs_handle_t handle = 0;
+        bool writable = false;
+        std::map<std::string, Value> values;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Namespace> namespaces_;
+    esp_timer_handle_t flush_timer_ = nullptr;
+    // 写 flash 可能要擦除扇区，不能在 esp_timer 任务中执行，定时器只通知这个任务
+    TaskHandle_t flush_task_ = nullptr;
+    // 第一个未写入的修改发生的时间，连续修改时最多推迟到这个时间之后 SETTINGS_MAX_FLUSH_DELAY_MS
+    int64_t first_dirty_time_ = 0;
+
+    Namespace* Open(const std::string& ns, bool writable);
+    void ScheduleFlush();
+    void FlushLocked();
 };
 
 #endif
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+# 把音效等资源打包为 assets 分区镜像
+#
+# 格式（小端）:
+#   header:  4s magic "XZAS", 4u version, 4u count, 4u total size
+#   entries: count x (32s name, 4u offset, 4u size)，offset 相对分区起点
+#   data:    每项资源按 4 字节对齐
+#
+# 资源名称为去掉扩展名的文件名，例如 success.p3 -> success
+import argparse
+import os
+import struct
+
+ASSETS_MAGIC = b'XZAS'
+ASSETS_VERSION = 1
+ASSETS_NAME_LENGTH = 32
+HEADER_FORMAT = '<4sIII'
+ENTRY_FORMAT = '<%dsII' % ASSETS_NAME_LENGTH
+
+def align(value, alignment=4):
+    return (value + alignment - 1) // alignment * alignment
+
+def build_assets(files, output_path, max_size=None):
+    assets = {}
+    for path in files:
+        name = os.path.splitext(os.path.basename(path))[0]
+        if len(name.encode('utf-8')) > ASSETS_NAME_LENGTH:
+            raise ValueError(f"Asset name too long: {name}")
+        if name in assets:
+            raise ValueError(f"Duplicate asset name: {name}")
+        with open(path, 'rb') as f:
+            assets[name] = f.read()
+
+    names = sorted(assets.keys())
+    offset = align(struct.calcsize(HEADER_FORMAT) + struct.calcsize(ENTRY_FORMAT) * len(names))
+    entries = []
+    data = bytearray()
+    for name in names:
+        entries.append(struct.pack(ENTRY_FORMAT, name.encode('utf-8'), offset + len(data), len(assets[name])))
+        data += assets[name]
+        data += b'\0' * (align(len(data)) - len(data))
+
+    total_size = offset + len(data)
+    if max_size is not None and total_size > max_size:
+        raise ValueError(f"Assets size {total_size} exceeds partition size {max_size}")
+
+    header = struct.pack(HEADER_FORMAT, ASSETS_MAGIC, ASSETS_VERSION, len(names), total_size)
+    table = header + b''.join(entries)
+    os.makedirs(os.path.dirname(os.path.abspath(output_path)), exist_ok=True)
+    with open(output_path, 'wb') as f:
+        f.write(table)
+        f.write(b'\0' * (offset - len(table)))
+        f.write(data)
+    print(f"Packed {len(names)} assets, {total_size} bytes -> {output_path}")
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--output", required=True, help="输出的分区镜像路径")
+    parser.add_argument("--max-size", type=lambda x: int(x, 0), help="分区大小，超出时报错")
+    parser.add_argument("files", nargs="+", help="资源文件")
+    args = parser.parse_args()
+
+    build_assets(args.files, args.output, args.max_size)
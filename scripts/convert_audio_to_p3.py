@@ -1,48 +1,81 @@
-# convert audio files to protocol v3 stream
+# convert audio files to P3 stream
+#
+# P3 v1: [1u type, 1u reserved, 2u len (big endian), data] for every packet, 16000Hz mono 60ms frames
+# P3 v2: header + packet offset table + packet data, all little endian
+#   header: 4s magic "P3V2", 1u version, 1u channels, 2u frame duration (ms),
+#           4u sample rate, 4u packet count, 4u data offset
+#   table:  4u offset of every packet relative to the data area, plus the data size
+import argparse
 import librosa
 import opuslib
 import struct
-import sys
 import tqdm
 import numpy as np
 
-def encode_audio_to_opus(input_file, output_file):
+P3_V2_MAGIC = b'P3V2'
+P3_V2_VERSION = 2
+P3_V2_HEADER_FORMAT = '<4sBBHIII'
+
+def encode_audio_to_opus(input_file, sample_rate, duration):
     # Load audio file using librosa
-    audio, sample_rate = librosa.load(input_file, sr=None, mono=False, dtype=np.float32)
-    
-    # Convert sample rate to 16000Hz if necessary
-    target_sample_rate = 16000
-    if sample_rate != target_sample_rate:
-        audio = librosa.resample(audio, orig_sr=sample_rate, target_sr=target_sample_rate)
-        sample_rate = target_sample_rate
-    
+    audio, original_sample_rate = librosa.load(input_file, sr=None, mono=False, dtype=np.float32)
+
+    # Convert sample rate if necessary
+    if original_sample_rate != sample_rate:
+        audio = librosa.resample(audio, orig_sr=original_sample_rate, target_sr=sample_rate)
+
     # Get left channel if stereo
     if audio.ndim == 2:
         audio = audio[0]
-    
+
     # Convert audio data back to int16 after resampling
     audio = (audio * 32767).astype(np.int16)
-    
+
     # Initialize Opus encoder
     encoder = opuslib.Encoder(sample_rate, 1, opuslib.APPLICATION_AUDIO)
 
     # Encode audio data to Opus packets
-    # Save encoded data to file
+    packets = []
+    frame_size = int(sample_rate * duration / 1000)
+    for i in tqdm.tqdm(range(0, len(audio) - frame_size, frame_size)):
+        frame = audio[i:i + frame_size]
+        packets.append(encoder.encode(frame.tobytes(), frame_size=frame_size))
+    return packets
+
+def write_p3_v1(output_file, packets):
     with open(output_file, 'wb') as f:
-        duration = 60 # 60ms every frame
-        frame_size = int(sample_rate * duration / 1000)
-        for i in tqdm.tqdm(range(0, len(audio) - frame_size, frame_size)):
-            frame = audio[i:i + frame_size]
-            opus_data = encoder.encode(frame.tobytes(), frame_size=frame_size)
+        for opus_data in packets:
             # protocol format, [1u type, 1u reserved, 2u len, data]
             packet = struct.pack('>BBH', 0, 0, len(opus_data)) + opus_data
             f.write(packet)
 
-# Example usage
-if len(sys.argv) != 3:
-    print('Usage: python convert.py <input_file> <output_file>')
-    sys.exit(1)
+def write_p3_v2(output_file, packets, sample_rate, duration):
+    offsets = [0]
+    for opus_data in packets:
+        offsets.append(offsets[-1] + len(opus_data))
+    data_offset = struct.calcsize(P3_V2_HEADER_FORMAT) + 4 * len(offsets)
+
+    with open(output_file, 'wb') as f:
+        f.write(struct.pack(P3_V2_HEADER_FORMAT, P3_V2_MAGIC, P3_V2_VERSION, 1, duration,
+                            sample_rate, len(packets), data_offset))
+        f.write(struct.pack('<%dI' % len(offsets), *offsets))
+        for opus_data in packets:
+            f.write(opus_data)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Convert audio files to P3 stream')
+    parser.add_argument('input_file', help='输入音频文件')
+    parser.add_argument('output_file', help='输出 P3 文件')
+    parser.add_argument('--format', choices=['v1', 'v2'], default='v2', help='P3 格式版本，旧固件只支持 v1')
+    parser.add_argument('--sample-rate', type=int, default=16000, choices=[8000, 12000, 16000, 24000, 48000])
+    parser.add_argument('--frame-duration', type=int, default=60, choices=[20, 40, 60])
+    args = parser.parse_args()
+
+    if args.format == 'v1' and (args.sample_rate != 16000 or args.frame_duration != 60):
+        parser.error('P3 v1 only supports 16000Hz and 60ms frames')
 
-input_file = sys.argv[1]
-output_file = sys.argv[2]
-encode_audio_to_opus(input_file, output_file)
+    packets = encode_audio_to_opus(args.input_file, args.sample_rate, args.frame_duration)
+    if args.format == 'v1':
+        write_p3_v1(args.output_file, packets)
+    else:
+        write_p3_v2(args.output_file, packets, args.sample_rate, args.frame_duration)
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# 生成差分升级补丁，设备从正在运行的固件复制未变化的部分，只下载新增的数据
+#
+# 格式（小端）:
+#   header: 4s magic "XZDP", 4u version, 4u source size, 4u target size,
+#           32s source sha256, 32s target sha256
+#   ops:    1u op=1 (copy),   4u source offset, 4u size
+#           1u op=2 (insert), 4u size, data
+#
+# 用法:
+#   gen_delta_ota.py old.bin new.bin output.patch
+#   gen_delta_ota.py --apply old.bin output.patch restored.bin
+import argparse
+import hashlib
+import struct
+
+PATCH_MAGIC = b'XZDP'
+PATCH_VERSION = 1
+HEADER_FORMAT = '<4sIII32s32s'
+OP_COPY = 1
+OP_INSERT = 2
+
+# 小于这个长度的相同片段不值得用 copy 表示
+MIN_MATCH = 32
+# 源固件每隔这么多字节建一次索引，越小匹配越充分，生成越慢
+INDEX_STEP = 4
+
+def build_index(source):
+    index = {}
+    for i in range(0, len(source) - MIN_MATCH + 1, INDEX_STEP):
+        index.setdefault(source[i:i + MIN_MATCH], i)
+    return index
+
+def match_length(source, source_pos, target, target_pos):
+    length = 0
+    chunk = 256
+    limit = min(len(source) - source_pos, len(target) - target_pos)
+    while length + chunk <= limit and source[source_pos + length:source_pos + length + chunk] == target[target_pos + length:target_pos + length + chunk]:
+        length += chunk
+    while length < limit and source[source_pos + length] == target[target_pos + length]:
+        length += 1
+    return length
+
+def generate_ops(source, target):
+    index = build_index(source)
+    ops = []
+    insert_start = 0
+    pos = 0
+    while pos + MIN_MATCH <= len(target):
+        source_pos = index.get(target[pos:pos + MIN_MATCH])
+        if source_pos is None:
+            pos += 1
+            continue
+        length = match_length(source, source_pos, target, pos)
+        # 向前扩展到待插入的数据中
+        while pos > insert_start and source_pos > 0 and source[source_pos - 1] == target[pos - 1]:
+            pos -= 1
+            source_pos -= 1
+            length += 1
+        if pos > insert_start:
+            ops.append((OP_INSERT, target[insert_start:pos]))
+        ops.append((OP_COPY, source_pos, length))
+        pos += length
+        insert_start = pos
+    if insert_start < len(target):
+        ops.append((OP_INSERT, target[insert_start:]))
+    return ops
+
+def generate_patch(source, target):
+    header = struct.pack(HEADER_FORMAT, PATCH_MAGIC, PATCH_VERSION, len(source), len(target),
+                         hashlib.sha256(source).digest(), hashlib.sha256(target).digest())
+    body = bytearray()
+    for op in generate_ops(source, target):
+        if op[0] == OP_COPY:
+            body += struct.pack('<BII', OP_COPY, op[1], op[2])
+        else:
+            body += struct.pack('<BI', OP_INSERT, len(op[1]))
+            body += op[1]
+    return header + bytes(body)
+
+def apply_patch(source, patch):
+    header_size = struct.calcsize(HEADER_FORMAT)
+    magic, version, source_size, target_size, source_sha256, target_sha256 = struct.unpack_from(HEADER_FORMAT, patch)
+    if magic != PATCH_MAGIC or version != PATCH_VERSION:
+        raise ValueError("Invalid patch header")
+    if len(source) != source_size or hashlib.sha256(source).digest() != source_sha256:
+        raise ValueError("Source firmware does not match the patch")
+
+    target = bytearray()
+    pos = header_size
+    while len(target) < target_size:
+        op = patch[pos]
+        if op == OP_COPY:
+            source_offset, size = struct.unpack_from('<II', patch, pos + 1)
+            if source_offset + size > source_size:
+                raise ValueError("Copy out of range")
+            target += source[source_offset:source_offset + size]
+            pos += 9
+        elif op == OP_INSERT:
+            size, = struct.unpack_from('<I', patch, pos + 1)
+            target += patch[pos + 5:pos + 5 + size]
+            pos += 5 + size
+        else:
+            raise ValueError(f"Unknown op {op} at {pos}")
+    if len(target) != target_size or hashlib.sha256(target).digest() != target_sha256:
+        raise ValueError("Target firmware hash mismatch")
+    return bytes(target)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Generate or apply a delta OTA patch')
+    parser.add_argument('--apply', action='store_true', help='把补丁应用到旧固件，用于检查补丁')
+    parser.add_argument('source', help='旧固件')
+    parser.add_argument('input', help='新固件，--apply 时为补丁')
+    parser.add_argument('output', help='输出的补丁，--apply 时为还原的新固件')
+    args = parser.parse_args()
+
+    with open(args.source, 'rb') as f:
+        source = f.read()
+    with open(args.input, 'rb') as f:
+        data = f.read()
+
+    if args.apply:
+        result = apply_patch(source, data)
+    else:
+        result = generate_patch(source, data)
+        # 生成后立即还原一次，确保补丁可用
+        if apply_patch(source, result) != data:
+            raise RuntimeError("Patch verification failed")
+        print(f"Patch size {len(result)} bytes, {len(result) * 100 // len(data)}% of the new firmware")
+
+    with open(args.output, 'wb') as f:
+        f.write(result)
@@ -21,7 +21,12 @@ namespace Lang {{
 {strings}
     }}
 
-    // 音效资源
+    // 音效资源存放在 assets 分区中，使用时按名称查找
+    struct Sound {{
+        const char* name;
+        operator std::string_view() const;
+    }};
+
     namespace Sounds {{
 {sounds}
     }}
@@ -45,29 +50,13 @@ def generate_header(input_path, output_path):
         value = value.replace('"', '\\"')
         strings.append(f'        constexpr const char* {key.upper()} = "{value}";')
 
-    # 生成音效常量
-    for file in os.listdir(os.path.dirname(input_path)):
-        if file.endswith('.p3'):
-            base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
-    
-    # 生成公共音效
-    for file in os.listdir(os.path.join(os.path.dirname(output_path), 'common')):
-        if file.endswith('.p3'):
-            base_name = os.path.splitext(file)[0]
-            sounds.append(f'''
-        extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
-        extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
-        static const std::string_view P3_{base_name.upper()} {{
-        static_cast<const char*>(p3_{base_name}_start),
-        static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
-        }};''')
+    # 生成音效常量，名称与 build_assets.py 打包到 assets 分区的名称一致
+    sound_dirs = [os.path.dirname(input_path), os.path.join(os.path.dirname(output_path), 'common')]
+    for sound_dir in sound_dirs:
+        for file in os.listdir(sound_dir):
+            if file.endswith('.p3'):
+                base_name = os.path.splitext(file)[0]
+                sounds.append(f'        constexpr Sound P3_{base_name.upper()} {{"{base_name}"}};')
 
     # 填充模板
     content = HEADER_TEMPLATE.format(
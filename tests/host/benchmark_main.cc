@@ -0,0 +1,17 @@
+#include "kernel_benchmark.h"
+#include "fake_esp.h"
+
+#include <cstdio>
+
+// 主机上只有标量实现，结果用于比较算法改动前后的耗时；输出不一致时返回失败
+int main() {
+    fake_time_use_real_clock(true);
+    auto results = RunKernelBenchmarks();
+    printf("%-20s %12s\n", "kernel", "scalar us");
+    int failures = 0;
+    for (auto& result : results) {
+        printf("%-20s %12.1f%s\n", result.name.c_str(), result.scalar_us, result.matches ? "" : "  MISMATCH");
+        failures += result.matches ? 0 : 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "cJSON.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static cJSON* NewItem(int type) {
+    auto item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    item->type = type;
+    return item;
+}
+
+cJSON* cJSON_CreateObject() {
+    return NewItem(cJSON_Object);
+}
+
+cJSON* cJSON_CreateArray() {
+    return NewItem(cJSON_Array);
+}
+
+cJSON* cJSON_CreateNumber(double number) {
+    auto item = NewItem(cJSON_Number);
+    item->valuedouble = number;
+    item->valueint = static_cast<int>(number);
+    return item;
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    auto item = NewItem(cJSON_String);
+    item->valuestring = strdup(string);
+    return item;
+}
+
+cJSON* cJSON_CreateBool(int boolean) {
+    return NewItem(boolean ? cJSON_True : cJSON_False);
+}
+
+void cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    if (array->child == nullptr) {
+        array->child = item;
+        return;
+    }
+    cJSON* last = array->child;
+    while (last->next != nullptr) {
+        last = last->next;
+    }
+    last->next = item;
+    item->prev = last;
+}
+
+void cJSON_AddItemToObject(cJSON* object, const char* name, cJSON* item) {
+    item->string = strdup(name);
+    cJSON_AddItemToArray(object, item);
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number) {
+    auto item = cJSON_CreateNumber(number);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string) {
+    auto item = cJSON_CreateString(string);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, int boolean) {
+    auto item = cJSON_CreateBool(boolean);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    for (auto item = array->child; item != nullptr; item = item->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* name) {
+    if (object == nullptr) {
+        return nullptr;
+    }
+    for (auto item = object->child; item != nullptr; item = item->next) {
+        if (item->string != nullptr && strcmp(item->string, name) == 0) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+static void Print(const cJSON* item, std::string& out) {
+    switch (item->type) {
+    case cJSON_False:
+        out += "false";
+        break;
+    case cJSON_True:
+        out += "true";
+        break;
+    case cJSON_NULL:
+        out += "null";
+        break;
+    case cJSON_Number: {
+        char buffer[32];
+        if (item->valuedouble == std::floor(item->valuedouble)) {
+            snprintf(buffer, sizeof(buffer), "%.0f", item->valuedouble);
+        } else {
+            snprintf(buffer, sizeof(buffer), "%g", item->valuedouble);
+        }
+        out += buffer;
+        break;
+    }
+    case cJSON_String:
+        out += "\"" + std::string(item->valuestring) + "\"";
+        break;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool object = item->type == cJSON_Object;
+        out += object ? "{" : "[";
+        for (auto child = item->child; child != nullptr; child = child->next) {
+            if (child != item->child) {
+                out += ",";
+            }
+            if (object) {
+                out += "\"" + std::string(child->string) + "\":";
+            }
+            Print(child, out);
+        }
+        out += object ? "}" : "]";
+        break;
+    }
+    }
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    std::string out;
+    Print(item, out);
+    return strdup(out.c_str());
+}
+
+void cJSON_free(void* object) {
+    free(object);
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef _HOST_CJSON_H_
+#define _HOST_CJSON_H_
+
+// 主机测试用的最小 cJSON 子集，只实现被测代码用到的函数
+
+#define cJSON_Invalid 0
+#define cJSON_False (1 << 0)
+#define cJSON_True (1 << 1)
+#define cJSON_NULL (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array (1 << 5)
+#define cJSON_Object (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* prev;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+cJSON* cJSON_CreateObject();
+cJSON* cJSON_CreateArray();
+cJSON* cJSON_CreateNumber(double number);
+cJSON* cJSON_CreateString(const char* string);
+cJSON* cJSON_CreateBool(int boolean);
+void cJSON_AddItemToArray(cJSON* array, cJSON* item);
+void cJSON_AddItemToObject(cJSON* object, const char* name, cJSON* item);
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number);
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string);
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, int boolean);
+int cJSON_GetArraySize(const cJSON* array);
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* name);
+char* cJSON_PrintUnformatted(const cJSON* item);
+void cJSON_free(void* object);
+void cJSON_Delete(cJSON* item);
+
+#define cJSON_IsNumber(item) ((item) != nullptr && (item)->type == cJSON_Number)
+#define cJSON_IsString(item) ((item) != nullptr && (item)->type == cJSON_String)
+
+#endif // _HOST_CJSON_H_
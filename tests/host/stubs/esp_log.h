@@ -0,0 +1,16 @@
+#ifndef _HOST_ESP_LOG_H_
+#define _HOST_ESP_LOG_H_
+
+#include "esp_err.h"
+
+// 主机测试不输出日志，参数仍然求值以免出现未使用变量的警告
+template <typename... Args>
+inline void host_log_discard(const char*, const char*, Args&&...) {}
+
+#define ESP_LOGE(tag, format, ...) host_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) host_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) host_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) host_log_discard(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) host_log_discard(tag, format, ##__VA_ARGS__)
+
+#endif // _HOST_ESP_LOG_H_
@@ -0,0 +1,484 @@
+#include "fake_esp.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/task.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <pthread.h>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    int64_t expire_us = 0;
+    int64_t period_us = 0;
+    bool active = false;
+};
+
+static std::recursive_mutex g_timer_mutex;
+static std::set<esp_timer*> g_timers;
+static int64_t g_now_us = 0;
+
+static std::atomic<bool> g_real_clock{false};
+
+void fake_time_use_real_clock(bool real) {
+    g_real_clock = real;
+}
+
+int64_t esp_timer_get_time() {
+    if (g_real_clock) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    }
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    return g_now_us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    auto timer = new esp_timer();
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    g_timers.insert(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expire_us = g_now_us + timeout_us;
+    timer->period_us = 0;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expire_us = g_now_us + period;
+    timer->period_us = period;
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    g_timers.erase(timer);
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    return timer->active;
+}
+
+void fake_time_advance(int64_t us) {
+    int64_t target;
+    {
+        std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+        target = g_now_us + us;
+    }
+    while (true) {
+        esp_timer* next = nullptr;
+        {
+            std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+            for (auto timer : g_timers) {
+                if (timer->active && timer->expire_us <= target &&
+                    (next == nullptr || timer->expire_us < next->expire_us)) {
+                    next = timer;
+                }
+            }
+            if (next == nullptr) {
+                g_now_us = target;
+                return;
+            }
+            g_now_us = std::max(g_now_us, next->expire_us);
+            if (next->period_us > 0) {
+                next->expire_us += next->period_us;
+            } else {
+                next->active = false;
+            }
+        }
+        // 回调中可能重新启动或停止定时器，不能持有锁
+        next->callback(next->arg);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    fake_time_advance((int64_t)ticks * 1000);
+}
+
+// 直接使用 pthread，测试链接的旧版 libstdc++ 中没有新的 std::condition_variable::wait
+struct tskTaskControlBlock {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    uint32_t notify_value = 0;
+    TaskFunction_t function;
+    void* arg;
+};
+
+static thread_local tskTaskControlBlock* g_current_task = nullptr;
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+    UBaseType_t priority, TaskHandle_t* created_task) {
+    // 任务不会被删除，控制块一直保留
+    auto task = new tskTaskControlBlock();
+    task->function = function;
+    task->arg = arg;
+    if (created_task != nullptr) {
+        *created_task = task;
+    }
+    pthread_t thread;
+    pthread_create(&thread, nullptr, [](void* arg) -> void* {
+        g_current_task = (tskTaskControlBlock*)arg;
+        g_current_task->function(g_current_task->arg);
+        return nullptr;
+    }, task);
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->mutex);
+    task->notify_value++;
+    pthread_cond_broadcast(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    auto task = g_current_task;
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    int64_t deadline_ns = (int64_t)deadline.tv_nsec + (int64_t)ticks_to_wait * 1000000;
+    deadline.tv_sec += deadline_ns / 1000000000;
+    deadline.tv_nsec = deadline_ns % 1000000000;
+
+    pthread_mutex_lock(&task->mutex);
+    while (task->notify_value == 0) {
+        if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&task->cond, &task->mutex);
+        } else if (pthread_cond_timedwait(&task->cond, &task->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value > 0) {
+        task->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->mutex);
+    return value;
+}
+
+void fake_time_reset() {
+    std::lock_guard<std::recursive_mutex> lock(g_timer_mutex);
+    for (auto timer : g_timers) {
+        timer->active = false;
+    }
+    g_now_us = 0;
+}
+
+static std::vector<shutdown_handler_t> g_shutdown_handlers;
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    g_shutdown_handlers.push_back(handler);
+    return ESP_OK;
+}
+
+void fake_run_shutdown_handlers() {
+    for (auto handler : g_shutdown_handlers) {
+        handler();
+    }
+}
+
+// NVS 中的值统一用字符串保存，整数和二进制数据按字节存入
+struct FakeNvsValue {
+    enum { kString, kInt, kBlob } type;
+    std::string data;
+    int32_t int_value = 0;
+};
+
+typedef std::map<std::string, FakeNvsValue> FakeNvsNamespace;
+
+static std::mutex g_nvs_mutex;
+// committed 是已经写入 flash 的内容，pending 是 set 之后尚未 commit 的内容
+static std::map<std::string, FakeNvsNamespace> g_nvs_committed;
+static std::map<nvs_handle_t, std::string> g_nvs_handles;
+static std::map<nvs_handle_t, FakeNvsNamespace> g_nvs_pending;
+static nvs_handle_t g_nvs_next_handle = 1;
+static FakeNvsStats g_nvs_stats;
+static bool g_nvs_fail_writes = false;
+
+void fake_nvs_reset() {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    g_nvs_committed.clear();
+    g_nvs_pending.clear();
+    g_nvs_stats = FakeNvsStats();
+    g_nvs_fail_writes = false;
+}
+
+const FakeNvsStats& fake_nvs_stats() {
+    return g_nvs_stats;
+}
+
+void fake_nvs_set_fail_writes(bool fail) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    g_nvs_fail_writes = fail;
+}
+
+static const FakeNvsValue* FindCommitted(const std::string& ns, const std::string& key) {
+    auto ns_it = g_nvs_committed.find(ns);
+    if (ns_it == g_nvs_committed.end()) {
+        return nullptr;
+    }
+    auto it = ns_it->second.find(key);
+    return it == ns_it->second.end() ? nullptr : &it->second;
+}
+
+bool fake_nvs_get_committed(const std::string& ns, const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto item = FindCommitted(ns, key);
+    if (item == nullptr || item->type != FakeNvsValue::kString) {
+        return false;
+    }
+    value = item->data;
+    return true;
+}
+
+bool fake_nvs_get_committed(const std::string& ns, const std::string& key, int32_t& value) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto item = FindCommitted(ns, key);
+    if (item == nullptr || item->type != FakeNvsValue::kInt) {
+        return false;
+    }
+    value = item->int_value;
+    return true;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    if (open_mode == NVS_READONLY && g_nvs_committed.find(name) == g_nvs_committed.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    g_nvs_committed[name];
+    *out_handle = g_nvs_next_handle++;
+    g_nvs_handles[*out_handle] = name;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    g_nvs_handles.erase(handle);
+    g_nvs_pending.erase(handle);
+}
+
+// 读取时先看尚未提交的修改，和真实 NVS 的行为一致
+static const FakeNvsValue* FindValue(nvs_handle_t handle, const char* key) {
+    auto pending = g_nvs_pending.find(handle);
+    if (pending != g_nvs_pending.end()) {
+        auto it = pending->second.find(key);
+        if (it != pending->second.end()) {
+            return &it->second;
+        }
+    }
+    auto name = g_nvs_handles.find(handle);
+    if (name == g_nvs_handles.end()) {
+        return nullptr;
+    }
+    return FindCommitted(name->second, key);
+}
+
+static esp_err_t SetValue(nvs_handle_t handle, const char* key, FakeNvsValue value) {
+    g_nvs_stats.set_count++;
+    if (g_nvs_fail_writes) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    if (g_nvs_handles.find(handle) == g_nvs_handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_nvs_pending[handle][key] = std::move(value);
+    return ESP_OK;
+}
+
+static esp_err_t GetBytes(nvs_handle_t handle, const char* key, int type, void* out_value, size_t* length) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto item = FindValue(handle, key);
+    if (item == nullptr || item->type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    size_t size = item->data.size() + (type == FakeNvsValue::kString ? 1 : 0);
+    if (out_value == nullptr) {
+        *length = size;
+        return ESP_OK;
+    }
+    if (*length < size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, item->data.c_str(), size);
+    *length = size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    return GetBytes(handle, key, FakeNvsValue::kString, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    return GetBytes(handle, key, FakeNvsValue::kBlob, out_value, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    return SetValue(handle, key, FakeNvsValue{FakeNvsValue::kString, value});
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    return SetValue(handle, key, FakeNvsValue{FakeNvsValue::kBlob, std::string(static_cast<const char*>(value), length)});
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto item = FindValue(handle, key);
+    if (item == nullptr || item->type != FakeNvsValue::kInt) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = item->int_value;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    FakeNvsValue item{FakeNvsValue::kInt, ""};
+    item.int_value = value;
+    return SetValue(handle, key, std::move(item));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto name = g_nvs_handles.find(handle);
+    if (name == g_nvs_handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_nvs_pending[handle].erase(key);
+    return g_nvs_committed[name->second].erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto name = g_nvs_handles.find(handle);
+    if (name == g_nvs_handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_nvs_pending.erase(handle);
+    g_nvs_committed[name->second].clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(g_nvs_mutex);
+    auto name = g_nvs_handles.find(handle);
+    if (name == g_nvs_handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_nvs_stats.commit_count++;
+    auto& committed = g_nvs_committed[name->second];
+    for (auto& [key, value] : g_nvs_pending[handle]) {
+        committed[key] = value;
+    }
+    g_nvs_pending.erase(handle);
+    return ESP_OK;
+}
+
+static std::atomic<bool> g_psram_present{true};
+static std::atomic<int> g_heap_live{0};
+
+void fake_heap_set_psram(bool present) {
+    g_psram_present = present;
+}
+
+int fake_heap_live_allocations() {
+    return g_heap_live;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !g_psram_present) {
+        return nullptr;
+    }
+    void* ptr = malloc(size);
+    if (ptr != nullptr) {
+        g_heap_live++;
+    }
+    return ptr;
+}
+
+void* heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !g_psram_present) {
+        return nullptr;
+    }
+    // aligned_alloc 要求大小是对齐的整数倍
+    void* ptr = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (ptr != nullptr) {
+        g_heap_live++;
+    }
+    return ptr;
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    void* ptr = heap_caps_malloc(n * size, caps);
+    if (ptr != nullptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+// 依次尝试每一组 caps
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...) {
+    va_list args;
+    va_start(args, num);
+    void* ptr = nullptr;
+    for (size_t i = 0; i < num && ptr == nullptr; i++) {
+        ptr = heap_caps_malloc(size, va_arg(args, uint32_t));
+    }
+    va_end(args);
+    return ptr;
+}
+
+void heap_caps_free(void* ptr) {
+    if (ptr != nullptr) {
+        g_heap_live--;
+        free(ptr);
+    }
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) && !g_psram_present ? 0 : 256 * 1024;
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) && !g_psram_present ? 0 : 512 * 1024;
+}
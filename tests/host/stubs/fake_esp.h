@@ -0,0 +1,37 @@
+#ifndef _HOST_FAKE_ESP_H_
+#define _HOST_FAKE_ESP_H_
+
+#include <cstdint>
+#include <string>
+
+// 主机测试用来控制模拟的 esp_timer 和 NVS
+
+// 时间只在调用 fake_time_advance 时前进，到期的定时器按时间顺序在调用线程中执行
+void fake_time_advance(int64_t us);
+void fake_time_reset();
+// vTaskDelay 不真正等待，只调用 fake_time_advance
+// 性能测试需要真实的时间，打开后 esp_timer_get_time 返回单调时钟，fake_time_advance 不再生效
+void fake_time_use_real_clock(bool real);
+
+struct FakeNvsStats {
+    int set_count = 0;      // nvs_set_* 调用次数
+    int commit_count = 0;   // nvs_commit 调用次数
+};
+
+void fake_nvs_reset();
+const FakeNvsStats& fake_nvs_stats();
+// 为 true 时所有 nvs_set_* 返回 ESP_ERR_NVS_NOT_ENOUGH_SPACE
+void fake_nvs_set_fail_writes(bool fail);
+// 读取已经提交到 "flash" 的值，不存在时返回 false
+bool fake_nvs_get_committed(const std::string& ns, const std::string& key, std::string& value);
+bool fake_nvs_get_committed(const std::string& ns, const std::string& key, int32_t& value);
+
+// 为 false 时模拟没有 PSRAM 的板子，要求 MALLOC_CAP_SPIRAM 的分配都会失败
+void fake_heap_set_psram(bool present);
+// heap_caps_malloc 成功分配、尚未释放的块数
+int fake_heap_live_allocations();
+
+// 依次调用注册的关机回调，模拟 esp_restart
+void fake_run_shutdown_handlers();
+
+#endif // _HOST_FAKE_ESP_H_
@@ -0,0 +1,18 @@
+#ifndef _HOST_FREERTOS_H_
+#define _HOST_FREERTOS_H_
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+// 主机上一个 tick 为 1ms
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif // _HOST_FREERTOS_H_
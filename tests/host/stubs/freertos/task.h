@@ -0,0 +1,19 @@
+#ifndef _HOST_FREERTOS_TASK_H_
+#define _HOST_FREERTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+typedef struct tskTaskControlBlock* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+// 不真正等待，只让模拟的时间前进，见 fake_esp.h
+void vTaskDelay(TickType_t ticks);
+
+// 每个任务是一个分离的线程，不支持删除；优先级和栈大小被忽略
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+    UBaseType_t priority, TaskHandle_t* created_task);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+// 等待时间按真实时间计算，和模拟的 esp_timer 时间无关
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#endif // _HOST_FREERTOS_TASK_H_
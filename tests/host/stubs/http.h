@@ -0,0 +1,22 @@
+#ifndef _HOST_HTTP_H_
+#define _HOST_HTTP_H_
+
+#include <cstddef>
+#include <string>
+
+// 与 esp-ml307 组件中的 Http 接口一致，测试中由模拟的服务器实现
+class Http {
+public:
+    virtual ~Http() = default;
+    virtual void SetHeader(const std::string& key, const std::string& value) = 0;
+    virtual void SetContent(std::string&& content) = 0;
+    virtual bool Open(const std::string& method, const std::string& url) = 0;
+    virtual void Close() = 0;
+    virtual int GetStatusCode() = 0;
+    virtual std::string GetResponseHeader(const std::string& key) const = 0;
+    virtual size_t GetBodyLength() = 0;
+    virtual std::string ReadAll() = 0;
+    virtual int Read(char* buffer, size_t buffer_size) = 0;
+};
+
+#endif // _HOST_HTTP_H_
@@ -0,0 +1,49 @@
+#ifndef _HOST_LVGL_H_
+#define _HOST_LVGL_H_
+
+#include <cstdint>
+
+// 只包含字形缓存用到的 LVGL 9 字体接口，字段名与 LVGL 一致
+
+struct lv_font_t;
+
+struct lv_draw_buf_header_t {
+    uint32_t stride;
+};
+
+struct lv_draw_buf_t {
+    lv_draw_buf_header_t header;
+    uint32_t data_size;
+    uint8_t* data;
+};
+
+struct lv_font_glyph_dsc_t {
+    const lv_font_t* resolved_font;
+    uint16_t box_w;
+    uint16_t box_h;
+    union {
+        uint32_t index;
+        const void* src;
+    } gid;
+};
+
+struct lv_font_t {
+    bool (*get_glyph_dsc)(const lv_font_t*, lv_font_glyph_dsc_t*, uint32_t, uint32_t);
+    const void* (*get_glyph_bitmap)(lv_font_glyph_dsc_t*, lv_draw_buf_t*);
+    int32_t line_height;
+    const void* dsc;
+};
+
+enum {
+    LV_FONT_FMT_TXT_PLAIN = 0,
+    LV_FONT_FMT_TXT_COMPRESSED = 1,
+};
+
+struct lv_font_fmt_txt_dsc_t {
+    uint16_t bitmap_format;
+};
+
+// 由测试实现，模拟解压
+const void* lv_font_get_bitmap_fmt_txt(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf);
+
+#endif // _HOST_LVGL_H_
@@ -0,0 +1,6 @@
+#ifndef _HOST_NVS_FLASH_H_
+#define _HOST_NVS_FLASH_H_
+
+#include "nvs.h"
+
+#endif // _HOST_NVS_FLASH_H_
@@ -0,0 +1,76 @@
+#include "audio_level.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+class AudioLevelTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        fake_time_reset();
+        // AudioLevelMeter 用 0 表示还没有数据
+        fake_time_advance(1000 * 1000);
+    }
+};
+
+TEST_F(AudioLevelTest, ZeroBeforeFirstUpdate) {
+    AudioLevelMeter meter;
+    auto level = meter.Get();
+    EXPECT_EQ(level.rms, 0);
+    EXPECT_EQ(level.peak, 0);
+}
+
+// 方波的 rms 等于幅度
+TEST_F(AudioLevelTest, MeasuresRmsAndPeak) {
+    AudioLevelMeter meter;
+    std::vector<int16_t> square(960);
+    for (size_t i = 0; i < square.size(); i++) {
+        square[i] = i % 2 == 0 ? 1000 : -1000;
+    }
+    meter.Update(square.data(), square.size(), 1);
+    auto level = meter.Get();
+    EXPECT_EQ(level.rms, 1000);
+    EXPECT_EQ(level.peak, 1000);
+
+    std::vector<int16_t> full(960, INT16_MIN);
+    meter.Update(full.data(), full.size(), 1);
+    level = meter.Get();
+    EXPECT_EQ(level.rms, 32767);
+    EXPECT_EQ(level.peak, 32768);
+}
+
+// 立体声只统计左声道
+TEST_F(AudioLevelTest, UsesFirstChannel) {
+    AudioLevelMeter meter;
+    std::vector<int16_t> stereo(960);
+    for (size_t i = 0; i < stereo.size(); i += 2) {
+        stereo[i] = 500;
+        stereo[i + 1] = 20000;
+    }
+    meter.Update(stereo.data(), stereo.size(), 2);
+    auto level = meter.Get();
+    EXPECT_EQ(level.rms, 500);
+    EXPECT_EQ(level.peak, 500);
+}
+
+// 空数据不覆盖上一帧的电平
+TEST_F(AudioLevelTest, IgnoresEmptyFrames) {
+    AudioLevelMeter meter;
+    std::vector<int16_t> frame(160, 3000);
+    meter.Update(frame.data(), frame.size(), 1);
+    meter.Update(frame.data(), 0, 1);
+    EXPECT_EQ(meter.Get().peak, 3000);
+}
+
+// 超过 max_age_ms 没有更新时认为已经静音
+TEST_F(AudioLevelTest, ExpiresStaleLevels) {
+    AudioLevelMeter meter;
+    std::vector<int16_t> frame(160, 3000);
+    meter.Update(frame.data(), frame.size(), 1);
+    fake_time_advance(AUDIO_LEVEL_MAX_AGE_MS * 1000);
+    EXPECT_EQ(meter.Get().rms, 3000);
+    fake_time_advance(1000);
+    EXPECT_EQ(meter.Get().rms, 0);
+    EXPECT_EQ(meter.Get(1000).rms, 3000);
+}
@@ -0,0 +1,184 @@
+#include "chat_history.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+// 界面通过 lv_label_set_text_static 直接引用缓冲区中的文本，淘汰之前文本不能被覆盖
+// 每次淘汰时检查被淘汰的消息仍然完整，之后检查剩下的消息都没有被改动
+class ChatHistoryTest : public ::testing::Test {
+protected:
+    struct Shadow {
+        const char* text;
+        std::string content;
+    };
+    std::deque<Shadow> shadows;
+    std::vector<std::string> evicted;
+
+    void SetUp() override {
+        fake_heap_set_psram(true);
+    }
+
+    void Watch(ChatHistory& history) {
+        history.OnEvict([this](ChatHistory::Message& message) {
+            ASSERT_FALSE(shadows.empty());
+            EXPECT_EQ(message.text, shadows.front().text);
+            EXPECT_EQ(std::string(message.text), shadows.front().content);
+            evicted.push_back(message.text);
+            shadows.pop_front();
+        });
+    }
+
+    ChatHistory::Message* Append(ChatHistory& history, const std::string& content) {
+        auto message = history.Append("assistant", content.c_str());
+        if (message != nullptr) {
+            shadows.push_back({message->text, message->text});
+        }
+        return message;
+    }
+
+    void ExpectIntact(ChatHistory& history) {
+        EXPECT_EQ(history.count(), shadows.size());
+        size_t used = 0;
+        for (auto& shadow : shadows) {
+            EXPECT_EQ(std::string(shadow.text), shadow.content);
+            used += shadow.content.size() + 1;
+        }
+        EXPECT_EQ(history.used_bytes(), used);
+        EXPECT_LE(history.used_bytes(), history.budget_bytes());
+    }
+};
+
+TEST_F(ChatHistoryTest, StoresMessages) {
+    ChatHistory history(64, 4);
+    Watch(history);
+    auto message = history.Append("user", "hello");
+    ASSERT_NE(message, nullptr);
+    EXPECT_STREQ(message->role, "user");
+    EXPECT_STREQ(message->text, "hello");
+    EXPECT_EQ(message->size, 6u);
+    EXPECT_EQ(history.count(), 1u);
+    EXPECT_EQ(history.used_bytes(), 6u);
+}
+
+// 尾部放不下时回到缓冲区开头，淘汰开头最旧的消息
+TEST_F(ChatHistoryTest, WrapsAtEndOfBuffer) {
+    ChatHistory history(32, 10);
+    Watch(history);
+    auto a = Append(history, "aaaaaaaaa");
+    Append(history, "bbbbbbbbb");
+    Append(history, "ccccccccc");
+    const char* base = a->text;
+
+    auto d = Append(history, "ddddddddd");
+    EXPECT_EQ(d->text, base);
+    EXPECT_EQ(evicted, std::vector<std::string>({"aaaaaaaaa"}));
+    ExpectIntact(history);
+}
+
+// 回绕之后新消息放在最新和最旧的消息之间，空隙不够时继续淘汰
+TEST_F(ChatHistoryTest, EvictsWhenGapIsTooSmall) {
+    ChatHistory history(32, 10);
+    Watch(history);
+    auto a = Append(history, "aaaaaaaaa");
+    Append(history, "bbbbbbbbb");
+    Append(history, "ccccccccc");
+    Append(history, "ddddddddd");
+    const char* base = a->text;
+
+    // d 之后到 b 之前没有空隙
+    auto e = Append(history, "eeee");
+    EXPECT_EQ(e->text, base + 10);
+    EXPECT_EQ(evicted, std::vector<std::string>({"aaaaaaaaa", "bbbbbbbbb"}));
+    ExpectIntact(history);
+
+    // e 之后到 c 之前只有 5 个字节
+    auto f = Append(history, "fffffff");
+    EXPECT_EQ(f->text, base + 15);
+    EXPECT_EQ(evicted.back(), "ccccccccc");
+    ExpectIntact(history);
+
+    // 恰好填满缓冲区末尾
+    auto g = Append(history, "gggggggg");
+    EXPECT_EQ(g->text, base + 23);
+    EXPECT_EQ(evicted.size(), 3u);
+    ExpectIntact(history);
+}
+
+TEST_F(ChatHistoryTest, LimitsMessageCount) {
+    ChatHistory history(1024, 3);
+    Watch(history);
+    for (int i = 0; i < 5; i++) {
+        Append(history, "message " + std::to_string(i));
+    }
+    EXPECT_EQ(history.count(), 3u);
+    EXPECT_EQ(evicted, std::vector<std::string>({"message 0", "message 1"}));
+    ExpectIntact(history);
+}
+
+// 超过整个预算的消息截断到预算以内，不会把多字节字符截成两半
+TEST_F(ChatHistoryTest, TruncatesAtUtf8Boundary) {
+    ChatHistory history(15, 4);
+    Watch(history);
+    Append(history, "hi");
+    // 每个汉字 3 个字节，预算 15 字节最多放 14 个字节，第 5 个字会被截成两半
+    auto message = Append(history, "中文字符测试");
+    ASSERT_NE(message, nullptr);
+    EXPECT_STREQ(message->text, "中文字符");
+    EXPECT_EQ(message->size, 13u);
+    EXPECT_EQ(evicted, std::vector<std::string>({"hi"}));
+
+    // 单字节字符可以用满预算
+    message = Append(history, "abcdefghijklmnopqrstuvwxyz");
+    ASSERT_NE(message, nullptr);
+    EXPECT_STREQ(message->text, "abcdefghijklmn");
+    EXPECT_EQ(history.used_bytes(), 15u);
+}
+
+TEST_F(ChatHistoryTest, ClearEvictsEverything) {
+    ChatHistory history(64, 4);
+    Watch(history);
+    Append(history, "one");
+    Append(history, "two");
+    history.Clear();
+    EXPECT_EQ(evicted, std::vector<std::string>({"one", "two"}));
+    EXPECT_EQ(history.count(), 0u);
+    EXPECT_EQ(history.used_bytes(), 0u);
+
+    auto message = Append(history, "three");
+    ASSERT_NE(message, nullptr);
+    ExpectIntact(history);
+}
+
+// 没有 PSRAM 时使用内部内存，预算限制在 1KB
+TEST_F(ChatHistoryTest, CapsInternalBudget) {
+    fake_heap_set_psram(false);
+    ChatHistory history(4096, 4);
+    ASSERT_NE(history.Append("user", "hello"), nullptr);
+    EXPECT_EQ(history.budget_bytes(), 1024u);
+    fake_heap_set_psram(true);
+}
+
+// 随机长度的消息，每一步都检查没有消息被覆盖
+TEST_F(ChatHistoryTest, RandomMessagesStayIntact) {
+    std::mt19937 random(7);
+    ChatHistory history(256, 12);
+    Watch(history);
+    for (int i = 0; i < 2000; i++) {
+        size_t length = random() % 100;
+        std::string content(length, '\0');
+        for (auto& c : content) {
+            c = 'a' + random() % 26;
+        }
+        ASSERT_NE(Append(history, content), nullptr);
+        ExpectIntact(history);
+        ASSERT_LE(history.count(), 12u);
+        if (HasFailure()) {
+            break;
+        }
+    }
+}
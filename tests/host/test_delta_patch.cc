@@ -0,0 +1,198 @@
+#include "delta_patch.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+// 用 scripts/gen_delta_ota.py 生成补丁，由 DeltaPatch 按随机长度分段解析并还原
+static std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::filesystem::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), data.size());
+}
+
+static std::string RandomBytes(std::mt19937& random, size_t size) {
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        c = (char)random();
+    }
+    return data;
+}
+
+// 模拟一次固件更新：修改、插入、删除和移动若干片段
+static std::string MakeTarget(std::mt19937& random, const std::string& source) {
+    std::string target = source;
+    for (int i = 0; i < 20; i++) {
+        size_t pos = random() % target.size();
+        switch (random() % 4) {
+        case 0:
+            target.replace(pos, std::min<size_t>(64, target.size() - pos), RandomBytes(random, 64));
+            break;
+        case 1:
+            target.insert(pos, RandomBytes(random, 1 + random() % 2000));
+            break;
+        case 2:
+            target.erase(pos, std::min<size_t>(1 + random() % 2000, target.size() - pos - 1));
+            break;
+        case 3: {
+            size_t from = random() % source.size();
+            target.insert(pos, source.substr(from, 1 + random() % 4000));
+            break;
+        }
+        }
+    }
+    return target;
+}
+
+static std::string GeneratePatch(const std::string& source, const std::string& target) {
+    auto dir = std::filesystem::temp_directory_path() / ("delta_patch_test_" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+    WriteFile(dir / "old.bin", source);
+    WriteFile(dir / "new.bin", target);
+    std::string command = std::string(PYTHON_EXECUTABLE) + " " + GEN_DELTA_OTA_SCRIPT + " " +
+        (dir / "old.bin").string() + " " + (dir / "new.bin").string() + " " + (dir / "out.patch").string() + " > /dev/null";
+    int ret = std::system(command.c_str());
+    std::string patch = ret == 0 ? ReadFile(dir / "out.patch") : std::string();
+    std::filesystem::remove_all(dir);
+    return patch;
+}
+
+// 按随机长度分段输入补丁，回调中还原目标固件
+static bool ApplyPatch(std::mt19937& random, const std::string& source, const std::string& patch, std::string& output,
+    size_t max_chunk) {
+    DeltaPatch applier;
+    applier.OnCopy([&](size_t source_offset, size_t size) {
+        output.append(source, source_offset, size);
+        return true;
+    });
+    applier.OnInsert([&](const char* data, size_t size) {
+        output.append(data, size);
+        return true;
+    });
+    size_t pos = 0;
+    while (pos < patch.size()) {
+        size_t count = std::min<size_t>(1 + random() % max_chunk, patch.size() - pos);
+        if (!applier.Feed(patch.data() + pos, count)) {
+            return false;
+        }
+        pos += count;
+    }
+    return applier.IsComplete() && applier.header().target_size == output.size();
+}
+
+TEST(DeltaPatch, RoundTripWithGenerator) {
+    std::mt19937 random(1);
+    auto source = RandomBytes(random, 200 * 1024);
+    auto target = MakeTarget(random, source);
+    auto patch = GeneratePatch(source, target);
+    ASSERT_FALSE(patch.empty()) << "gen_delta_ota.py failed";
+    // 补丁应当比完整固件小得多，否则说明没有复制到旧固件中的数据
+    EXPECT_LT(patch.size(), target.size() / 4);
+
+    // 分段长度从 1 字节（每个字段都被切开）到远大于单个操作
+    for (size_t max_chunk : {1, 7, 4096, 1 << 20}) {
+        std::string output;
+        ASSERT_TRUE(ApplyPatch(random, source, patch, output, max_chunk)) << max_chunk;
+        ASSERT_EQ(output, target) << max_chunk;
+    }
+}
+
+TEST(DeltaPatch, RoundTripUnrelatedFirmware) {
+    std::mt19937 random(2);
+    auto source = RandomBytes(random, 8 * 1024);
+    auto target = RandomBytes(random, 12 * 1024);
+    auto patch = GeneratePatch(source, target);
+    ASSERT_FALSE(patch.empty());
+    std::string output;
+    ASSERT_TRUE(ApplyPatch(random, source, patch, output, 333));
+    EXPECT_EQ(output, target);
+}
+
+static std::string MakeHeader(uint32_t source_size, uint32_t target_size) {
+    DeltaPatchHeader header = {};
+    memcpy(header.magic, DELTA_PATCH_MAGIC, 4);
+    header.version = DELTA_PATCH_VERSION;
+    header.source_size = source_size;
+    header.target_size = target_size;
+    return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+static std::string MakeCopy(uint32_t offset, uint32_t size) {
+    std::string op(1, (char)kDeltaPatchCopy);
+    op.append(reinterpret_cast<const char*>(&offset), 4);
+    op.append(reinterpret_cast<const char*>(&size), 4);
+    return op;
+}
+
+static std::string MakeInsert(const std::string& data) {
+    uint32_t size = data.size();
+    std::string op(1, (char)kDeltaPatchInsert);
+    op.append(reinterpret_cast<const char*>(&size), 4);
+    return op + data;
+}
+
+TEST(DeltaPatch, RejectsCopyOutOfSource) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 50) + MakeCopy(80, 30);
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+    // 出错之后不再接受输入
+    auto more = MakeInsert("x");
+    EXPECT_FALSE(patch.Feed(more.data(), more.size()));
+}
+
+TEST(DeltaPatch, RejectsOutputPastTarget) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 10) + MakeInsert("0123456789a");
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+}
+
+TEST(DeltaPatch, RejectsUnknownOp) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 10) + std::string(1, '\x07');
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+}
+
+TEST(DeltaPatch, RejectsTrailingData) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 4) + MakeInsert("abcd") + MakeInsert("e");
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+}
+
+TEST(DeltaPatch, IncompleteUntilTargetSize) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 8) + MakeCopy(0, 4);
+    ASSERT_TRUE(patch.Feed(data.data(), data.size()));
+    EXPECT_FALSE(patch.IsComplete());
+    auto rest = MakeInsert("abcd");
+    ASSERT_TRUE(patch.Feed(rest.data(), rest.size()));
+    EXPECT_TRUE(patch.IsComplete());
+}
+
+// 头部回调拒绝（例如源固件不匹配）时停止解析，不会调用其它回调
+TEST(DeltaPatch, HeaderCallbackCanReject) {
+    DeltaPatch patch;
+    bool copied = false;
+    patch.OnHeader([](const DeltaPatchHeader& header) { return false; });
+    patch.OnCopy([&](size_t, size_t) { copied = true; return true; });
+    auto data = MakeHeader(100, 4) + MakeCopy(0, 4);
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+    EXPECT_FALSE(copied);
+}
+
+TEST(DeltaPatch, RejectsBadMagic) {
+    DeltaPatch patch;
+    auto data = MakeHeader(100, 4);
+    data[0] = 'Y';
+    EXPECT_FALSE(patch.Feed(data.data(), data.size()));
+}
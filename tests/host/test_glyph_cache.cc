@@ -0,0 +1,144 @@
+#include "glyph_cache.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+// 模拟的解压函数，按字形编号和 stride 生成位图，记录被调用的次数
+static int g_decode_count = 0;
+
+static uint8_t Pattern(uint32_t gid, uint32_t stride, size_t i) {
+    return static_cast<uint8_t>(gid * 7 + stride + i);
+}
+
+const void* lv_font_get_bitmap_fmt_txt(lv_font_glyph_dsc_t* g_dsc, lv_draw_buf_t* draw_buf) {
+    g_decode_count++;
+    for (size_t i = 0; i < draw_buf->header.stride * g_dsc->box_h; i++) {
+        draw_buf->data[i] = Pattern(g_dsc->gid.index, draw_buf->header.stride, i);
+    }
+    return draw_buf;
+}
+
+// 预算由 CMakeLists.txt 中的 CONFIG_GLYPH_CACHE_SIZE_KB 决定，单个字形最多为预算的 1/16
+class GlyphCacheTest : public ::testing::Test {
+protected:
+    GlyphCache& cache = GlyphCache::GetInstance();
+    lv_font_fmt_txt_dsc_t dsc = {LV_FONT_FMT_TXT_COMPRESSED};
+    lv_font_t font = {nullptr, lv_font_get_bitmap_fmt_txt, 16, &dsc};
+    const lv_font_t* wrapped = nullptr;
+
+    void SetUp() override {
+        cache.Clear();
+        g_decode_count = 0;
+        wrapped = cache.Wrap(&font);
+    }
+
+    // 取一次位图，返回是否调用了解压，同时检查位图内容
+    bool Draw(uint32_t gid, uint32_t stride = 32, uint16_t rows = 16) {
+        std::vector<uint8_t> buffer(4096, 0);
+        lv_draw_buf_t draw_buf = {{stride}, static_cast<uint32_t>(buffer.size()), buffer.data()};
+        lv_font_glyph_dsc_t g_dsc = {};
+        g_dsc.resolved_font = wrapped;
+        g_dsc.box_h = rows;
+        g_dsc.gid.index = gid;
+        int decode_count = g_decode_count;
+        EXPECT_EQ(wrapped->get_glyph_bitmap(&g_dsc, &draw_buf), &draw_buf);
+        for (size_t i = 0; i < stride * rows; i++) {
+            if (buffer[i] != Pattern(gid, stride, i)) {
+                ADD_FAILURE() << "glyph " << gid << " differs at " << i;
+                break;
+            }
+        }
+        return g_decode_count != decode_count;
+    }
+};
+
+TEST_F(GlyphCacheTest, WrapsOnlyCompressedFonts) {
+    EXPECT_NE(wrapped, &font);
+    EXPECT_NE(wrapped->get_glyph_bitmap, lv_font_get_bitmap_fmt_txt);
+
+    lv_font_fmt_txt_dsc_t plain_dsc = {LV_FONT_FMT_TXT_PLAIN};
+    lv_font_t plain = {nullptr, lv_font_get_bitmap_fmt_txt, 16, &plain_dsc};
+    EXPECT_EQ(cache.Wrap(&plain), &plain);
+}
+
+TEST_F(GlyphCacheTest, HitsAfterFirstDecode) {
+    EXPECT_TRUE(Draw(1));
+    EXPECT_FALSE(Draw(1));
+    EXPECT_FALSE(Draw(1));
+    EXPECT_TRUE(Draw(2));
+
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 2u);
+}
+
+// 条目头部和哈希表计入预算，并在统计中单独列出
+TEST_F(GlyphCacheTest, CountsMetadataInBudget) {
+    // 哈希表在第一次插入时分配，之后一直保留
+    Draw(100);
+    cache.Clear();
+    int live = fake_heap_live_allocations();
+    for (uint32_t gid = 0; gid < 10; gid++) {
+        Draw(gid);
+    }
+    auto stats = cache.GetStats();
+    EXPECT_EQ(stats.entries, 10u);
+    EXPECT_GT(stats.metadata_bytes, 0u);
+    EXPECT_EQ(stats.used_bytes, 10u * 32 * 16 + stats.metadata_bytes);
+    // 每个条目只分配一次
+    EXPECT_EQ(fake_heap_live_allocations(), live + 10);
+
+    cache.Clear();
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+    EXPECT_EQ(fake_heap_live_allocations(), live);
+}
+
+// 放满之后先淘汰最久没有使用的字形，最近命中过的保留
+TEST_F(GlyphCacheTest, EvictsLeastRecentlyUsed) {
+    Draw(0);
+    Draw(1);
+    EXPECT_FALSE(Draw(0));
+    uint32_t gid = 2;
+    while (cache.GetStats().evictions == 0) {
+        ASSERT_TRUE(Draw(gid++));
+        ASSERT_LT(gid, 1000u);
+    }
+    auto stats = cache.GetStats();
+    EXPECT_LE(stats.used_bytes, stats.budget_bytes);
+    EXPECT_EQ(stats.evictions, 1u);
+
+    EXPECT_FALSE(Draw(0));
+    EXPECT_TRUE(Draw(1));
+    EXPECT_FALSE(Draw(gid - 1));
+}
+
+// 同一个字形的 stride 变化时旧的位图不能再用，替换为新的
+TEST_F(GlyphCacheTest, StrideChangeReplacesEntry) {
+    EXPECT_TRUE(Draw(5, 32));
+    EXPECT_TRUE(Draw(5, 48));
+    EXPECT_EQ(cache.GetStats().entries, 1u);
+    EXPECT_FALSE(Draw(5, 48));
+    EXPECT_TRUE(Draw(5, 32));
+}
+
+// 单个字形超过预算的 1/16 时不缓存
+TEST_F(GlyphCacheTest, SkipsOversizedGlyphs) {
+    uint16_t rows = cache.GetStats().budget_bytes / 16 / 32 + 1;
+    EXPECT_TRUE(Draw(9, 32, rows));
+    EXPECT_TRUE(Draw(9, 32, rows));
+    EXPECT_EQ(cache.GetStats().entries, 0u);
+}
+
+// 不同字体的同一个字形编号互不影响
+TEST_F(GlyphCacheTest, KeysIncludeFont) {
+    lv_font_t other_font = font;
+    auto other = cache.Wrap(&other_font);
+    EXPECT_TRUE(Draw(3));
+    std::swap(wrapped, other);
+    EXPECT_TRUE(Draw(3));
+    EXPECT_FALSE(Draw(3));
+    EXPECT_EQ(cache.GetStats().entries, 2u);
+}
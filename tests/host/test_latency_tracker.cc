@@ -0,0 +1,103 @@
+#include "latency_tracker.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+// 以微秒为单位构造一个回合的时间点，刻意让每个时间点都不是整毫秒
+static void MakeTurn(int64_t marks[kLatencyMarkerCount]) {
+    const int64_t times_us[kLatencyMarkerCount] = {
+        1000400,    // WakeWord
+        1020900,    // ChannelOpenStart
+        1180300,    // ChannelOpenEnd
+        1240700,    // FirstUplink
+        3000600,    // ListenStop
+        3410900,    // TtsStart
+        3522300,    // FirstDownlink
+        3570999,    // FirstPlayback
+        6000100,    // TtsStop
+    };
+    for (int i = 0; i < kLatencyMarkerCount; i++) {
+        marks[i] = times_us[i];
+    }
+}
+
+TEST(LatencyTracker, StageAccountingAddsUp) {
+    int64_t marks[kLatencyMarkerCount];
+    MakeTurn(marks);
+    auto turn = LatencyTracker::ComputeTurn(marks);
+
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        EXPECT_GE(turn.stage_ms[i], 0) << "stage " << i;
+    }
+    // 分别截断到毫秒会得到 410 + 111 + 48 = 569，而总耗时是 570
+    EXPECT_EQ(turn.response_ms, 570);
+    EXPECT_EQ(turn.stage_ms[kLatencyStageServerResponse] + turn.stage_ms[kLatencyStageFirstDownlink] +
+        turn.stage_ms[kLatencyStagePlaybackStart], turn.response_ms);
+    EXPECT_EQ(turn.unaccounted_ms, 0);
+
+    int total = 0;
+    for (int i = 0; i < kLatencyStageCount; i++) {
+        total += turn.stage_ms[i];
+    }
+    // 唤醒到打开通道之后上行，以及停止说话之后的所有阶段都是首尾相接的
+    EXPECT_EQ(turn.stage_ms[kLatencyStageWakeToOpen] + turn.stage_ms[kLatencyStageChannelOpen] +
+        turn.stage_ms[kLatencyStageOpenToUplink], 1240 - 1000);
+    EXPECT_EQ(total, (1240 - 1000) + (6000 - 3000));
+}
+
+TEST(LatencyTracker, MissingMarkerIsReportedAsUnaccounted) {
+    int64_t marks[kLatencyMarkerCount];
+    MakeTurn(marks);
+    marks[kLatencyMarkerTtsStart] = 0;
+    auto turn = LatencyTracker::ComputeTurn(marks);
+
+    EXPECT_EQ(turn.stage_ms[kLatencyStageServerResponse], -1);
+    EXPECT_EQ(turn.stage_ms[kLatencyStageFirstDownlink], -1);
+    EXPECT_EQ(turn.response_ms, 570);
+    EXPECT_EQ(turn.unaccounted_ms, 570 - turn.stage_ms[kLatencyStagePlaybackStart]);
+}
+
+TEST(LatencyTracker, OutOfOrderMarkerIsReportedAsUnaccounted) {
+    int64_t marks[kLatencyMarkerCount];
+    MakeTurn(marks);
+    // 音频比 tts start 消息先到
+    marks[kLatencyMarkerFirstDownlink] = marks[kLatencyMarkerTtsStart] - 5000;
+    auto turn = LatencyTracker::ComputeTurn(marks);
+
+    EXPECT_EQ(turn.stage_ms[kLatencyStageFirstDownlink], -1);
+    EXPECT_EQ(turn.unaccounted_ms, turn.response_ms - turn.stage_ms[kLatencyStageServerResponse] -
+        turn.stage_ms[kLatencyStagePlaybackStart]);
+    EXPECT_NE(turn.unaccounted_ms, 0);
+}
+
+TEST(LatencyTracker, NoResponseWithoutPlayback) {
+    int64_t marks[kLatencyMarkerCount];
+    MakeTurn(marks);
+    marks[kLatencyMarkerFirstPlayback] = 0;
+    auto turn = LatencyTracker::ComputeTurn(marks);
+    EXPECT_EQ(turn.response_ms, -1);
+    EXPECT_EQ(turn.unaccounted_ms, 0);
+}
+
+TEST(LatencyTracker, FinishTurnReportsStagesAndResponse) {
+    fake_time_reset();
+    auto& tracker = LatencyTracker::GetInstance();
+    const LatencyMarker order[] = {
+        kLatencyMarkerWakeWord, kLatencyMarkerChannelOpenStart, kLatencyMarkerChannelOpenEnd,
+        kLatencyMarkerFirstUplink, kLatencyMarkerListenStop, kLatencyMarkerTtsStart,
+        kLatencyMarkerFirstDownlink, kLatencyMarkerFirstPlayback, kLatencyMarkerTtsStop,
+    };
+    fake_time_advance(1000000);
+    for (auto marker : order) {
+        fake_time_advance(100500);
+        tracker.MarkOnce(marker);
+    }
+
+    auto json = tracker.FinishTurn();
+    EXPECT_NE(json.find("\"server_response\":101"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"response\":302"), std::string::npos) << json;
+    EXPECT_EQ(json.find("unaccounted"), std::string::npos) << json;
+    // 回合结束后时间点被清空
+    EXPECT_FALSE(tracker.IsMarked(kLatencyMarkerWakeWord));
+    EXPECT_TRUE(tracker.FinishTurn().empty());
+}
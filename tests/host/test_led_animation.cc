@@ -0,0 +1,159 @@
+#include "led_animation.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const StripColor kBlack = {0, 0, 0};
+static const StripColor kRed = {255, 0, 0};
+static const StripColor kBlue = {0, 0, 200};
+
+static uint8_t Gamma(int value) {
+    return static_cast<uint8_t>(std::lround(255.0f * std::pow(value / 255.0f, 2.2f)));
+}
+
+// 逐帧读取红色通道
+static std::vector<int> RedFrames(LedFrameGenerator& generator, int count) {
+    std::vector<int> frames;
+    for (int i = 0; i < count; i++) {
+        generator.Advance();
+        frames.push_back(generator.frame()[0].red);
+    }
+    return frames;
+}
+
+TEST(LedFrameGenerator, SolidOutputsOnceAndFinishes) {
+    LedFrameGenerator generator(3);
+    generator.Solid(kBlue);
+    EXPECT_FALSE(generator.finished());
+    ASSERT_TRUE(generator.Advance());
+    EXPECT_TRUE(generator.finished());
+    EXPECT_EQ(generator.frame(), std::vector<StripColor>(3, kBlue));
+    EXPECT_FALSE(generator.Advance());
+}
+
+// 内容没有变化时 Advance 返回 false，调用者不需要刷新硬件
+TEST(LedFrameGenerator, ReportsUnchangedFrames) {
+    LedFrameGenerator generator(2);
+    generator.Solid(kRed);
+    ASSERT_TRUE(generator.Advance());
+    generator.Solid(kRed);
+    EXPECT_FALSE(generator.Advance());
+    generator.Solid(std::vector<StripColor>{kRed, kBlue});
+    EXPECT_TRUE(generator.Advance());
+    EXPECT_EQ(generator.frame()[1], kBlue);
+}
+
+TEST(LedFrameGenerator, BlinkAlternatesForever) {
+    LedFrameGenerator generator(1);
+    generator.Blink(kRed);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(generator.Advance());
+        EXPECT_EQ(generator.frame()[0], i % 2 == 0 ? kRed : kBlack) << i;
+        EXPECT_FALSE(generator.finished());
+    }
+}
+
+// 一个周期：从 low 经过 gamma 校正的上升沿到 high，再回到 low，每一段都按整数均分
+TEST(LedFrameGenerator, BreatheFollowsGammaCurve) {
+    LedFrameGenerator generator(1);
+    generator.Breathe(kBlack, kRed, 4);
+    auto frames = RedFrames(generator, 16);
+    std::vector<int> period = {0, Gamma(63), Gamma(127), Gamma(191), 255, Gamma(192), Gamma(128), Gamma(64)};
+    EXPECT_EQ(std::vector<int>(frames.begin(), frames.begin() + 8), period);
+    EXPECT_EQ(std::vector<int>(frames.begin() + 8, frames.end()), period);
+    // 暗部变化更慢
+    EXPECT_LT(Gamma(127), 127);
+    EXPECT_FALSE(generator.finished());
+}
+
+// steps 为 0 时每步亮度变化 1，和原来的呼吸速度一致：差值为 10 时一个周期 20 步
+TEST(LedFrameGenerator, BreatheDefaultStepsFollowColorDistance) {
+    LedFrameGenerator generator(1);
+    generator.Breathe(StripColor{0, 0, 0}, StripColor{0, 10, 0});
+    std::vector<int> frames;
+    for (int i = 0; i < 40; i++) {
+        generator.Advance();
+        frames.push_back(generator.frame()[0].green);
+    }
+    EXPECT_EQ(std::vector<int>(frames.begin(), frames.begin() + 20), std::vector<int>(frames.begin() + 20, frames.end()));
+    EXPECT_EQ(std::count(frames.begin(), frames.begin() + 20, 10), 1);
+    EXPECT_EQ(frames[10], 10);
+}
+
+TEST(LedFrameGenerator, FadeOutStartsFromCurrentFrame) {
+    LedFrameGenerator generator(2);
+    generator.Solid(StripColor{100, 50, 0});
+    generator.Advance();
+    generator.FadeOut(3);
+
+    int last_red = 100;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_FALSE(generator.finished());
+        generator.Advance();
+        EXPECT_LT(generator.frame()[0].red, last_red);
+        last_red = generator.frame()[0].red;
+    }
+    EXPECT_TRUE(generator.finished());
+    EXPECT_EQ(generator.frame(), std::vector<StripColor>(2, kBlack));
+}
+
+TEST(LedFrameGenerator, ScrollMovesOnePositionPerStep) {
+    LedFrameGenerator generator(5);
+    generator.Scroll(kBlack, kRed, 2);
+    for (int step = 0; step < 10; step++) {
+        generator.Advance();
+        for (int i = 0; i < 5; i++) {
+            bool lit = (i - step % 5 + 5) % 5 < 2;
+            EXPECT_EQ(generator.frame()[i], lit ? kRed : kBlack) << "step " << step << " led " << i;
+        }
+    }
+}
+
+// 音量条每一步都可以重新设置点亮的数量
+TEST(LedFrameGenerator, MeterFollowsLevel) {
+    LedFrameGenerator generator(5);
+    generator.Meter(kBlack, kBlue, 3);
+    ASSERT_TRUE(generator.Advance());
+    EXPECT_EQ(generator.frame()[2], kBlue);
+    EXPECT_EQ(generator.frame()[3], kBlack);
+
+    generator.Meter(kBlack, kBlue, 3);
+    EXPECT_FALSE(generator.Advance());
+
+    generator.Meter(kBlack, kBlue, 1);
+    ASSERT_TRUE(generator.Advance());
+    EXPECT_EQ(generator.frame()[0], kBlue);
+    EXPECT_EQ(generator.frame()[1], kBlack);
+    EXPECT_FALSE(generator.finished());
+}
+
+TEST(LedFrameGenerator, BrightnessScalesOutputOnly) {
+    LedFrameGenerator generator(1);
+    generator.SetBrightness(128);
+    generator.Solid(StripColor{255, 100, 1});
+    generator.Advance();
+    EXPECT_EQ(generator.frame()[0].red, 128);
+    EXPECT_EQ(generator.frame()[0].green, (100 * 128 + 127) / 255);
+    EXPECT_EQ(generator.frame()[0].blue, 1);
+
+    // FadeOut 从缩放前的颜色开始，亮度恢复之后第一步接近原色
+    generator.SetBrightness(255);
+    generator.FadeOut(100);
+    generator.Advance();
+    EXPECT_GT(generator.frame()[0].red, 240);
+
+    generator.SetBrightness(0);
+    generator.Solid(kRed);
+    generator.Advance();
+    EXPECT_EQ(generator.frame()[0], kBlack);
+}
+
+TEST(LedFrameGenerator, EmptyStripNeverOutputs) {
+    LedFrameGenerator generator(0);
+    generator.Blink(kRed);
+    EXPECT_FALSE(generator.Advance());
+    EXPECT_EQ(generator.size(), 0u);
+}
@@ -0,0 +1,100 @@
+#include "led_animator.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+// 用模拟的 esp_timer 检查各路动画按各自的间隔前进，播放完后不再输出
+class LedAnimatorTest : public ::testing::Test {
+protected:
+    LedAnimator& animator = LedAnimator::GetInstance();
+    std::vector<LedAnimator::Channel*> channels;
+
+    void SetUp() override {
+        fake_time_reset();
+    }
+
+    void TearDown() override {
+        for (auto channel : channels) {
+            animator.RemoveChannel(channel);
+        }
+    }
+
+    LedAnimator::Channel* AddChannel(int& frames) {
+        auto channel = animator.AddChannel(1, [&frames](const std::vector<StripColor>& frame) { frames++; });
+        channels.push_back(channel);
+        return channel;
+    }
+};
+
+TEST_F(LedAnimatorTest, ChannelsKeepTheirOwnIntervals) {
+    int fast_frames = 0;
+    int slow_frames = 0;
+    auto fast = AddChannel(fast_frames);
+    auto slow = AddChannel(slow_frames);
+    animator.Play(fast, 100, [](LedFrameGenerator& generator) { generator.Blink(StripColor{255, 0, 0}); });
+    fake_time_advance(30 * 1000);
+    animator.Play(slow, 250, [](LedFrameGenerator& generator) { generator.Blink(StripColor{0, 255, 0}); });
+    // 第一帧在 Play 中立即输出
+    EXPECT_EQ(fast_frames, 1);
+    EXPECT_EQ(slow_frames, 1);
+
+    fake_time_advance(1000 * 1000);
+    EXPECT_EQ(fast_frames, 1 + 10);
+    EXPECT_EQ(slow_frames, 1 + 4);
+}
+
+TEST_F(LedAnimatorTest, FinishedAnimationsStop) {
+    int frames = 0;
+    auto channel = AddChannel(frames);
+    animator.Play(channel, 0, [](LedFrameGenerator& generator) { generator.Solid(StripColor{0, 0, 255}); });
+    EXPECT_EQ(frames, 1);
+    fake_time_advance(1000 * 1000);
+    EXPECT_EQ(frames, 1);
+
+    animator.Play(channel, 50, [](LedFrameGenerator& generator) { generator.FadeOut(4); });
+    fake_time_advance(1000 * 1000);
+    EXPECT_EQ(frames, 1 + 4);
+}
+
+// 新的动画替换正在播放的动画，从新的间隔重新计时
+TEST_F(LedAnimatorTest, PlayRestartsTheChannel) {
+    int frames = 0;
+    auto channel = AddChannel(frames);
+    animator.Play(channel, 1000, [](LedFrameGenerator& generator) { generator.Blink(StripColor{255, 0, 0}); });
+    fake_time_advance(500 * 1000);
+    animator.Play(channel, 100, [](LedFrameGenerator& generator) { generator.Blink(StripColor{0, 0, 255}); });
+    fake_time_advance(550 * 1000);
+    EXPECT_EQ(frames, 2 + 5);
+}
+
+TEST_F(LedAnimatorTest, UpdateRunsBeforeEachStep) {
+    int frames = 0;
+    int level = 0;
+    auto channel = AddChannel(frames);
+    animator.Play(channel, 100, [](LedFrameGenerator& generator) {
+        generator.Meter(StripColor{}, StripColor{255, 255, 255}, 0);
+    }, [&level](LedFrameGenerator& generator) {
+        generator.Meter(StripColor{}, StripColor{255, 255, 255}, level);
+    });
+    EXPECT_EQ(frames, 1);
+    // 音量没有变化时画面不变，不调用 sink
+    fake_time_advance(100 * 1000);
+    EXPECT_EQ(frames, 1);
+    level = 1;
+    fake_time_advance(100 * 1000);
+    EXPECT_EQ(frames, 2);
+}
+
+// 颜色按满亮度设置，输出经过通道的亮度查找表缩放
+TEST_F(LedAnimatorTest, BrightnessScalesOutput) {
+    StripColor output;
+    auto channel = animator.AddChannel(1, [&output](const std::vector<StripColor>& frame) { output = frame[0]; });
+    channels.push_back(channel);
+    animator.SetBrightness(channel, 32);
+    animator.Play(channel, 0, [](LedFrameGenerator& generator) { generator.Solid(StripColor{255, 31, 0}); });
+    EXPECT_EQ(output, (StripColor{32, 4, 0}));
+
+    animator.SetBrightness(channel, 255);
+    animator.Play(channel, 0, [](LedFrameGenerator& generator) { generator.Solid(StripColor{255, 31, 0}); });
+    EXPECT_EQ(output, (StripColor{255, 31, 0}));
+}
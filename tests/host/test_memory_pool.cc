@@ -0,0 +1,115 @@
+#include "memory_pool.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#define SOAK_THREADS 4
+#define SOAK_ITERATIONS 20000
+
+// 多个任务同时分配、填充、校验、释放，块不能被重复分配，结束后全部归还
+TEST(MemoryPool, ConcurrentSoak) {
+    MemoryPool pool("soak", 256, 16, kMemoryPlacementInternal);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < SOAK_THREADS; t++) {
+        threads.emplace_back([&pool, t]() {
+            std::mt19937 random(t);
+            std::vector<std::pair<uint8_t*, size_t>> held;
+            for (int i = 0; i < SOAK_ITERATIONS; i++) {
+                if (held.size() < 8 && (held.empty() || random() % 2 == 0)) {
+                    // 偶尔申请超过块大小的内存，走系统堆
+                    size_t size = random() % 16 == 0 ? 300 + random() % 200 : 1 + random() % 256;
+                    auto ptr = static_cast<uint8_t*>(pool.Allocate(size));
+                    ASSERT_NE(ptr, nullptr);
+                    memset(ptr, (uint8_t)(t * 31 + i), size);
+                    held.emplace_back(ptr, size);
+                } else {
+                    size_t index = random() % held.size();
+                    auto [ptr, size] = held[index];
+                    uint8_t expected = ptr[0];
+                    for (size_t j = 1; j < size; j++) {
+                        ASSERT_EQ(ptr[j], expected) << "block shared between tasks";
+                    }
+                    pool.Deallocate(ptr);
+                    held.erase(held.begin() + index);
+                }
+            }
+            for (auto& [ptr, size] : held) {
+                pool.Deallocate(ptr);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.blocks_in_use, 0u);
+    EXPECT_EQ(stats.block_count, 16u);
+    EXPECT_LE(stats.peak_blocks_in_use, 16u);
+    EXPECT_GT(stats.fallback_allocations, 0u);
+}
+
+TEST(MemoryPool, FallsBackWhenExhausted) {
+    MemoryPool pool("small", 64, 2, kMemoryPlacementInternal);
+    void* a = pool.Allocate(64);
+    void* b = pool.Allocate(64);
+    void* c = pool.Allocate(64);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(pool.GetStats().blocks_in_use, 2u);
+    EXPECT_EQ(pool.GetStats().fallback_allocations, 1u);
+
+    // 释放回池中的块会被再次使用
+    pool.Deallocate(a);
+    EXPECT_EQ(pool.Allocate(16), a);
+    pool.Deallocate(a);
+    pool.Deallocate(b);
+    pool.Deallocate(c);
+    EXPECT_EQ(pool.GetStats().blocks_in_use, 0u);
+}
+
+TEST(MemoryPool, PsramPoolIsDisabledWithoutPsram) {
+    fake_heap_set_psram(false);
+    int live = fake_heap_live_allocations();
+    {
+        MemoryPool pool("psram", 512, 32, kMemoryPlacementPsram);
+        void* ptr = pool.Allocate(100);
+        ASSERT_NE(ptr, nullptr);
+        // 只有这一次分配占用内存，没有常驻的内部 SRAM 池
+        EXPECT_EQ(fake_heap_live_allocations(), live + 1);
+        auto stats = pool.GetStats();
+        EXPECT_EQ(stats.block_count, 0u);
+        EXPECT_FALSE(stats.in_psram);
+        pool.Deallocate(ptr);
+        EXPECT_EQ(fake_heap_live_allocations(), live);
+    }
+    fake_heap_set_psram(true);
+}
+
+TEST(MemoryPool, PsramPoolWithPsram) {
+    MemoryPool pool("psram", 512, 4, kMemoryPlacementPsram);
+    void* ptr = pool.Allocate(512);
+    auto stats = pool.GetStats();
+    EXPECT_EQ(stats.block_count, 4u);
+    EXPECT_TRUE(stats.in_psram);
+    EXPECT_EQ(stats.blocks_in_use, 1u);
+    pool.Deallocate(ptr);
+}
+
+TEST(MemoryPool, PcmFrameUsesPool) {
+    auto& pool = PcmFramePool::Get();
+    auto before = pool.GetStats();
+    {
+        PcmFrame frame(960 * 2);
+        EXPECT_EQ(pool.GetStats().blocks_in_use, before.blocks_in_use + 1);
+        PcmFrame moved = std::move(frame);
+        EXPECT_EQ(pool.GetStats().blocks_in_use, before.blocks_in_use + 1);
+    }
+    auto after = pool.GetStats();
+    EXPECT_EQ(after.blocks_in_use, before.blocks_in_use);
+    EXPECT_EQ(after.fallback_allocations, before.fallback_allocations);
+}
@@ -0,0 +1,215 @@
+#include "ota_downloader.h"
+#include "fake_esp.h"
+
+#include <esp_timer.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+// 模拟的 HTTP 服务器，按脚本在指定位置断开连接
+struct FakeServer {
+    std::string body;
+    bool supports_range = true;
+    // 每次连接在发送这么多字节后断开，用完之后不再断开
+    std::deque<size_t> disconnect_after;
+    // 接下来这么多次连接直接失败
+    int open_failures = 0;
+    // 每次连接收到的 Range 起点，没有 Range 时为 0
+    std::vector<size_t> range_starts;
+    int open_count = 0;
+};
+
+class FakeHttp : public Http {
+public:
+    explicit FakeHttp(FakeServer& server) : server_(server) {}
+
+    void SetHeader(const std::string& key, const std::string& value) override {
+        if (key == "Range") {
+            // bytes=N-
+            range_start_ = std::stoul(value.substr(6));
+        }
+    }
+    void SetContent(std::string&& content) override {}
+    bool Open(const std::string& method, const std::string& url) override {
+        server_.open_count++;
+        if (server_.open_failures > 0) {
+            server_.open_failures--;
+            return false;
+        }
+        server_.range_starts.push_back(range_start_);
+        if (!server_.supports_range || range_start_ == 0) {
+            status_code_ = 200;
+            position_ = 0;
+        } else {
+            status_code_ = 206;
+            position_ = range_start_;
+        }
+        if (!server_.disconnect_after.empty()) {
+            remaining_ = server_.disconnect_after.front();
+            server_.disconnect_after.pop_front();
+        }
+        return true;
+    }
+    void Close() override {}
+    int GetStatusCode() override { return status_code_; }
+    std::string GetResponseHeader(const std::string& key) const override { return ""; }
+    size_t GetBodyLength() override { return server_.body.size() - position_; }
+    std::string ReadAll() override { return ""; }
+    int Read(char* buffer, size_t buffer_size) override {
+        size_t count = std::min({buffer_size, server_.body.size() - position_, remaining_});
+        if (count == 0) {
+            return -1;
+        }
+        std::copy_n(server_.body.data() + position_, count, buffer);
+        position_ += count;
+        remaining_ -= count;
+        return count;
+    }
+
+private:
+    FakeServer& server_;
+    size_t range_start_ = 0;
+    int status_code_ = 0;
+    size_t position_ = 0;
+    size_t remaining_ = SIZE_MAX;
+};
+
+static std::string MakeBody(size_t size) {
+    std::string body(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        body[i] = (char)(i * 131 + (i >> 8));
+    }
+    return body;
+}
+
+class OtaDownloaderTest : public ::testing::Test {
+protected:
+    FakeServer server;
+    OtaDownloader downloader{[this]() { return new FakeHttp(server); }};
+    std::string received;
+    size_t offset = 0;
+    size_t total_size = 0;
+
+    void SetUp() override {
+        fake_time_reset();
+        server.body = MakeBody(100000);
+    }
+
+    bool Download() {
+        return downloader.Download("http://ota/firmware.bin", offset, total_size, [this](const char* data, size_t size) {
+            received.append(data, size);
+            return true;
+        });
+    }
+};
+
+TEST_F(OtaDownloaderTest, DownloadsInOneConnection) {
+    size_t reported_size = 0;
+    downloader.OnTotalSize([&](size_t size) { reported_size = size; });
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    EXPECT_EQ(offset, server.body.size());
+    EXPECT_EQ(total_size, server.body.size());
+    EXPECT_EQ(reported_size, server.body.size());
+    EXPECT_EQ(server.open_count, 1);
+}
+
+// 每次断开后用 Range 请求从收到的位置继续，数据不重复也不遗漏
+TEST_F(OtaDownloaderTest, ResumesWithRangeAfterDisconnects) {
+    server.disconnect_after = {30000, 5000, 1, 40000};
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    EXPECT_EQ(server.range_starts, (std::vector<size_t>{0, 30000, 35000, 35001, 75001}));
+}
+
+// 服务器不支持 Range 时从头读取，跳过已经收到的部分
+TEST_F(OtaDownloaderTest, SkipsPrefixWhenRangeIsIgnored) {
+    server.supports_range = false;
+    server.disconnect_after = {30000, 50000};
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    EXPECT_EQ(server.open_count, 3);
+}
+
+// 重启后从 NVS 中保存的位置继续
+TEST_F(OtaDownloaderTest, ContinuesFromSavedOffset) {
+    offset = 60000;
+    total_size = server.body.size();
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body.substr(60000));
+    EXPECT_EQ(server.range_starts, (std::vector<size_t>{60000}));
+}
+
+// 连续失败时按 1s、2s、4s... 退避，成功读到数据后重新计数
+TEST_F(OtaDownloaderTest, BacksOffBetweenFailures) {
+    server.open_failures = 3;
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    EXPECT_EQ(esp_timer_get_time(), (1000 + 2000 + 4000) * 1000);
+
+    fake_time_reset();
+    received.clear();
+    offset = 0;
+    total_size = 0;
+    server.open_count = 0;
+    server.disconnect_after = {1000, 1000, 1000};
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    EXPECT_EQ(esp_timer_get_time(), 3 * 1000 * 1000);
+}
+
+TEST_F(OtaDownloaderTest, GivesUpAfterTooManyFailures) {
+    server.open_failures = 1000;
+    EXPECT_FALSE(Download());
+    EXPECT_EQ(server.open_count, 11);
+    EXPECT_TRUE(received.empty());
+}
+
+// 服务器上的文件在续传时被替换，已经收到的数据作废
+TEST_F(OtaDownloaderTest, StopsWhenSizeChanges) {
+    offset = 60000;
+    total_size = server.body.size() + 1;
+    bool size_changed = false;
+    downloader.OnSizeChanged([&]() { size_changed = true; });
+    EXPECT_FALSE(Download());
+    EXPECT_TRUE(size_changed);
+    EXPECT_TRUE(received.empty());
+}
+
+// on_data 失败（例如写 flash 出错）时不再重试
+TEST_F(OtaDownloaderTest, StopsWhenConsumerFails) {
+    size_t calls = 0;
+    bool ok = downloader.Download("http://ota/firmware.bin", offset, total_size, [&](const char* data, size_t size) {
+        return ++calls < 3;
+    });
+    EXPECT_FALSE(ok);
+    EXPECT_EQ(calls, 3u);
+    EXPECT_EQ(server.open_count, 1);
+}
+
+// 暂停时断开连接，恢复后用 Range 继续
+TEST_F(OtaDownloaderTest, PausesAndResumes) {
+    int polls = 0;
+    downloader.SetPauseCallback([&]() {
+        polls++;
+        // 第 5 次检查时暂停并断开，重新连接前再检查一次，之后每秒检查一次，共等待 3 秒
+        return polls >= 5 && polls < 10;
+    });
+    ASSERT_TRUE(Download());
+    EXPECT_EQ(received, server.body);
+    ASSERT_EQ(server.range_starts.size(), 2u);
+    EXPECT_GT(server.range_starts[1], 0u);
+    EXPECT_EQ(esp_timer_get_time(), 3 * 1000 * 1000);
+}
+
+TEST_F(OtaDownloaderTest, ReportsProgress) {
+    std::vector<int> progress;
+    downloader.OnProgress([&](int value, size_t speed) { progress.push_back(value); });
+    ASSERT_TRUE(Download());
+    ASSERT_FALSE(progress.empty());
+    EXPECT_EQ(progress.back(), 100);
+}
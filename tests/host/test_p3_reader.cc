@@ -0,0 +1,162 @@
+#include "p3_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 按 v2 格式打包，packets 为每个包的内容，offsets 为空时按包的长度生成偏移表
+static std::string MakeV2(const std::vector<std::string>& packets, int sample_rate = 24000, int channels = 1,
+    int frame_duration_ms = 60, std::vector<uint32_t> offsets = {}) {
+    std::string data;
+    if (offsets.empty()) {
+        uint32_t offset = 0;
+        offsets.push_back(offset);
+        for (auto& packet : packets) {
+            offset += packet.size();
+            offsets.push_back(offset);
+        }
+    }
+    P3v2Header header;
+    memcpy(header.magic, P3_V2_MAGIC, 4);
+    header.version = P3_V2_VERSION;
+    header.channels = channels;
+    header.frame_duration_ms = frame_duration_ms;
+    header.sample_rate = sample_rate;
+    header.packet_count = packets.size();
+    header.data_offset = sizeof(header) + offsets.size() * sizeof(uint32_t);
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    for (auto& packet : packets) {
+        data += packet;
+    }
+    return data;
+}
+
+static std::string MakeV1(const std::vector<std::string>& packets) {
+    std::string data;
+    for (auto& packet : packets) {
+        data += '\0';
+        data += '\0';
+        data += (char)(packet.size() >> 8);
+        data += (char)(packet.size() & 0xFF);
+        data += packet;
+    }
+    return data;
+}
+
+static std::vector<std::string> ReadAll(P3Reader& reader) {
+    std::vector<std::string> packets;
+    const uint8_t* payload;
+    size_t size;
+    while (reader.Next(payload, size)) {
+        packets.emplace_back(reinterpret_cast<const char*>(payload), size);
+    }
+    return packets;
+}
+
+static P3v2Header* HeaderOf(std::string& data) {
+    return reinterpret_cast<P3v2Header*>(data.data());
+}
+
+TEST(P3Reader, ReadsV1) {
+    std::vector<std::string> packets = {"abc", "", std::string(300, 'x')};
+    auto data = MakeV1(packets);
+    P3Reader reader(data);
+    ASSERT_TRUE(reader.IsValid());
+    EXPECT_EQ(reader.version(), 1);
+    EXPECT_EQ(reader.sample_rate(), 16000);
+    EXPECT_EQ(reader.GetPacketCount(), 3u);
+    EXPECT_EQ(reader.GetDurationMs(), 180);
+    EXPECT_EQ(ReadAll(reader), packets);
+    EXPECT_TRUE(reader.IsEnd());
+}
+
+TEST(P3Reader, RejectsTruncatedV1Packet) {
+    auto data = MakeV1({"abc", "defg"});
+    data.pop_back();
+    P3Reader reader(data);
+    ASSERT_TRUE(reader.IsValid());
+    EXPECT_EQ(ReadAll(reader), std::vector<std::string>{"abc"});
+}
+
+TEST(P3Reader, ReadsV2) {
+    std::vector<std::string> packets = {"first", "", "third"};
+    auto data = MakeV2(packets, 48000, 2, 20);
+    P3Reader reader(data);
+    ASSERT_TRUE(reader.IsValid());
+    EXPECT_EQ(reader.version(), 2);
+    EXPECT_EQ(reader.sample_rate(), 48000);
+    EXPECT_EQ(reader.channels(), 2);
+    EXPECT_EQ(reader.frame_duration(), 20);
+    EXPECT_EQ(reader.GetDurationMs(), 60);
+    EXPECT_EQ(ReadAll(reader), packets);
+
+    ASSERT_TRUE(reader.Seek(2));
+    EXPECT_EQ(ReadAll(reader), std::vector<std::string>{"third"});
+    EXPECT_FALSE(reader.Seek(4));
+}
+
+// payload 直接指向原始数据，不做拷贝
+TEST(P3Reader, PayloadPointsIntoSource) {
+    auto data = MakeV2({"abc"});
+    P3Reader reader(data);
+    const uint8_t* payload;
+    size_t size;
+    ASSERT_TRUE(reader.Next(payload, size));
+    EXPECT_GE(reinterpret_cast<const char*>(payload), data.data());
+    EXPECT_LE(reinterpret_cast<const char*>(payload) + size, data.data() + data.size());
+}
+
+TEST(P3Reader, RejectsNonMonotonicOffsets) {
+    auto data = MakeV2({"ab", "cd", "ef"}, 24000, 1, 60, {0, 4, 2, 6});
+    P3Reader reader(data);
+    EXPECT_FALSE(reader.IsValid());
+}
+
+TEST(P3Reader, RejectsOffsetsPastData) {
+    auto data = MakeV2({"ab", "cd"}, 24000, 1, 60, {0, 2, 5});
+    P3Reader reader(data);
+    EXPECT_FALSE(reader.IsValid());
+}
+
+TEST(P3Reader, RejectsUnsupportedFormat) {
+    EXPECT_FALSE(P3Reader(MakeV2({"ab"}, 24000, 0, 60)).IsValid());
+    EXPECT_FALSE(P3Reader(MakeV2({"ab"}, 24000, 1, 0)).IsValid());
+    EXPECT_FALSE(P3Reader(MakeV2({"ab"}, 24000, 1, 240)).IsValid());
+    EXPECT_FALSE(P3Reader(MakeV2({"ab"}, 0, 1, 60)).IsValid());
+    EXPECT_FALSE(P3Reader(MakeV2({"ab"}, 44100, 1, 60)).IsValid());
+    for (int sample_rate : {8000, 12000, 16000, 24000, 48000}) {
+        EXPECT_TRUE(P3Reader(MakeV2({"ab"}, sample_rate, 1, 60)).IsValid()) << sample_rate;
+    }
+}
+
+TEST(P3Reader, RejectsBadHeader) {
+    auto data = MakeV2({"ab", "cd"});
+
+    auto bad_version = data;
+    HeaderOf(bad_version)->version = 3;
+    EXPECT_FALSE(P3Reader(bad_version).IsValid());
+
+    // 包数很大时偏移表的大小不能溢出
+    auto huge_count = data;
+    HeaderOf(huge_count)->packet_count = 0xFFFFFFFF;
+    EXPECT_FALSE(P3Reader(huge_count).IsValid());
+
+    auto bad_data_offset = data;
+    HeaderOf(bad_data_offset)->data_offset = sizeof(P3v2Header);
+    EXPECT_FALSE(P3Reader(bad_data_offset).IsValid());
+
+    EXPECT_FALSE(P3Reader(std::string_view(data).substr(0, data.size() - 1)).IsValid());
+    EXPECT_FALSE(P3Reader(std::string_view(data).substr(0, sizeof(P3v2Header) + 4)).IsValid());
+}
+
+TEST(P3Reader, EmptyData) {
+    P3Reader reader{std::string_view()};
+    EXPECT_FALSE(reader.IsValid());
+    const uint8_t* payload;
+    size_t size;
+    EXPECT_FALSE(reader.Next(payload, size));
+}
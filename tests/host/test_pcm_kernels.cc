@@ -0,0 +1,173 @@
+#include "pcm_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// 与 pcm_kernels 的实现无关的参考实现，逐个采样按定义计算
+static int16_t Clamp16(int64_t value) {
+    return (int16_t)std::min<int64_t>(INT16_MAX, std::max<int64_t>(INT16_MIN, value));
+}
+
+static std::vector<int16_t> RandomPcm(size_t samples, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<int16_t> pcm(samples);
+    for (auto& sample : pcm) {
+        sample = (int16_t)(random() & 0xFFFF);
+    }
+    // 包含边界值
+    if (samples >= 2) {
+        pcm[0] = INT16_MIN;
+        pcm[1] = INT16_MAX;
+    }
+    return pcm;
+}
+
+// 覆盖 SIMD 块的整数倍、不足一块的尾部以及不对齐的起始地址
+static const size_t kSizes[] = {0, 1, 7, 8, 9, 31, 64, 960, 1001};
+static const size_t kOffsets[] = {0, 1, 3, 8};
+
+TEST(PcmKernels, VolumeToGainQ16) {
+    EXPECT_EQ(pcm::VolumeToGainQ16(-5), 0);
+    EXPECT_EQ(pcm::VolumeToGainQ16(0), 0);
+    EXPECT_EQ(pcm::VolumeToGainQ16(50), 16384);
+    EXPECT_EQ(pcm::VolumeToGainQ16(100), 65536);
+    EXPECT_EQ(pcm::VolumeToGainQ16(150), 65536);
+}
+
+TEST(PcmKernels, ApplyGainQ15) {
+    const int32_t gains[] = {0, 8192, 32767, 32768, 49152, 65535};
+    for (auto gain : gains) {
+        for (auto size : kSizes) {
+            for (auto offset : kOffsets) {
+                auto input = RandomPcm(size + offset, size);
+                auto data = input;
+                pcm::ApplyGainQ15(data.data() + offset, size, gain);
+                for (size_t i = 0; i < offset; i++) {
+                    ASSERT_EQ(data[i], input[i]);
+                }
+                for (size_t i = offset; i < size + offset; i++) {
+                    ASSERT_EQ(data[i], Clamp16(((int64_t)input[i] * gain) >> 15)) << "gain " << gain << " i " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(PcmKernels, Int16ToInt32) {
+    const int32_t gains[] = {0, 1, 16384, 65535, 65536};
+    for (auto gain : gains) {
+        for (auto size : kSizes) {
+            for (auto offset : kOffsets) {
+                auto input = RandomPcm(size + offset, size + 1);
+                std::vector<int32_t> mono(size + 1, 0x5A5A5A5A);
+                std::vector<int32_t> stereo(size * 2 + 1, 0x5A5A5A5A);
+                pcm::Int16ToInt32(input.data() + offset, mono.data(), size, gain);
+                pcm::Int16ToInt32Stereo(input.data() + offset, stereo.data(), size, gain);
+                for (size_t i = 0; i < size; i++) {
+                    int32_t expected = input[offset + i] * gain;
+                    ASSERT_EQ(mono[i], expected);
+                    ASSERT_EQ(stereo[i * 2], expected);
+                    ASSERT_EQ(stereo[i * 2 + 1], expected);
+                }
+                // 不能写出范围
+                ASSERT_EQ(mono[size], 0x5A5A5A5A);
+                ASSERT_EQ(stereo[size * 2], 0x5A5A5A5A);
+            }
+        }
+    }
+}
+
+TEST(PcmKernels, Int32ToInt16) {
+    std::mt19937 random(7);
+    for (int shift : {0, 12, 16}) {
+        for (auto size : kSizes) {
+            std::vector<int32_t> input(size);
+            for (auto& value : input) {
+                value = (int32_t)random();
+            }
+            std::vector<int16_t> output(size + 1, 0x5A5A);
+            pcm::Int32ToInt16(input.data(), output.data(), size, shift);
+            for (size_t i = 0; i < size; i++) {
+                ASSERT_EQ(output[i], Clamp16(input[i] >> shift)) << "shift " << shift << " i " << i;
+            }
+            ASSERT_EQ(output[size], 0x5A5A);
+        }
+    }
+}
+
+TEST(PcmKernels, DeinterleaveInterleaveRoundTrip) {
+    for (auto frames : kSizes) {
+        for (auto offset : kOffsets) {
+            auto input = RandomPcm(frames * 2 + offset, frames);
+            std::vector<int16_t> left(frames + offset), right(frames + offset);
+            pcm::Deinterleave(input.data() + offset, left.data() + offset, right.data() + offset, frames);
+            for (size_t i = 0; i < frames; i++) {
+                ASSERT_EQ(left[offset + i], input[offset + i * 2]);
+                ASSERT_EQ(right[offset + i], input[offset + i * 2 + 1]);
+            }
+
+            std::vector<int16_t> output(frames * 2 + offset);
+            pcm::Interleave(left.data() + offset, right.data() + offset, output.data() + offset, frames);
+            ASSERT_TRUE(std::equal(output.begin() + offset, output.end(), input.begin() + offset));
+        }
+    }
+}
+
+TEST(PcmKernels, MonoToStereo) {
+    for (auto size : kSizes) {
+        for (auto offset : kOffsets) {
+            auto input = RandomPcm(size + offset, size);
+            std::vector<int16_t> output(size * 2);
+            pcm::MonoToStereo(input.data() + offset, output.data(), size);
+            for (size_t i = 0; i < size; i++) {
+                ASSERT_EQ(output[i * 2], input[offset + i]);
+                ASSERT_EQ(output[i * 2 + 1], input[offset + i]);
+            }
+        }
+    }
+}
+
+TEST(PcmKernels, AlignedVectorIsAligned) {
+    for (size_t size : {1, 3, 17, 960}) {
+        pcm::AlignedVector<int16_t> buffer(size);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) & 15, 0u);
+        buffer.resize(size * 4);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) & 15, 0u);
+    }
+}
+
+// 只统计第一个声道，-32768 的峰值为 32768
+TEST(PcmKernels, SumSquaresAndPeak) {
+    for (int channels : {1, 2}) {
+        for (auto size : kSizes) {
+            for (auto offset : kOffsets) {
+                auto input = RandomPcm(size * channels + offset, size);
+                uint64_t expected_sum = 0;
+                int32_t expected_peak = 0;
+                for (size_t i = 0; i < size; i++) {
+                    int32_t value = input[offset + i * channels];
+                    expected_sum += (int64_t)value * value;
+                    expected_peak = std::max(expected_peak, std::abs(value));
+                }
+
+                uint64_t sum = 1;
+                int32_t peak = -1;
+                ASSERT_EQ(pcm::SumSquaresAndPeak(input.data() + offset, size * channels, channels, &sum, &peak), size);
+                ASSERT_EQ(sum, expected_sum) << channels << " " << size << " " << offset;
+                ASSERT_EQ(peak, expected_peak) << channels << " " << size << " " << offset;
+            }
+        }
+    }
+
+    // 满幅信号超过 PIE 单次累加的块数，平方和仍然准确
+    std::vector<int16_t> full(4096, INT16_MIN);
+    uint64_t sum;
+    int32_t peak;
+    ASSERT_EQ(pcm::SumSquaresAndPeak(full.data(), full.size(), 1, &sum, &peak), full.size());
+    EXPECT_EQ(sum, 4096ull * 32768 * 32768);
+    EXPECT_EQ(peak, 32768);
+}
@@ -0,0 +1,159 @@
+#include "polyphase_resampler.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+// 跳过滤波器启动阶段的输出
+#define WARMUP_MS 20
+
+static std::vector<int16_t> MakeTone(int sample_rate, double frequency, double amplitude, int ms) {
+    std::vector<int16_t> tone(sample_rate * ms / 1000);
+    for (size_t i = 0; i < tone.size(); i++) {
+        tone[i] = (int16_t)std::lround(amplitude * 32767 * std::sin(2 * M_PI * frequency * i / sample_rate));
+    }
+    return tone;
+}
+
+// 按 20ms 一块处理，和实际使用时一样跨块保持状态
+static std::vector<int16_t> Resample(PolyphaseResampler& resampler, const std::vector<int16_t>& input) {
+    std::vector<int16_t> output;
+    int chunk = resampler.input_sample_rate() / 50;
+    for (size_t offset = 0; offset < input.size(); offset += chunk) {
+        int samples = std::min<int>(chunk, input.size() - offset);
+        size_t old_size = output.size();
+        output.resize(old_size + resampler.GetOutputSamples(samples));
+        int count = resampler.Process(input.data() + offset, samples, output.data() + old_size);
+        EXPECT_EQ((size_t)count, output.size() - old_size);
+    }
+    return output;
+}
+
+// 在已知频率上做最小二乘拟合，拟合部分为信号，残差为噪声和失真，与滤波器的延迟无关
+static double MeasureSnrDb(const std::vector<int16_t>& signal, int sample_rate, double frequency) {
+    size_t start = sample_rate * WARMUP_MS / 1000;
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for (size_t i = start; i < signal.size(); i++) {
+        double w = 2 * M_PI * frequency * i / sample_rate;
+        double s = std::sin(w), c = std::cos(w);
+        ss += s * s; sc += s * c; cc += c * c;
+        ys += signal[i] * s; yc += signal[i] * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+
+    double signal_power = 0, noise_power = 0;
+    for (size_t i = start; i < signal.size(); i++) {
+        double w = 2 * M_PI * frequency * i / sample_rate;
+        double fit = a * std::sin(w) + b * std::cos(w);
+        signal_power += fit * fit;
+        noise_power += (signal[i] - fit) * (signal[i] - fit);
+    }
+    return 10 * std::log10(signal_power / std::max(noise_power, 1e-9));
+}
+
+static double RmsOf(const std::vector<int16_t>& signal, size_t start) {
+    double sum = 0;
+    for (size_t i = start; i < signal.size(); i++) {
+        sum += (double)signal[i] * signal[i];
+    }
+    return std::sqrt(sum / (signal.size() - start));
+}
+
+struct RatePair {
+    int input;
+    int output;
+};
+
+class PolyphaseResamplerQuality : public ::testing::TestWithParam<RatePair> {};
+
+TEST_P(PolyphaseResamplerQuality, ToneSnr) {
+    auto rates = GetParam();
+    PolyphaseResampler resampler;
+    ASSERT_TRUE(resampler.Configure(rates.input, rates.output));
+
+    // 1kHz 正弦，-6dBFS
+    auto input = MakeTone(rates.input, 1000, 0.5, 500);
+    auto output = Resample(resampler, input);
+    EXPECT_NEAR((double)output.size(), input.size() * (double)rates.output / rates.input, 1.0);
+
+    double snr = MeasureSnrDb(output, rates.output, 1000);
+    RecordProperty("snr_db", std::to_string(snr));
+    EXPECT_GT(snr, 70.0) << rates.input << " -> " << rates.output;
+}
+
+TEST_P(PolyphaseResamplerQuality, PassbandGain) {
+    auto rates = GetParam();
+    PolyphaseResampler resampler;
+    ASSERT_TRUE(resampler.Configure(rates.input, rates.output));
+
+    // 语音频带上限处的幅度误差不超过 0.5dB
+    // PASSBAND_RATIO 是截止频率（约 -6dB）的位置，再往上滤波器已经开始衰减
+    double frequency = 3400;
+    auto input = MakeTone(rates.input, frequency, 0.5, 500);
+    auto output = Resample(resampler, input);
+    double gain_db = 20 * std::log10(RmsOf(output, rates.output * WARMUP_MS / 1000) /
+        RmsOf(input, rates.input * WARMUP_MS / 1000));
+    EXPECT_NEAR(gain_db, 0.0, 0.5) << frequency << "Hz";
+}
+
+TEST_P(PolyphaseResamplerQuality, DcGainIsExact) {
+    auto rates = GetParam();
+    PolyphaseResampler resampler;
+    ASSERT_TRUE(resampler.Configure(rates.input, rates.output));
+
+    std::vector<int16_t> input(rates.input / 10, 10000);
+    auto output = Resample(resampler, input);
+    for (size_t i = rates.output * WARMUP_MS / 1000; i < output.size(); i++) {
+        ASSERT_NEAR(output[i], 10000, 1) << "sample " << i;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Rates, PolyphaseResamplerQuality, ::testing::Values(
+    RatePair{16000, 24000}, RatePair{16000, 44100}, RatePair{16000, 48000},
+    RatePair{24000, 16000}, RatePair{44100, 16000}, RatePair{48000, 16000}));
+
+// 降采样时高于目标奈奎斯特频率的信号必须被滤除，不能混叠回通带
+TEST(PolyphaseResampler, AliasRejection) {
+    const int rates[] = {24000, 44100, 48000};
+    for (int rate : rates) {
+        PolyphaseResampler resampler;
+        ASSERT_TRUE(resampler.Configure(rate, 16000));
+        double frequency = std::min(10000.0, rate / 2.0 - 1000);
+        auto input = MakeTone(rate, frequency, 0.9, 500);
+        auto output = Resample(resampler, input);
+        double rejection_db = 20 * std::log10(RmsOf(input, 0) / std::max(RmsOf(output, 16000 * WARMUP_MS / 1000), 1e-3));
+        EXPECT_GT(rejection_db, 60.0) << rate << "Hz, " << frequency << "Hz tone";
+    }
+}
+
+TEST(PolyphaseResampler, ChunkingDoesNotChangeOutput) {
+    auto input = MakeTone(48000, 440, 0.7, 200);
+    PolyphaseResampler whole, chunked;
+    ASSERT_TRUE(whole.Configure(48000, 16000));
+    ASSERT_TRUE(chunked.Configure(48000, 16000));
+
+    std::vector<int16_t> expected(whole.GetOutputSamples(input.size()));
+    expected.resize(whole.Process(input.data(), input.size(), expected.data()));
+
+    std::vector<int16_t> output;
+    size_t offset = 0;
+    // 不规则的块大小
+    for (int i = 0; offset < input.size(); i++) {
+        int samples = std::min<int>(1 + (i * 37) % 701, input.size() - offset);
+        size_t old_size = output.size();
+        output.resize(old_size + chunked.GetOutputSamples(samples));
+        output.resize(old_size + chunked.Process(input.data() + offset, samples, output.data() + old_size));
+        offset += samples;
+    }
+    EXPECT_EQ(output, expected);
+}
+
+TEST(PolyphaseResampler, UnsupportedRates) {
+    PolyphaseResampler resampler;
+    EXPECT_FALSE(resampler.Configure(24000, 48000));
+    EXPECT_FALSE(resampler.Configure(16000, 16000));
+    EXPECT_FALSE(resampler.Configure(8000, 16000));
+}
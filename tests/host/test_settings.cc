@@ -0,0 +1,116 @@
+#include "settings.h"
+#include "fake_esp.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// 定时器到期后由 settings_flush 线程写入，等待它完成
+static bool WaitFor(std::function<bool()> condition) {
+    for (int i = 0; i < 2000; i++) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return condition();
+}
+
+class SettingsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // SettingsStore 是单例，写入上一个测试留下的修改之后再清空模拟的 NVS
+        Settings::Flush();
+        fake_time_reset();
+        fake_nvs_reset();
+        // 设备上 esp_timer 的时间不会是 0，SettingsStore 用 0 表示没有未写入的修改
+        fake_time_advance(1000 * 1000);
+    }
+};
+
+// 拖动音量时连续修改，停止修改一秒后只写一次最终的值
+TEST_F(SettingsTest, CoalescesRapidWrites) {
+    Settings settings("coalesce", true);
+    for (int i = 0; i < 20; i++) {
+        settings.SetInt("volume", i);
+        fake_time_advance(100 * 1000);
+    }
+    EXPECT_EQ(fake_nvs_stats().commit_count, 0);
+
+    fake_time_advance(1000 * 1000);
+    ASSERT_TRUE(WaitFor([]() { return fake_nvs_stats().commit_count == 1; }));
+    EXPECT_EQ(fake_nvs_stats().set_count, 1);
+    int32_t value = 0;
+    ASSERT_TRUE(fake_nvs_get_committed("coalesce", "volume", value));
+    EXPECT_EQ(value, 19);
+}
+
+// 一直有修改时最多推迟 5 秒
+TEST_F(SettingsTest, FlushesWithinMaxDelay) {
+    Settings settings("max_delay", true);
+    for (int i = 0; i < 9; i++) {
+        settings.SetInt("brightness", i);
+        fake_time_advance(500 * 1000);
+    }
+    EXPECT_EQ(fake_nvs_stats().commit_count, 0);
+
+    settings.SetInt("brightness", 9);
+    fake_time_advance(500 * 1000);
+    ASSERT_TRUE(WaitFor([]() { return fake_nvs_stats().commit_count == 1; }));
+    int32_t value = 0;
+    ASSERT_TRUE(fake_nvs_get_committed("max_delay", "brightness", value));
+    EXPECT_EQ(value, 9);
+}
+
+// 写入相同的值不算修改
+TEST_F(SettingsTest, IgnoresUnchangedValues) {
+    Settings settings("unchanged", true);
+    settings.SetString("name", "xiaozhi");
+    Settings::Flush();
+    EXPECT_EQ(fake_nvs_stats().set_count, 1);
+
+    settings.SetString("name", "xiaozhi");
+    Settings::Flush();
+    EXPECT_EQ(fake_nvs_stats().set_count, 1);
+    EXPECT_EQ(fake_nvs_stats().commit_count, 1);
+}
+
+// 写入之前读取的是内存中的新值
+TEST_F(SettingsTest, ReadsPendingValues) {
+    Settings settings("pending", true);
+    settings.SetString("url", "wss://example.com");
+    settings.SetInt("port", 443);
+    EXPECT_EQ(settings.GetString("url"), "wss://example.com");
+    EXPECT_EQ(settings.GetInt("port"), 443);
+    EXPECT_EQ(fake_nvs_stats().set_count, 0);
+
+    Settings reader("pending");
+    EXPECT_EQ(reader.GetInt("port"), 443);
+}
+
+// 写入失败的修改保留在内存中，下次 Flush 时重试
+TEST_F(SettingsTest, KeepsDirtyValuesWhenWriteFails) {
+    Settings settings("retry", true);
+    settings.SetInt("count", 7);
+    fake_nvs_set_fail_writes(true);
+    Settings::Flush();
+    int32_t value = 0;
+    EXPECT_FALSE(fake_nvs_get_committed("retry", "count", value));
+
+    fake_nvs_set_fail_writes(false);
+    Settings::Flush();
+    ASSERT_TRUE(fake_nvs_get_committed("retry", "count", value));
+    EXPECT_EQ(value, 7);
+}
+
+// esp_restart 调用关机回调，写入所有修改
+TEST_F(SettingsTest, FlushesOnShutdown) {
+    Settings settings("shutdown", true);
+    settings.SetString("token", "abc");
+    fake_run_shutdown_handlers();
+    std::string value;
+    ASSERT_TRUE(fake_nvs_get_committed("shutdown", "token", value));
+    EXPECT_EQ(value, "abc");
+}